@@ -8,8 +8,10 @@ and extract comprehensive loop information for High-Performance Computing (HPC)
 
 import argparse
 import sys
+import time
 import logging
 import json
+import shlex
 from pathlib import Path
 from datetime import datetime
 
@@ -17,7 +19,31 @@ from src.config import Config
 from src.file_discovery import FileDiscovery
 from src.ast_parser import ASTParser
 from src.loop_analyzer import LoopAnalyzer
+from src.file_supervisor import SupervisedFileAnalyzer
+from src.work_scheduler import WorkScheduler
+from src.parallel_runner import ParallelFileAnalyzer
+from src.analysis_passes import PASS_REGISTRY, resolve_passes
+from src.run_metrics import RunMetrics
 from src.json_output import JSONOutput
+from src.profile_ingest import ProfileIngest
+from src.coverage_ingest import CoverageIngest
+from src.opt_remarks import OptRemarksIngest
+from src.llvm_backend import LLVMBackend
+from src.instrumentation import LoopInstrumenter, LoopCountsIngest
+from src.kernel_extractor import KernelExtractor
+from src.openmp_rewriter import OpenMPRewriter
+from src.flamegraph_export import FlameGraphExporter
+from src.callgraph_export import CallGraphExporter
+from src.perf_findings import PerformanceLinter, LoopFindingDetector
+from src.sarif_export import SarifExporter
+from src.corpus_generator import CorpusGenerator, CorpusParameters
+from src.benchmark import BenchmarkHarness
+from src.golden_check import GoldenCheck
+from src.shard_merge import ShardMerger
+from src.watch_mode import WatchSession
+from src.query_server import QueryServer, UnixQueryServer, query as query_socket
+from src.analysis_diff import AnalysisDiff
+from src.history_trend import HistoryTrend
 
 
 def setup_logging(log_level: str = "INFO") -> None:
@@ -42,6 +68,7 @@ Examples:
   %(prog)s src/                              # Analyze all files in src/
   %(prog)s src/ -o results.json              # Save results to specific file  
   %(prog)s --resume-from-checkpoint file.checkpoint.json  # Resume from checkpoint
+  %(prog)s src/ --shard 2/4 -o shard2.json   # Analyze the second of four shards
         """
     )
     
@@ -62,21 +89,1512 @@ Examples:
     parser.add_argument(
         '--include',
         action='append',
-        help='Include pattern for files (can be specified multiple times)'
+        help="Include pattern for files: substring, glob relative to the path ('src/**/*.cpp') "
+             "or 're:REGEX' (can be specified multiple times)"
     )
     
     parser.add_argument(
         '--exclude',
         action='append',
-        help='Exclude pattern for files (can be specified multiple times)'
+        help='Exclude pattern for files or directories, same forms as --include (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--discovery',
+        type=str,
+        default='walk',
+        choices=['walk', 'git'],
+        help="How to find source files: walk the directory tree, or list them with 'git ls-files', "
+             "which honours .gitignore (default: walk)"
+    )
+    
+    parser.add_argument(
+        '--cpp-standard',
+        type=str,
+        default='c++17',
+        choices=['c++11', 'c++14', 'c++17', 'c++20'],
+        help='C++ standard to use for parsing (default: c++17)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    parser.add_argument(
+        '--verbose',
+        action='store_true',
+        help='Enable verbose output'
+    )
+    
+    parser.add_argument(
+        '--checkpoint-frequency',
+        type=int,
+        default=50,
+        help='Save checkpoint every N files (default: 50)'
+    )
+    
+    parser.add_argument(
+        '--resume-from-checkpoint',
+        type=str,
+        help='Resume analysis from a checkpoint file'
+    )
+    
+    parser.add_argument(
+        '--llvm-backend',
+        action='store_true',
+        help='Cross-validate loops with LLVM IR analysis (loop info, ScalarEvolution, vectorizer)'
+    )
+    
+    parser.add_argument(
+        '--clang',
+        type=str,
+        default='clang',
+        help='clang executable used by --llvm-backend (default: clang)'
+    )
+    
+    parser.add_argument(
+        '--opt',
+        type=str,
+        default='opt',
+        help='opt executable used by --llvm-backend (default: opt)'
+    )
+    
+    parser.add_argument(
+        '--passes',
+        type=str,
+        help=f"Comma-separated analysis passes to run, or 'all' "
+             f"(default: {','.join(resolve_passes())}; see --list-passes)"
+    )
+    
+    parser.add_argument(
+        '--list-passes',
+        action='store_true',
+        help='List the available analysis passes and exit'
+    )
+    
+    parser.add_argument(
+        '-j', '--jobs',
+        type=int,
+        default=1,
+        help='Number of worker processes; files are scheduled largest-first (default: 1)'
+    )
+    
+    parser.add_argument(
+        '--schedule-from',
+        type=str,
+        metavar='PATH',
+        help='Timings of a previous run (--timings-csv file or analysis JSON) used to order files for --jobs'
+             ' and balance --shard'
+    )
+    
+    parser.add_argument(
+        '--shard',
+        type=parse_shard,
+        metavar='K/N',
+        help='Analyze only shard K of N of the discovered files, balanced by estimated cost; '
+             'combine the shard outputs with the merge subcommand'
+    )
+    
+    parser.add_argument(
+        '--index-recycle-files',
+        type=int,
+        default=200,
+        metavar='N',
+        help='Recreate the clang index every N files to bound memory (default: 200, 0 disables)'
+    )
+    
+    parser.add_argument(
+        '--index-recycle-rss',
+        type=int,
+        default=0,
+        metavar='MB',
+        help='Also recreate the clang index when resident memory exceeds MB (default: 0, disabled)'
+    )
+    
+    parser.add_argument(
+        '--file-timeout',
+        type=float,
+        default=0.0,
+        help='Per-file parse and analysis time limit in seconds; files run in a killable '
+             'child process and are recorded as timed_out (default: 0, no limit)'
+    )
+    
+    parser.add_argument(
+        '--file-memory-limit',
+        type=int,
+        default=0,
+        metavar='MB',
+        help='Per-file address space limit in MB for the child process; files exceeding it '
+             'are recorded as oom (default: 0, no limit)'
+    )
+    
+    parser.add_argument(
+        '--timings-csv',
+        type=str,
+        help='Also write per-file timings (parse, diagnostics, traversal, passes) to this CSV file'
+    )
+    
+    parser.add_argument(
+        '--slowest',
+        type=int,
+        default=10,
+        help='Number of slowest files listed in metadata.performance (default: 10)'
+    )
+    
+    return parser
+
+
+def config_from_analysis(analysis_data: dict, output_path: Path, log_level: str) -> Config:
+    """Rebuild a configuration for post-processing an existing analysis file."""
+    metadata = analysis_data.get('metadata', {})
+    cpp_standard = 'c++17'
+    for flag in metadata.get('compiler_flags', []):
+        if flag.startswith('-std='):
+            cpp_standard = flag[len('-std='):]
+    
+    return Config(
+        source_path=Path(metadata.get('scan_path', '.')),
+        output_path=output_path,
+        include_patterns=[],
+        exclude_patterns=[],
+        cpp_standard=cpp_standard,
+        log_level=log_level
+    )
+
+
+def order_results(analysis_results: dict, discovery_order: dict) -> dict:
+    """Source file entries in discovery order, as a sequential run lists them; resumed files stay first."""
+    return dict(sorted(analysis_results.items(), key=lambda item: discovery_order.get(item[0], -1)))
+
+
+def load_analysis(analysis_path: str, output_path: Path, log_level: str):
+    """Load an existing analysis file; returns (config, json_output, analysis_data)."""
+    with open(analysis_path, 'r', encoding='utf-8') as f:
+        analysis_data = json.load(f)
+    
+    config = config_from_analysis(analysis_data, output_path, log_level)
+    json_output = JSONOutput(config)
+    if not json_output.validate_output(analysis_data):
+        logging.getLogger(__name__).warning(f"Analysis file {analysis_path} does not match the expected structure")
+    
+    return config, json_output, analysis_data
+
+
+def create_annotate_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the annotate subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py annotate',
+        description='Join measured data onto the loops of an existing analysis',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s results.json --profile perf.txt          # perf script -F +srcline output
+  %(prog)s results.json --profile callgrind.out.123 -o hot.json
+  %(prog)s results.json --coverage app.gcov.json.gz  # gcov --json-format
+  %(prog)s results.json --profile perf.txt --remarks build/foo.opt.yaml --remarks-report missed.md
+  %(prog)s results.json --loop-counts loopx_counts.4242.tsv  # from an instrumented build
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '--profile',
+        type=str,
+        help='Profiler output to ingest (perf script text, gprof -l report, or callgrind .out)'
+    )
+    
+    parser.add_argument(
+        '--profile-format',
+        type=str,
+        default='auto',
+        choices=['auto'] + list(ProfileIngest.FORMATS),
+        help='Format of the profile file (default: auto)'
+    )
+    
+    parser.add_argument(
+        '--coverage',
+        action='append',
+        help='gcov JSON or llvm-cov export file for measured trip counts (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--loop-counts',
+        action='append',
+        help='Counter dump written by an instrumented build (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--remarks',
+        action='append',
+        help='Clang optimization record YAML or GCC -fopt-info output (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--remarks-format',
+        type=str,
+        default='auto',
+        choices=['auto'] + list(OptRemarksIngest.FORMATS),
+        help='Format of the remarks files (default: auto)'
+    )
+    
+    parser.add_argument(
+        '--remarks-report',
+        type=str,
+        help='Write a markdown report of hot loops the compiler failed to vectorize'
+    )
+    
+    parser.add_argument(
+        '--report-top',
+        type=int,
+        default=50,
+        help='Number of loops listed in the remarks report (default: 50)'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        help='Output JSON file path (default: overwrite the input analysis)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def annotate_main(argv: list) -> int:
+    """Entry point for the annotate subcommand."""
+    parser = create_annotate_parser()
+    args = parser.parse_args(argv)
+    
+    if not (args.profile or args.coverage or args.loop_counts or args.remarks):
+        parser.error("at least one data source (--profile, --coverage, --loop-counts, --remarks) is required")
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        output_path = Path(args.output or args.analysis)
+        config, json_output, analysis_data = load_analysis(args.analysis, output_path, args.log_level)
+        
+        if args.profile:
+            profile_path = Path(args.profile)
+            if not profile_path.exists():
+                logger.error(f"Profile file does not exist: {args.profile}")
+                return 1
+            
+            profile_ingest = ProfileIngest()
+            profile = profile_ingest.parse(profile_path, args.profile_format)
+            summary = profile_ingest.annotate(analysis_data['source_files'], profile)
+            summary['profile_file'] = str(profile_path)
+            analysis_data.setdefault('extensions', {})['profile'] = summary
+        
+        if args.coverage:
+            coverage_ingest = CoverageIngest()
+            for coverage_file in args.coverage:
+                coverage_path = Path(coverage_file)
+                if not coverage_path.exists():
+                    logger.error(f"Coverage file does not exist: {coverage_file}")
+                    return 1
+                coverage_ingest.load(coverage_path)
+            
+            summary = coverage_ingest.annotate(analysis_data['source_files'])
+            summary['coverage_files'] = args.coverage
+            analysis_data.setdefault('extensions', {})['coverage'] = summary
+        
+        if args.loop_counts:
+            counts_ingest = LoopCountsIngest()
+            for counts_file in args.loop_counts:
+                counts_path = Path(counts_file)
+                if not counts_path.exists():
+                    logger.error(f"Loop counts file does not exist: {counts_file}")
+                    return 1
+                counts_ingest.load(counts_path)
+            
+            summary = counts_ingest.annotate(analysis_data['source_files'])
+            summary['count_files'] = args.loop_counts
+            analysis_data.setdefault('extensions', {})['instrumentation'] = summary
+        
+        if args.remarks:
+            remarks_ingest = OptRemarksIngest()
+            for remarks_file in args.remarks:
+                remarks_path = Path(remarks_file)
+                if not remarks_path.exists():
+                    logger.error(f"Remarks file does not exist: {remarks_file}")
+                    return 1
+                remarks_ingest.load(remarks_path, args.remarks_format)
+            
+            summary = remarks_ingest.annotate(analysis_data['source_files'])
+            missed_loops = remarks_ingest.missed_hot_loops(analysis_data['source_files'], args.report_top)
+            summary['missed_hot_loops'] = missed_loops
+            analysis_data.setdefault('extensions', {})['compiler_remarks'] = summary
+            
+            if args.remarks_report:
+                remarks_ingest.write_report(missed_loops, args.remarks_report)
+        
+        json_output.write_output(analysis_data, str(output_path))
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Annotation failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_instrument_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the instrument subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py instrument',
+        description='Write an instrumented copy of the analyzed source tree with per-loop counters',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s results.json --output-dir instrumented/
+  %(prog)s results.json --output-dir instrumented/ --cycles
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '--output-dir',
+        type=str,
+        required=True,
+        help='Directory receiving the instrumented copy (must be outside the source tree)'
+    )
+    
+    parser.add_argument(
+        '--cycles',
+        action='store_true',
+        help='Also accumulate rdtsc cycles per loop'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def instrument_main(argv: list) -> int:
+    """Entry point for the instrument subcommand."""
+    args = create_instrument_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        config, _, analysis_data = load_analysis(args.analysis, Path(args.output_dir), args.log_level)
+        if not config.source_path.is_dir():
+            logger.error(f"Source path from analysis does not exist: {config.source_path}")
+            return 1
+        
+        instrumenter = LoopInstrumenter(config, cycles=args.cycles)
+        summary = instrumenter.instrument_tree(analysis_data['source_files'], Path(args.output_dir))
+        
+        logger.info(f"Instrumented tree written to: {summary['output_dir']}")
+        logger.info(f"Ingest counts with: annotate {args.analysis} --loop-counts loopx_counts.<pid>.tsv")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Instrumentation failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_extract_kernel_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the extract-kernel subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py extract-kernel',
+        description='Outline one loop nest into a standalone C++ micro-benchmark',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s results.json --loop-id loop_718f22a653cbd399 -o multiply_bench.cpp
+  %(prog)s results.json --loop-id loop_718f22a653cbd399 --file matrix.cpp --size rows=512 --size cols=512
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '--loop-id',
+        type=str,
+        required=True,
+        help='loop_id of the loop nest to extract'
+    )
+    
+    parser.add_argument(
+        '--file',
+        type=str,
+        help='Source file containing the loop (needed when the loop_id is not unique)'
+    )
+    
+    parser.add_argument(
+        '--size',
+        action='append',
+        default=[],
+        help='Value for an integer input, as name=value (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--default-size',
+        type=int,
+        default=256,
+        help='Value for integer inputs and container dimensions without --size (default: 256)'
+    )
+    
+    parser.add_argument(
+        '--repetitions',
+        type=int,
+        default=100,
+        help='Default number of timed kernel calls (default: 100)'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        help='Output C++ file (default: <loop_id>_bench.cpp)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def extract_kernel_main(argv: list) -> int:
+    """Entry point for the extract-kernel subcommand."""
+    parser = create_extract_kernel_parser()
+    args = parser.parse_args(argv)
+    
+    sizes = {}
+    for size in args.size:
+        name, _, value = size.partition('=')
+        if not name or not value.isdigit():
+            parser.error(f"invalid --size '{size}', expected name=value")
+        sizes[name] = int(value)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        output_path = Path(args.output or f"{args.loop_id}_bench.cpp")
+        config, _, analysis_data = load_analysis(args.analysis, output_path, args.log_level)
+        
+        extractor = KernelExtractor(config)
+        file_path, function_name, loop = extractor.find_loop(analysis_data['source_files'], args.loop_id, args.file)
+        benchmark = extractor.extract(file_path, function_name, loop, sizes, args.default_size, args.repetitions)
+        
+        output_path.parent.mkdir(parents=True, exist_ok=True)
+        output_path.write_text(benchmark, encoding='utf-8')
+        
+        for warning in extractor.warnings:
+            logger.warning(f"Manual step needed: {warning}")
+        logger.info(f"Benchmark for {function_name} {args.loop_id} written to: {output_path}")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Kernel extraction failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_openmp_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the openmp subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py openmp',
+        description='Propose OpenMP pragmas for loops with independent iterations',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s results.json --patch openmp.patch        # review, then: patch -p1 < openmp.patch
+  %(prog)s results.json --loop-id loop_718f22a653cbd399 --output-dir omp_src
+  %(prog)s results.json --no-simd --update-analysis
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '--patch',
+        type=str,
+        default='openmp.patch',
+        help='Unified diff with the proposed pragmas (default: openmp.patch)'
+    )
+    
+    parser.add_argument(
+        '--output-dir',
+        type=str,
+        help='Also write rewritten copies of the changed files under this directory'
+    )
+    
+    parser.add_argument(
+        '--loop-id',
+        action='append',
+        default=[],
+        help='Only add pragmas to this loop (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--no-simd',
+        action='store_true',
+        help='Do not propose #pragma omp simd for inner loops'
+    )
+    
+    parser.add_argument(
+        '--min-parallel-iterations',
+        type=int,
+        default=1000,
+        help='Loops with a smaller constant trip count get simd instead of parallel for (default: 1000)'
+    )
+    
+    parser.add_argument(
+        '--update-analysis',
+        action='store_true',
+        help='Write the parallelism verdicts back into the analysis JSON'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def openmp_main(argv: list) -> int:
+    """Entry point for the openmp subcommand."""
+    args = create_openmp_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        config, json_output, analysis_data = load_analysis(args.analysis, Path(args.analysis), args.log_level)
+        
+        rewriter = OpenMPRewriter(config, simd=not args.no_simd,
+                                  min_parallel_iterations=args.min_parallel_iterations,
+                                  loop_ids=args.loop_id)
+        output_dir = Path(args.output_dir) if args.output_dir else None
+        summary = rewriter.rewrite_tree(analysis_data['source_files'], Path(args.patch), output_dir)
+        
+        if args.update_analysis:
+            analysis_data.setdefault('extensions', {})['openmp'] = summary
+            json_output.write_output(analysis_data, args.analysis)
+        
+        if summary['files_changed'] == 0:
+            logger.info("No loops qualified for OpenMP pragmas")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"OpenMP rewrite failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_flamegraph_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the flamegraph subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py flamegraph',
+        description='Export loop nests as folded stacks for flame graphs',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s results.json -o loops.folded && flamegraph.pl loops.folded > loops.svg
+  %(prog)s results.json --call-graph --default-iterations 1000
+  %(prog)s annotated.json --weight counts     # coverage or instrumentation iterations
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        default='loops.folded',
+        help='Folded stack output file (default: loops.folded)'
+    )
+    
+    parser.add_argument(
+        '--weight',
+        type=str,
+        default='auto',
+        choices=list(FlameGraphExporter.WEIGHTS),
+        help='Stack weights: static estimate, measured counts, profile samples, or auto (default: auto)'
+    )
+    
+    parser.add_argument(
+        '--default-iterations',
+        type=int,
+        default=100,
+        help='Trip count assumed for loops without an estimate (default: 100)'
+    )
+    
+    parser.add_argument(
+        '--call-graph',
+        action='store_true',
+        help='Nest the loops of called functions under the calling loop'
+    )
+    
+    parser.add_argument(
+        '--call-depth',
+        type=int,
+        default=3,
+        help='Maximum number of calls followed with --call-graph (default: 3)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def flamegraph_main(argv: list) -> int:
+    """Entry point for the flamegraph subcommand."""
+    args = create_flamegraph_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        with open(args.analysis, 'r', encoding='utf-8') as f:
+            analysis_data = json.load(f)
+        
+        exporter = FlameGraphExporter(weight=args.weight, default_iterations=args.default_iterations,
+                                      call_graph=args.call_graph, call_depth=args.call_depth)
+        exporter.export(analysis_data, Path(args.output))
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Flame graph export failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_callgraph_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the callgraph subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py callgraph',
+        description='Export the loop call graph as Graphviz DOT and/or GraphML',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s results.json -o callgraph.dot && dot -Tsvg callgraph.dot > callgraph.svg
+  %(prog)s results.json -o callgraph.dot -o callgraph.graphml --min-weight 1000
+  %(prog)s results.json -o hot.dot --min-weight 1e6 --min-cost 1e7 --include-external
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        action='append',
+        default=[],
+        help='Output file; .graphml is written as GraphML, anything else as DOT (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--format',
+        type=str,
+        choices=list(CallGraphExporter.FORMATS),
+        help='Force the output format instead of detecting it from the file extension'
+    )
+    
+    parser.add_argument(
+        '--min-weight',
+        type=float,
+        default=0.0,
+        help='Drop edges whose estimated call count is below this value (default: 0)'
+    )
+    
+    parser.add_argument(
+        '--min-cost',
+        type=float,
+        help='Keep functions without remaining edges when their loop cost reaches this value'
+    )
+    
+    parser.add_argument(
+        '--include-external',
+        action='store_true',
+        help='Include callees that are not defined in the analyzed sources'
+    )
+    
+    parser.add_argument(
+        '--default-iterations',
+        type=int,
+        default=100,
+        help='Trip count assumed for loops without an estimate (default: 100)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def callgraph_main(argv: list) -> int:
+    """Entry point for the callgraph subcommand."""
+    args = create_callgraph_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        with open(args.analysis, 'r', encoding='utf-8') as f:
+            analysis_data = json.load(f)
+        
+        exporter = CallGraphExporter(default_iterations=args.default_iterations, min_weight=args.min_weight,
+                                     min_cost=args.min_cost, include_external=args.include_external)
+        output_paths = [Path(output) for output in args.output] or [Path('callgraph.dot')]
+        summary = exporter.export(analysis_data['source_files'], output_paths, args.format)
+        
+        logger.info(f"Kept {summary['nodes_kept']} of {summary['nodes']} functions and "
+                    f"{summary['edges_kept']} of {summary['edges']} call edges")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Call graph export failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_sarif_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the sarif subcommand."""
+    rules = '\n'.join(f"  {rule_id}  {rule['short']}" for rule_id, rule in sorted(LoopFindingDetector.RULES.items()))
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py sarif',
+        description='Report loop performance findings as SARIF 2.1.0 for editors and code review',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog=f"""
+Rules:
+{rules}
+
+Examples:
+  %(prog)s results.json -o findings.sarif
+  %(prog)s results.json -o findings.sarif --rule LOOP001 --rule LOOP004 --update-analysis
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Loop analysis JSON produced by a previous run'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        default='findings.sarif',
+        help='SARIF output file (default: findings.sarif)'
+    )
+    
+    parser.add_argument(
+        '--rule',
+        action='append',
+        choices=sorted(LoopFindingDetector.RULES),
+        help='Only run the given rule (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--base-dir',
+        type=str,
+        help='Directory artifact URIs are relative to, usually the repository root (default: current directory)'
+    )
+    
+    parser.add_argument(
+        '--update-analysis',
+        action='store_true',
+        help='Also store the findings in the analysis file (extensions.findings per loop)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def sarif_main(argv: list) -> int:
+    """Entry point for the sarif subcommand."""
+    args = create_sarif_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        config, json_output, analysis_data = load_analysis(args.analysis, Path(args.analysis), args.log_level)
+        
+        if 'findings' in analysis_data['metadata'].get('passes', {}) and not args.rule:
+            # The analysis ran the findings pass; export without parsing again
+            logger.info("Using findings recorded by the analysis findings pass")
+            summary = {}
+        else:
+            summary = PerformanceLinter(config, rules=args.rule).lint_tree(analysis_data['source_files'])
+        exporter = SarifExporter(Path(args.base_dir) if args.base_dir else None)
+        summary.update(exporter.export(analysis_data['source_files'], Path(args.output)))
+        
+        if args.update_analysis:
+            analysis_data.setdefault('extensions', {})['findings'] = summary
+            json_output.write_output(analysis_data, args.analysis)
+        
+        for rule_id, count in summary['by_rule'].items():
+            logger.info(f"  {rule_id} {LoopFindingDetector.RULES[rule_id]['name']}: {count}")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"SARIF export failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_generate_corpus_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the generate-corpus subcommand."""
+    defaults = CorpusParameters()
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py generate-corpus',
+        description='Write a deterministic synthetic C++ loop corpus for benchmarking',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s bench/corpus                          # 20 files, default shape
+  %(prog)s bench/deep --files 200 --loop-depth 6 --body-size 12 --seed 42
+  %(prog)s bench/objexx --objexx-density 1.0 --macro-density 0.5
+        """
+    )
+    
+    parser.add_argument(
+        'output_dir',
+        type=str,
+        help='Directory the corpus is written to'
+    )
+    
+    parser.add_argument(
+        '--files',
+        type=int,
+        default=defaults.files,
+        help=f'Number of source files (default: {defaults.files})'
+    )
+    
+    parser.add_argument(
+        '--functions-per-file',
+        type=int,
+        default=defaults.functions_per_file,
+        help=f'Functions per file, each holding one loop nest (default: {defaults.functions_per_file})'
+    )
+    
+    parser.add_argument(
+        '--loop-depth',
+        type=int,
+        default=defaults.loop_depth,
+        help=f'Maximum loop nesting depth (default: {defaults.loop_depth})'
+    )
+    
+    parser.add_argument(
+        '--body-size',
+        type=int,
+        default=defaults.body_size,
+        help=f'Statements per loop body (default: {defaults.body_size})'
+    )
+    
+    parser.add_argument(
+        '--macro-density',
+        type=float,
+        default=defaults.macro_density,
+        help=f'Fraction of loops and bodies written with macros (default: {defaults.macro_density})'
+    )
+    
+    parser.add_argument(
+        '--objexx-density',
+        type=float,
+        default=defaults.objexx_density,
+        help=f'Fraction of functions using ObjexxFCL-style arrays (default: {defaults.objexx_density})'
+    )
+    
+    parser.add_argument(
+        '--seed',
+        type=int,
+        default=defaults.seed,
+        help=f'Random seed; equal parameters and seed give identical files (default: {defaults.seed})'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def generate_corpus_main(argv: list) -> int:
+    """Entry point for the generate-corpus subcommand."""
+    args = create_generate_corpus_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        parameters = CorpusParameters(
+            files=args.files,
+            functions_per_file=args.functions_per_file,
+            loop_depth=args.loop_depth,
+            body_size=args.body_size,
+            macro_density=args.macro_density,
+            objexx_density=args.objexx_density,
+            seed=args.seed
+        )
+        manifest = CorpusGenerator(parameters).generate(Path(args.output_dir))
+        logger.info(f"Corpus digest: {manifest['digest']}")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Corpus generation failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_benchmark_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the benchmark subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py benchmark',
+        description='Measure extractor throughput and memory on a corpus, or compare two benchmark results',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s bench/corpus -o baseline.json                  # measure
+  %(prog)s bench/corpus -o current.json --compare baseline.json
+  %(prog)s current.json --compare baseline.json --threshold 5   # compare saved results only
+  %(prog)s bench/corpus --extractor-args "--passes all"
+
+Exits with status 1 when a metric regressed by more than the threshold.
+        """
+    )
+    
+    parser.add_argument(
+        'target',
+        type=str,
+        help='Corpus directory to benchmark, or a benchmark result JSON to compare'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        default='benchmark.json',
+        help='Result file when benchmarking a corpus (default: benchmark.json)'
+    )
+    
+    parser.add_argument(
+        '--repeat',
+        type=int,
+        default=3,
+        help='Measured runs; the summary uses their median (default: 3)'
+    )
+    
+    parser.add_argument(
+        '--warmup',
+        type=int,
+        default=1,
+        help='Unmeasured runs before the measured ones (default: 1)'
+    )
+    
+    parser.add_argument(
+        '--extractor-args',
+        type=str,
+        default='',
+        help='Extra options passed to each extractor run, as one quoted string'
+    )
+    
+    parser.add_argument(
+        '--compare',
+        type=str,
+        metavar='BASELINE',
+        help='Baseline result JSON to compare against'
+    )
+    
+    parser.add_argument(
+        '--threshold',
+        type=float,
+        default=10.0,
+        help='Percent a metric may get worse before it counts as a regression (default: 10)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def benchmark_main(argv: list) -> int:
+    """Entry point for the benchmark subcommand."""
+    args = create_benchmark_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        harness = BenchmarkHarness(extra_args=shlex.split(args.extractor_args))
+        target = Path(args.target)
+        
+        if target.is_dir():
+            current = harness.run(target, repeat=args.repeat, warmup=args.warmup)
+            harness.write(current, Path(args.output))
+            summary = current['summary']
+            logger.info(f"Median of {args.repeat} runs: {summary['wall_seconds']:.2f}s, "
+                        f"{summary['files_per_second']:.1f} files/s, {summary['cursors_per_second']:.0f} cursors/s, "
+                        f"peak {summary['peak_rss_mb']} MB, output {summary['output_bytes']} bytes")
+        elif args.compare:
+            with open(target, 'r', encoding='utf-8') as f:
+                current = json.load(f)
+        else:
+            logger.error(f"Not a corpus directory: {args.target} (result files need --compare)")
+            return 1
+        
+        if not args.compare:
+            return 0
+        
+        with open(args.compare, 'r', encoding='utf-8') as f:
+            baseline = json.load(f)
+        comparison = harness.compare(baseline, current, threshold=args.threshold)
+        for warning in comparison['warnings']:
+            logger.warning(warning)
+        for name, metric in comparison['metrics'].items():
+            marker = 'REGRESSION' if metric['regression'] else 'ok'
+            logger.info(f"  {name:<20} {metric['baseline']:>14} -> {metric['current']:>14} "
+                        f"({metric['change_percent']:+.1f}%) {marker}")
+        if comparison['regressions']:
+            logger.error(f"Regressions beyond {args.threshold}%: {', '.join(comparison['regressions'])}")
+            return 1
+        logger.info(f"No regressions beyond {args.threshold}%")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Benchmark failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_golden_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the golden subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py golden',
+        description='Compare the analysis of each fixture with its checked-in golden output',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s                                   # check test_code/ against test_code/golden/
+  %(prog)s --report golden_report.json       # also write per-fixture status and runtime
+  %(prog)s --update                          # accept the current output as the new goldens
+
+Exits with status 1 when a fixture differs from or has no golden file.
+        """
+    )
+    
+    parser.add_argument(
+        'fixtures',
+        type=str,
+        nargs='?',
+        default='test_code',
+        help='Directory of fixture source files (default: test_code)'
+    )
+    
+    parser.add_argument(
+        '--golden-dir',
+        type=str,
+        help='Directory of golden JSON files (default: <fixtures>/golden)'
+    )
+    
+    parser.add_argument(
+        '--update',
+        action='store_true',
+        help='Rewrite the golden files from the current output instead of comparing'
+    )
+    
+    parser.add_argument(
+        '--report',
+        type=str,
+        help='Write a JSON report with per-fixture status, differences and runtime'
+    )
+    
+    parser.add_argument(
+        '--cpp-standard',
+        type=str,
+        default='c++17',
+        choices=['c++11', 'c++14', 'c++17', 'c++20'],
+        help='C++ standard the goldens were generated with (default: c++17)'
+    )
+    
+    parser.add_argument(
+        '--passes',
+        type=str,
+        help='Comma-separated analysis passes (default: the default passes)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def golden_main(argv: list) -> int:
+    """Entry point for the golden subcommand."""
+    args = create_golden_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        fixture_dir = Path(args.fixtures).resolve()
+        if not fixture_dir.is_dir():
+            logger.error(f"Fixture directory does not exist: {args.fixtures}")
+            return 1
+        
+        config = Config(
+            source_path=fixture_dir,
+            output_path=Path('golden_report.json'),
+            include_patterns=[],
+            exclude_patterns=[],
+            cpp_standard=args.cpp_standard,
+            log_level=args.log_level,
+            passes=resolve_passes([name.strip() for name in args.passes.split(',') if name.strip()])
+            if args.passes else None
+        )
+        check = GoldenCheck(config, Path(args.golden_dir) if args.golden_dir else fixture_dir / 'golden')
+        report = check.run(update=args.update)
+        if args.report:
+            check.write_report(report, Path(args.report))
+        
+        if report['failed']:
+            logger.error(f"{len(report['failed'])} of {len(report['fixtures'])} fixtures failed to parse or "
+                         f"differ from their golden output: {', '.join(report['failed'])}")
+            return 1
+        action = 'updated' if args.update else 'match their golden output'
+        logger.info(f"{len(report['fixtures'])} fixtures {action} ({report['total_seconds']:.2f}s)")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Golden check failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def parse_shard(value: str) -> tuple:
+    """Parse a K/N shard argument into (index, count)."""
+    try:
+        index, count = (int(part) for part in value.split('/'))
+    except ValueError:
+        raise argparse.ArgumentTypeError(f"expected K/N, got '{value}'")
+    if count < 1 or not 1 <= index <= count:
+        raise argparse.ArgumentTypeError(f"shard {value} is out of range (1 <= K <= N)")
+    return index, count
+
+
+def create_merge_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the merge subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py merge',
+        description='Combine the analyses of a sharded run (--shard K/N) into one analysis',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s shard1.json shard2.json shard3.json -o loops.json
+  %(prog)s results/shard*.json -o loops.json
+
+The analysis summary, loop totals and call graph are recomputed over all
+files, so calls between files analyzed on different nodes are resolved.
+        """
+    )
+    
+    parser.add_argument(
+        'inputs',
+        type=str,
+        nargs='+',
+        help='Analysis JSON files written by the shards'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        default='loop_analysis.json',
+        help='Merged analysis file (default: loop_analysis.json)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def merge_main(argv: list) -> int:
+    """Entry point for the merge subcommand."""
+    args = create_merge_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        shards = []
+        for input_path in args.inputs:
+            _, _, analysis_data = load_analysis(input_path, Path(args.output), args.log_level)
+            shards.append((input_path, analysis_data))
+        
+        config = config_from_analysis(shards[0][1], Path(args.output), args.log_level)
+        output_data = ShardMerger(config).merge(shards)
+        JSONOutput(config).write_output(output_data, args.output)
+        logger.info(f"Merged analysis written to: {args.output}")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Merge failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_watch_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the watch subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py watch',
+        description='Analyze a tree once, then re-analyze files as they change and keep the output current',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s src/ -o loops.json                 # live analysis while editing src/
+  %(prog)s src/ --include 'kernels/**'        # only a part of a large tree
+  %(prog)s src/ --poll-interval 5 --no-inotify
+
+Changing a header re-analyzes every file that includes it. Stop with Ctrl+C.
+        """
+    )
+    
+    parser.add_argument(
+        'path',
+        type=str,
+        help='Path to the source code directory to watch'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        default='loop_analysis.json',
+        help='Output JSON file, rewritten after each change (default: loop_analysis.json)'
+    )
+    
+    parser.add_argument(
+        '--include',
+        action='append',
+        help='Include pattern for files, as for a normal run (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--exclude',
+        action='append',
+        help='Exclude pattern for files or directories (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--discovery',
+        type=str,
+        default='walk',
+        choices=['walk', 'git'],
+        help='How to find source files (default: walk)'
     )
     
     parser.add_argument(
         '--cpp-standard',
         type=str,
-        default='c++17',
-        choices=['c++11', 'c++14', 'c++17', 'c++20'],
-        help='C++ standard to use for parsing (default: c++17)'
+        default='c++17',
+        choices=['c++11', 'c++14', 'c++17', 'c++20'],
+        help='C++ standard to use for parsing (default: c++17)'
+    )
+    
+    parser.add_argument(
+        '--passes',
+        type=str,
+        help='Comma-separated analysis passes (default: the default passes)'
+    )
+    
+    parser.add_argument(
+        '--debounce',
+        type=float,
+        default=0.3,
+        help='Seconds without further changes before a batch of changes is analyzed (default: 0.3)'
+    )
+    
+    parser.add_argument(
+        '--poll-interval',
+        type=float,
+        default=2.0,
+        help='Rescan interval in seconds when inotify is not available (default: 2)'
+    )
+    
+    parser.add_argument(
+        '--no-inotify',
+        action='store_true',
+        help='Detect changes by rescanning file modification times instead of inotify'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def watch_main(argv: list) -> int:
+    """Entry point for the watch subcommand."""
+    args = create_watch_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        source_path = Path(args.path)
+        if not source_path.is_dir():
+            logger.error(f"Source path is not a directory: {args.path}")
+            return 1
+        
+        config = Config(
+            source_path=source_path,
+            output_path=Path(args.output),
+            include_patterns=args.include or [],
+            exclude_patterns=args.exclude or [],
+            cpp_standard=args.cpp_standard,
+            log_level=args.log_level,
+            passes=resolve_passes([name.strip() for name in args.passes.split(',') if name.strip()])
+            if args.passes else None,
+            discovery=args.discovery
+        )
+        session = WatchSession(config, Path(args.output), debounce=args.debounce,
+                               poll_interval=args.poll_interval, use_inotify=not args.no_inotify)
+        session.run()
+        return 0
+        
+    except KeyboardInterrupt:
+        logger.info("Watch stopped")
+        return 0
+    except Exception as e:
+        logger.error(f"Watch failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_serve_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the serve subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py serve',
+        description='Hold an analysis in memory and answer JSON-RPC queries on a Unix domain socket',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s energyplus.json --socket /tmp/loops.sock
+  loop_extractor.py query --socket /tmp/loops.sock loops_in_range file=src/Solver.cc start_line=120 end_line=180
+
+Requests are JSON-RPC 2.0 objects, one per line. Methods: ping, summary,
+loops_in_range, loops_at, function, call_graph, hottest_loops, reanalyze,
+save, shutdown.
+        """
+    )
+    
+    parser.add_argument(
+        'analysis',
+        type=str,
+        help='Analysis JSON file to serve'
+    )
+    
+    parser.add_argument(
+        '--socket',
+        type=str,
+        default='loop_extractor.sock',
+        help='Unix domain socket path (default: loop_extractor.sock)'
+    )
+    
+    parser.add_argument(
+        '--default-iterations',
+        type=int,
+        default=100,
+        help='Trip count assumed for loops without a known bound when ranking hottest loops (default: 100)'
     )
     
     parser.add_argument(
@@ -87,33 +1605,387 @@ Examples:
         help='Logging level (default: INFO)'
     )
     
+    return parser
+
+
+def serve_main(argv: list) -> int:
+    """Entry point for the serve subcommand."""
+    args = create_serve_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    server = None
+    try:
+        loading_started = time.perf_counter()
+        config, _, analysis_data = load_analysis(args.analysis, Path(args.analysis), args.log_level)
+        query_server = QueryServer(config, analysis_data, Path(args.analysis), args.default_iterations)
+        server = UnixQueryServer(Path(args.socket), query_server)
+        logger.info(f"Loaded {args.analysis} ({len(query_server.source_files)} files) in "
+                    f"{time.perf_counter() - loading_started:.2f}s; listening on {args.socket}")
+        server.serve_forever()
+        return 0
+        
+    except KeyboardInterrupt:
+        logger.info("Server stopped")
+        return 0
+    except Exception as e:
+        logger.error(f"Server failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+    finally:
+        if server is not None:
+            server.server_close()
+
+
+def create_query_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the query subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py query',
+        description='Send one JSON-RPC request to a running serve process and print the result',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s loops_at file=solver.cc line=214
+  %(prog)s hottest_loops calling=std::exp limit=5
+  %(prog)s reanalyze function=SimulateCoil
+
+Values are parsed as JSON when possible (numbers, true/false), otherwise taken as strings.
+        """
+    )
+    
     parser.add_argument(
-        '--verbose',
+        'method',
+        type=str,
+        help='Method to call'
+    )
+    
+    parser.add_argument(
+        'params',
+        nargs='*',
+        metavar='KEY=VALUE',
+        help='Method parameters'
+    )
+    
+    parser.add_argument(
+        '--socket',
+        type=str,
+        default='loop_extractor.sock',
+        help='Unix domain socket path (default: loop_extractor.sock)'
+    )
+    
+    parser.add_argument(
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def query_main(argv: list) -> int:
+    """Entry point for the query subcommand."""
+    args = create_query_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        params = {}
+        for item in args.params:
+            key, separator, value = item.partition('=')
+            if not separator:
+                logger.error(f"Parameter must be KEY=VALUE: {item}")
+                return 1
+            try:
+                params[key] = json.loads(value)
+            except json.JSONDecodeError:
+                params[key] = value
+        
+        result, error = query_socket(Path(args.socket), args.method, params)
+        if error:
+            logger.error(f"{args.method} failed: {error['message']} (code {error['code']})")
+            return 1
+        print(json.dumps(result, indent=2))
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Query failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_diff_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the diff subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py diff',
+        description='Compare the loops of two analyses and report added, removed and changed loops',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s base.json head.json
+  %(prog)s base.json head.json -o loop_diff.json --threshold 5
+  %(prog)s base.json head.json --fail-on-regression   # exit 1 in CI on regressions
+
+Loops are matched by function, normalized bounds and body content, so
+edits that only move a loop do not show up. A change is a regression when
+nesting deepens, a call is added inside a loop, or the estimated cost
+(executions x body cost, measured iterations when annotated) grows by more
+than the threshold; added loops nested inside other loops are regressions too.
+        """
+    )
+    
+    parser.add_argument(
+        'old',
+        type=str,
+        help='Analysis JSON of the base version'
+    )
+    
+    parser.add_argument(
+        'new',
+        type=str,
+        help='Analysis JSON of the changed version'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        help='Also write the diff as JSON to this file'
+    )
+    
+    parser.add_argument(
+        '--threshold',
+        type=float,
+        default=10.0,
+        help='Cost increase in percent reported as a regression (default: 10)'
+    )
+    
+    parser.add_argument(
+        '--default-iterations',
+        type=int,
+        default=100,
+        help='Trip count assumed for loops with unknown bounds (default: 100)'
+    )
+    
+    parser.add_argument(
+        '--fail-on-regression',
         action='store_true',
-        help='Enable verbose output'
+        help='Exit with status 1 when any regression is found'
     )
     
     parser.add_argument(
-        '--checkpoint-frequency',
+        '--log-level',
+        type=str,
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
+    )
+    
+    return parser
+
+
+def diff_main(argv: list) -> int:
+    """Entry point for the diff subcommand."""
+    args = create_diff_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        output_path = Path(args.output or 'loop_diff.json')
+        _, _, old_data = load_analysis(args.old, output_path, args.log_level)
+        _, _, new_data = load_analysis(args.new, output_path, args.log_level)
+        
+        analysis_diff = AnalysisDiff(args.threshold, args.default_iterations)
+        report = analysis_diff.diff(old_data, new_data)
+        print(analysis_diff.format_text(report))
+        
+        if args.output:
+            with open(args.output, 'w', encoding='utf-8') as f:
+                json.dump(report, f, indent=2)
+            logger.info(f"Diff written to: {args.output}")
+        
+        if args.fail_on_regression and report['summary']['regressions']:
+            return 1
+        return 0
+        
+    except Exception as e:
+        logger.error(f"Diff failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+def create_history_parser() -> argparse.ArgumentParser:
+    """Create the argument parser for the history subcommand."""
+    parser = argparse.ArgumentParser(
+        prog='loop_extractor.py history',
+        description='Track per-function loop metrics over the commits of a git repository',
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="""
+Examples:
+  %(prog)s --since v2.0 -o history.json
+  %(prog)s src/solver --since HEAD~200 --until release --include 'hvac/**'
+
+Each commit is checked out into a scratch worktree under --cache-dir and
+only files whose blob was not analyzed before are parsed; results are
+cached by blob hash, so later runs over an overlapping range are cheap.
+The output lists per-commit totals and, per function, a point at every
+commit where its loop count, cost, nesting or calls in loops changed.
+        """
+    )
+    
+    parser.add_argument(
+        'path',
+        type=str,
+        nargs='?',
+        default='.',
+        help='Directory inside the git repository to analyze (default: .)'
+    )
+    
+    parser.add_argument(
+        '--since',
+        type=str,
+        required=True,
+        help='First commit of the range (any git revision)'
+    )
+    
+    parser.add_argument(
+        '--until',
+        type=str,
+        default='HEAD',
+        help='Last commit of the range (default: HEAD)'
+    )
+    
+    parser.add_argument(
+        '-o', '--output',
+        type=str,
+        default='loop_history.json',
+        help='History JSON file (default: loop_history.json)'
+    )
+    
+    parser.add_argument(
+        '--cache-dir',
+        type=str,
+        default='.loop_history_cache',
+        help='Per-blob results and the scratch worktree (default: .loop_history_cache)'
+    )
+    
+    parser.add_argument(
+        '--include',
+        action='append',
+        help='Include pattern for files, as for a normal run (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--exclude',
+        action='append',
+        help='Exclude pattern for files or directories (can be specified multiple times)'
+    )
+    
+    parser.add_argument(
+        '--cpp-standard',
+        type=str,
+        default='c++17',
+        choices=['c++11', 'c++14', 'c++17', 'c++20'],
+        help='C++ standard to use for parsing (default: c++17)'
+    )
+    
+    parser.add_argument(
+        '--passes',
+        type=str,
+        help='Comma-separated analysis passes (default: the default passes)'
+    )
+    
+    parser.add_argument(
+        '--default-iterations',
         type=int,
-        default=50,
-        help='Save checkpoint every N files (default: 50)'
+        default=100,
+        help='Trip count assumed for loops with unknown bounds (default: 100)'
     )
     
     parser.add_argument(
-        '--resume-from-checkpoint',
+        '--log-level',
         type=str,
-        help='Resume analysis from a checkpoint file'
+        default='INFO',
+        choices=['DEBUG', 'INFO', 'WARNING', 'ERROR'],
+        help='Logging level (default: INFO)'
     )
     
     return parser
 
 
+def history_main(argv: list) -> int:
+    """Entry point for the history subcommand."""
+    args = create_history_parser().parse_args(argv)
+    
+    setup_logging(args.log_level)
+    logger = logging.getLogger(__name__)
+    
+    try:
+        config = Config(
+            source_path=Path(args.path),
+            output_path=Path(args.output),
+            include_patterns=args.include or [],
+            exclude_patterns=args.exclude or [],
+            cpp_standard=args.cpp_standard,
+            log_level=args.log_level,
+            passes=resolve_passes([name.strip() for name in args.passes.split(',') if name.strip()])
+            if args.passes else None
+        )
+        trend = HistoryTrend(config, Path(args.path), Path(args.cache_dir), args.default_iterations)
+        history = trend.run(args.since, args.until)
+        
+        with open(args.output, 'w', encoding='utf-8') as f:
+            json.dump(history, f, indent=2)
+        print(trend.format_text(history))
+        logger.info(f"History written to: {args.output}")
+        return 0
+        
+    except Exception as e:
+        logger.error(f"History failed: {e}")
+        logger.debug("Exception details:", exc_info=True)
+        return 1
+
+
+# Subcommands dispatched on the first argument; anything else is a source path
+SUBCOMMANDS = {
+    'annotate': annotate_main,
+    'instrument': instrument_main,
+    'extract-kernel': extract_kernel_main,
+    'openmp': openmp_main,
+    'flamegraph': flamegraph_main,
+    'callgraph': callgraph_main,
+    'sarif': sarif_main,
+    'generate-corpus': generate_corpus_main,
+    'benchmark': benchmark_main,
+    'golden': golden_main,
+    'merge': merge_main,
+    'watch': watch_main,
+    'serve': serve_main,
+    'query': query_main,
+    'diff': diff_main,
+    'history': history_main,
+}
+
+
 def main() -> int:
     """Main entry point."""
+    if len(sys.argv) > 1 and sys.argv[1] in SUBCOMMANDS:
+        return SUBCOMMANDS[sys.argv[1]](sys.argv[2:])
+    
     parser = create_argument_parser()
     args = parser.parse_args()
     
+    if args.list_passes:
+        for name, pass_class in PASS_REGISTRY.items():
+            keys = list(pass_class.loop_keys) + [f"extensions.{key}" for key in pass_class.extension_keys]
+            marker = '*' if pass_class.default else ' '
+            print(f"{marker} {name:<12} {pass_class.description} [{', '.join(keys)}]")
+        print("* = enabled by default")
+        return 0
+    
     # Setup logging
     log_level = 'DEBUG' if args.verbose else args.log_level
     setup_logging(log_level)
@@ -155,6 +2027,7 @@ def main() -> int:
             logger.info(f"Starting loop analysis of: {source_path}")
         
         start_time = datetime.now()
+        metrics = RunMetrics(slowest=args.slowest)
         
         # Create configuration
         config = Config(
@@ -163,7 +2036,17 @@ def main() -> int:
             include_patterns=args.include or [],
             exclude_patterns=args.exclude or [],
             cpp_standard=args.cpp_standard,
-            log_level=log_level
+            log_level=log_level,
+            llvm_backend=args.llvm_backend,
+            clang_path=args.clang,
+            opt_path=args.opt,
+            passes=resolve_passes([name.strip() for name in args.passes.split(',') if name.strip()])
+            if args.passes else None,
+            file_timeout=args.file_timeout,
+            file_memory_limit_mb=args.file_memory_limit,
+            index_recycle_files=args.index_recycle_files,
+            index_recycle_rss_mb=args.index_recycle_rss,
+            discovery=args.discovery
         )
         if args.resume_from_checkpoint:
             try:
@@ -178,7 +2061,8 @@ def main() -> int:
         # Phase 1: File Discovery
         logger.info("Phase 1: Discovering source files...")
         file_discovery = FileDiscovery(config)
-        source_files = file_discovery.discover_files()
+        with metrics.phase('discovery'):
+            source_files = file_discovery.discover_files()
         
         if not source_files:
             logger.warning("No source files found to analyze")
@@ -186,6 +2070,18 @@ def main() -> int:
             
         logger.info(f"Found {len(source_files)} source files to analyze")
         
+        # Every node discovers the same files and keeps its own cost-balanced share
+        shard_info = None
+        if args.shard:
+            shard_index, shard_count = args.shard
+            scheduler = WorkScheduler(config, Path(args.schedule_from) if args.schedule_from else None)
+            discovered_count = len(source_files)
+            source_files = scheduler.shard(source_files, shard_index, shard_count)
+            shard_info = {'index': shard_index, 'count': shard_count,
+                          'files': len(source_files), 'discovered_files': discovered_count}
+            if not source_files:
+                logger.warning(f"Shard {shard_index}/{shard_count} has no files to analyze")
+        
         # If resuming, filter out already processed files
         start_index = 0
         if resume_data:
@@ -199,7 +2095,15 @@ def main() -> int:
         # Phase 2: AST Parsing and Loop Analysis
         logger.info("Phase 2: Parsing and analyzing loops...")
         ast_parser = ASTParser(config)
-        loop_analyzer = LoopAnalyzer(config)
+        # One clang index for the run, shared with the analyzer and recycled by ASTParser.dispose
+        loop_analyzer = LoopAnalyzer(config, ast_parser)
+        file_analyzer = SupervisedFileAnalyzer(config, ast_parser, loop_analyzer)
+        
+        llvm_backend = None
+        if config.llvm_backend:
+            llvm_backend = LLVMBackend(config)
+            if not llvm_backend.is_available():
+                return 1
         
         # Initialize analysis state
         analysis_results = resume_data.get('source_files', {}) if resume_data else {}
@@ -218,23 +2122,35 @@ def main() -> int:
                 all_processed_files = list(analysis_results.keys())
                 all_processed_paths = [Path(f) for f in all_processed_files]
                 
-                checkpoint_data = json_output.generate_output(
-                    analysis_results=analysis_results,
-                    source_files=all_processed_paths,
-                    total_loops=total_loops,
-                    start_time=start_time
-                )
-                checkpoint_data['metadata']['checkpoint'] = True
-                checkpoint_data['metadata']['files_processed'] = processed_count
-                checkpoint_data['metadata']['files_remaining'] = total_files - processed_count
-                
-                json_output.write_output(checkpoint_data, str(checkpoint_file))
+                with metrics.phase('checkpoint'):
+                    checkpoint_data = json_output.generate_output(
+                        analysis_results=analysis_results,
+                        source_files=all_processed_paths,
+                        total_loops=total_loops,
+                        start_time=start_time
+                    )
+                    checkpoint_data['metadata']['checkpoint'] = True
+                    checkpoint_data['metadata']['files_processed'] = processed_count
+                    checkpoint_data['metadata']['files_remaining'] = total_files - processed_count
+                    
+                    json_output.write_output(checkpoint_data, str(checkpoint_file))
                 logger.info(f"Checkpoint saved: {checkpoint_file} ({processed_count}/{total_files} files)")
             except Exception as e:
                 logger.error(f"Failed to save checkpoint: {e}")
         
+        # Parallel runs start the most expensive files first and hand out files as workers free up
+        parallel_runner = None
+        discovery_order = {str(source_file): position for position, source_file in enumerate(source_files)}
+        if args.jobs > 1 and len(source_files) > 1:
+            source_files = WorkScheduler(config, Path(args.schedule_from) if args.schedule_from else None).order(source_files)
+            parallel_runner = ParallelFileAnalyzer(file_analyzer, args.jobs)
+            logger.info(f"Analyzing with {args.jobs} worker processes")
+            file_outcomes = parallel_runner.imap(source_files)
+        else:
+            file_outcomes = ((source_file, None) for source_file in source_files)
+        
         try:
-            for i, source_file in enumerate(source_files, 1):
+            for i, (source_file, outcome) in enumerate(file_outcomes, 1):
                 # Progress indication with time estimates
                 current_progress = start_index + i
                 progress_pct = (current_progress / total_files) * 100
@@ -249,23 +2165,46 @@ def main() -> int:
                 else:
                     eta_str = ""
                 
-                logger.info(f"Progress: {current_progress}/{total_files} ({progress_pct:.1f}%){eta_str} - Analyzing: {source_file.name}")
+                action = 'Analyzed' if parallel_runner else 'Analyzing'
+                logger.info(f"Progress: {current_progress}/{total_files} ({progress_pct:.1f}%){eta_str} - {action}: {source_file.name}")
                 
                 try:
-                    # Parse AST
-                    translation_unit = ast_parser.parse_file(source_file)
-                    if translation_unit is None:
+                    # Parse AST and analyze loops, in a budgeted child process if limits are set;
+                    # parallel runs already did this in a worker
+                    if outcome is None:
+                        outcome = file_analyzer.analyze(source_file)
+                    elif outcome['status'] == 'failed':
+                        raise RuntimeError(outcome['error'])
+                    if outcome['status'] == 'parse_failed':
                         logger.warning(f"Failed to parse: {source_file}")
                         continue
+                    if outcome['status'] != 'ok':
+                        # Recorded so the output and a resumed run both skip the file
+                        analysis_results[str(source_file)] = file_analyzer.failure_record(outcome)
+                        metrics.record_file(str(source_file), outcome['seconds'], {}, {}, 0, 0)
+                        continue
                     
-                    # Analyze loops
-                    file_analysis = loop_analyzer.analyze_file(translation_unit, source_file)
+                    file_analysis = outcome['analysis']
                     analysis_results[str(source_file)] = file_analysis
                     
+                    # Cross-validate with compiler analysis
+                    llvm_seconds = 0.0
+                    if llvm_backend:
+                        llvm_started = time.perf_counter()
+                        llvm_backend.analyze_file(source_file, file_analysis)
+                        llvm_seconds = time.perf_counter() - llvm_started
+                    
                     # Count loops for summary
                     file_loop_count = loop_analyzer.count_loops(file_analysis)
                     total_loops += file_loop_count
                     
+                    file_stats = outcome['stats']
+                    metrics.record_file(
+                        str(source_file), outcome['seconds'] + llvm_seconds,
+                        dict(outcome['timings'], traversal=file_stats['traversal'], llvm_backend=llvm_seconds),
+                        file_stats['passes'], file_stats['cursors'], file_loop_count
+                    )
+                    
                     logger.debug(f"Found {file_loop_count} loops in {source_file}")
                     
                 except Exception as e:
@@ -279,6 +2218,8 @@ def main() -> int:
                         save_checkpoint()
                         
         except KeyboardInterrupt:
+            if parallel_runner:
+                parallel_runner.close()
             logger.info(f"Analysis interrupted by user after processing {processed_count}/{total_files} files")
             logger.info("Saving checkpoint with current results...")
             save_checkpoint()
@@ -286,6 +2227,8 @@ def main() -> int:
             # Generate partial output
             logger.info("Generating partial results...")
             json_output = JSONOutput(config)
+            if parallel_runner:
+                analysis_results = order_results(analysis_results, discovery_order)
             
             # Include all processed files in the output
             all_processed_files = list(analysis_results.keys())
@@ -298,12 +2241,19 @@ def main() -> int:
                 start_time=start_time
             )
             
+            output_data['metadata']['performance'] = metrics.summary()
+            output_data['metadata']['performance']['index_recycles'] = ast_parser.index_recycles
+            if shard_info:
+                output_data['metadata']['shard'] = shard_info
+            
             # Mark as interrupted
             output_data['metadata']['interrupted'] = True
             output_data['metadata']['files_processed'] = processed_count
             output_data['metadata']['files_remaining'] = total_files - processed_count
             
             json_output.write_output(output_data, args.output)
+            if args.timings_csv:
+                metrics.write_csv(Path(args.timings_csv))
             
             logger.info(f"Partial analysis complete!")
             logger.info(f"Files processed: {processed_count}/{total_files}")
@@ -316,19 +2266,32 @@ def main() -> int:
         # Phase 3: Generate Output
         logger.info("Phase 3: Generating JSON output...")
         json_output = JSONOutput(config)
+        if parallel_runner:
+            analysis_results = order_results(analysis_results, discovery_order)
         
         # Include all processed files in final output
         all_processed_files = list(analysis_results.keys())
         all_processed_paths = [Path(f) for f in all_processed_files]
         
-        output_data = json_output.generate_output(
-            analysis_results=analysis_results,
-            source_files=all_processed_paths,
-            total_loops=total_loops,
-            start_time=start_time
-        )
+        with metrics.phase('serialization'):
+            output_data = json_output.generate_output(
+                analysis_results=analysis_results,
+                source_files=all_processed_paths,
+                total_loops=total_loops,
+                start_time=start_time
+            )
+        # The final write cannot time itself; its duration is logged below
+        output_data['metadata']['performance'] = metrics.summary()
+        output_data['metadata']['performance']['index_recycles'] = ast_parser.index_recycles
+        if shard_info:
+            output_data['metadata']['shard'] = shard_info
         
+        write_started = time.perf_counter()
         json_output.write_output(output_data, args.output)
+        write_seconds = time.perf_counter() - write_started
+        
+        if args.timings_csv:
+            metrics.write_csv(Path(args.timings_csv))
         
         # Clean up checkpoint file on successful completion
         if checkpoint_file.exists():
@@ -345,6 +2308,8 @@ def main() -> int:
         logger.info(f"Files analyzed: {len(analysis_results)}")
         logger.info(f"Total loops found: {total_loops}")
         logger.info(f"Duration: {duration.total_seconds():.2f} seconds")
+        phases = ', '.join(f"{name} {seconds:.2f}s" for name, seconds in metrics.phases.items())
+        logger.info(f"Phase timings: {phases}, output write {write_seconds:.2f}s")
         logger.info(f"Output written to: {args.output}")
         
         return 0
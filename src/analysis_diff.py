@@ -0,0 +1,273 @@
+"""
+Structural diff between two analysis runs.
+
+Loops are matched by a fingerprint instead of `loop_id`, which includes the
+loop's index among its siblings and so changes when a loop is inserted
+before it. A fingerprint
+combines the enclosing function (file relative to the scan root plus the
+qualified name), the loop kind with whitespace-normalized bounds, and a
+hash of the body as recorded (operations, memory accesses and calls,
+without line numbers). Loops that keep their fingerprint but move are not
+reported unless a metric changed. Unmatched loops are then paired by
+function and bounds (body changed) or by function and body (bounds
+changed); the rest are added or removed.
+"""
+
+import hashlib
+import json
+import logging
+import re
+from collections import Counter
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+from .loop_index import LoopIndex
+from .loop_cost import LoopCostModel
+
+
+class AnalysisDiff:
+    """Matches loops between an old and a new analysis and reports metric deltas."""
+
+    # Keys holding positions rather than content; ignored when hashing a body
+    POSITION_KEYS = {'line', 'column', 'start_line', 'end_line', 'start_column', 'end_column', 'location'}
+
+    def __init__(self, cost_threshold: float = 10.0, default_iterations: int = 100):
+        """Initialize the diff; a cost increase above cost_threshold percent is a regression."""
+        self.cost_threshold = cost_threshold
+        self.cost_model = LoopCostModel(default_iterations)
+        self.logger = logging.getLogger(__name__)
+
+    def diff(self, old_data: Dict[str, Any], new_data: Dict[str, Any]) -> Dict[str, Any]:
+        """Compare two analyses; returns added, removed and changed loops with a summary."""
+        old_loops = self.loops(old_data)
+        new_loops = self.loops(new_data)
+
+        added, removed, changed = [], [], []
+        unmatched_old = dict(old_loops)
+        unmatched_new = dict(new_loops)
+
+        # Same fingerprint: moved at most; report only metric changes (e.g. nesting via a parent)
+        for key in list(unmatched_new):
+            if key in unmatched_old:
+                old_loop, new_loop = unmatched_old.pop(key), unmatched_new.pop(key)
+                entry = self._compare(old_loop, new_loop, 'metrics')
+                if entry['deltas']:
+                    changed.append(entry)
+
+        # Same function and bounds with a different body, then same function and body with new bounds
+        for reason, part in (('body', 'bounds'), ('bounds', 'body')):
+            candidates: Dict[Tuple, List[Tuple]] = {}
+            for key, loop in unmatched_old.items():
+                candidates.setdefault((loop['function_key'], loop[part]), []).append(key)
+            for key in list(unmatched_new):
+                loop = unmatched_new[key]
+                matches = candidates.get((loop['function_key'], loop[part]))
+                if matches:
+                    old_loop = unmatched_old.pop(matches.pop(0))
+                    changed.append(self._compare(old_loop, unmatched_new.pop(key), reason))
+
+        added = [self._describe(loop) for loop in unmatched_new.values()]
+        removed = [self._describe(loop) for loop in unmatched_old.values()]
+        sort_key = lambda entry: (entry['file'], entry['function'], entry.get('start_line', 0))
+        added.sort(key=sort_key)
+        removed.sort(key=sort_key)
+        changed.sort(key=sort_key)
+
+        regressions = [entry for entry in changed if entry['regression']]
+        regressions += [entry for entry in added if entry['regression']]
+        return {
+            'summary': {
+                'old_loops': len(old_loops),
+                'new_loops': len(new_loops),
+                'added': len(added),
+                'removed': len(removed),
+                'changed': len(changed),
+                'unchanged': len(old_loops) - len(removed) - len(changed),
+                'regressions': len(regressions),
+                'old_cost': round(sum(loop['cost'] for loop in old_loops.values()), 3),
+                'new_cost': round(sum(loop['cost'] for loop in new_loops.values()), 3),
+                'cost_threshold_percent': self.cost_threshold,
+            },
+            'added': added,
+            'removed': removed,
+            'changed': changed,
+        }
+
+    def loops(self, analysis_data: Dict[str, Any]) -> Dict[Tuple, Dict[str, Any]]:
+        """Fingerprinted loop facts of an analysis, keyed by (fingerprint, occurrence)."""
+        scan_path = analysis_data.get('metadata', {}).get('scan_path', '')
+        index = LoopIndex(analysis_data.get('source_files', {}))
+        loops: Dict[Tuple, Dict[str, Any]] = {}
+        occurrences: Counter = Counter()
+
+        def walk(file_name: str, function_name: str, records: List[Dict[str, Any]],
+                 parent_executions: float, nest_path: str) -> None:
+            for position, loop in enumerate(records):
+                executions = self.cost_model.executions(loop, parent_executions)
+                facts = {
+                    'file': file_name,
+                    'function': function_name or '<global>',
+                    'function_key': f"{file_name}:{function_name}",
+                    'bounds': self.normalize_bounds(loop),
+                    'body': self.body_hash(loop, scan_path),
+                    'loop': loop,
+                    'nest_path': f"{nest_path}/{position}",
+                    'executions': executions,
+                    'cost': executions * self.cost_model.body_cost(loop),
+                }
+                fingerprint = self.fingerprint(facts)
+                facts['fingerprint'] = fingerprint
+                # Identical loops in one function are told apart by their order
+                occurrences[fingerprint] += 1
+                loops[(fingerprint, occurrences[fingerprint])] = facts
+                walk(file_name, function_name, loop.get('nested_loops', []), executions, facts['nest_path'])
+
+        for file_path, function_name, records in index.iter_functions():
+            walk(self._relative(file_path, scan_path), function_name, records, 1.0, '')
+        return loops
+
+    def fingerprint(self, facts: Dict[str, Any]) -> str:
+        """Stable identity of a loop: enclosing function, normalized bounds and body hash."""
+        text = '\0'.join((facts['function_key'], facts['bounds'], facts['body']))
+        return hashlib.sha1(text.encode('utf-8')).hexdigest()[:16]
+
+    def normalize_bounds(self, loop: Dict[str, Any]) -> str:
+        """Loop kind and header with whitespace collapsed."""
+        bounds = loop.get('loop_bounds', {})
+        parts = [loop.get('type', '')]
+        for key in ('initialization', 'condition', 'increment'):
+            parts.append(re.sub(r'\s+', ' ', str(bounds.get(key, ''))).strip())
+        return ' ; '.join(parts)
+
+    def body_hash(self, loop: Dict[str, Any], scan_path: str = '') -> str:
+        """Hash of the loop's recorded body content without positions or nested loops."""
+        content = {key: self._strip_positions(value, scan_path) for key, value in loop.items()
+                   if key in ('operations', 'memory_access', 'function_calls')}
+        return hashlib.sha1(json.dumps(content, sort_keys=True).encode('utf-8')).hexdigest()[:16]
+
+    def _strip_positions(self, value: Any, scan_path: str) -> Any:
+        """Copy of a record without line and column keys, with definition files relative to the scan root."""
+        if isinstance(value, dict):
+            return {key: self._relative(item, scan_path) if key == 'definition_file'
+                    else self._strip_positions(item, scan_path)
+                    for key, item in value.items() if key not in self.POSITION_KEYS}
+        if isinstance(value, list):
+            return [self._strip_positions(item, scan_path) for item in value]
+        return value
+
+    def _compare(self, old: Dict[str, Any], new: Dict[str, Any], reason: str) -> Dict[str, Any]:
+        """Changed-loop entry with the deltas between two matched loops."""
+        entry = self._describe(new)
+        entry['old_start_line'] = old['loop'].get('location', {}).get('start_line', 0)
+        entry['match'] = reason
+        deltas: Dict[str, Any] = {}
+
+        old_nesting = old['loop'].get('nesting_level', 1)
+        new_nesting = new['loop'].get('nesting_level', 1)
+        if old_nesting != new_nesting:
+            deltas['nesting_level'] = {'old': old_nesting, 'new': new_nesting}
+
+        old_trips, new_trips = self._trip_count(old['loop']), self._trip_count(new['loop'])
+        if old_trips != new_trips:
+            deltas['trip_count'] = {'old': old_trips, 'new': new_trips}
+
+        old_calls, new_calls = self._calls(old['loop']), self._calls(new['loop'])
+        if old_calls != new_calls:
+            deltas['calls_in_loop'] = {
+                'added': sorted(set(new_calls) - set(old_calls)),
+                'removed': sorted(set(old_calls) - set(new_calls)),
+            }
+
+        if old['bounds'] != new['bounds']:
+            deltas['bounds'] = {'old': old['bounds'], 'new': new['bounds']}
+
+        if abs(new['cost'] - old['cost']) > 1e-9 * max(1.0, old['cost']):
+            deltas['cost'] = {
+                'old': round(old['cost'], 3),
+                'new': round(new['cost'], 3),
+                'percent': round((new['cost'] - old['cost']) / old['cost'] * 100, 1) if old['cost'] else None,
+            }
+
+        entry['deltas'] = deltas
+        entry['regression'] = self._is_regression(deltas)
+        return entry
+
+    def _is_regression(self, deltas: Dict[str, Any]) -> bool:
+        """Deeper nesting, new calls in the loop, or cost up by more than the threshold."""
+        if deltas.get('nesting_level', {}).get('new', 0) > deltas.get('nesting_level', {}).get('old', 0):
+            return True
+        if deltas.get('calls_in_loop', {}).get('added'):
+            return True
+        cost = deltas.get('cost')
+        if cost:
+            return cost['percent'] is None or cost['percent'] > self.cost_threshold
+        return False
+
+    def _describe(self, facts: Dict[str, Any]) -> Dict[str, Any]:
+        """Report entry identifying one loop."""
+        loop = facts['loop']
+        return {
+            'file': facts['file'],
+            'function': facts['function'],
+            'fingerprint': facts['fingerprint'],
+            'loop_id': loop.get('loop_id', ''),
+            'type': loop.get('type', ''),
+            'start_line': loop.get('location', {}).get('start_line', 0),
+            'nesting_level': loop.get('nesting_level', 1),
+            'trip_count': self._trip_count(loop),
+            'calls_in_loop': self._calls(loop),
+            'cost': round(facts['cost'], 3),
+            # An added loop nested inside another loop multiplies work
+            'regression': loop.get('nesting_level', 1) > 1,
+        }
+
+    def _trip_count(self, loop: Dict[str, Any]) -> Optional[float]:
+        """Known or literal trip count; None when only the default would apply."""
+        bounds = loop.get('loop_bounds', {})
+        try:
+            return float(bounds.get('estimated_iterations', 'unknown'))
+        except (TypeError, ValueError):
+            literal = self.cost_model.literal_trip_count(bounds)
+            return float(literal) if literal is not None else None
+
+    def _calls(self, loop: Dict[str, Any]) -> List[str]:
+        """Distinct function names called in the loop body."""
+        return sorted({call.get('function', '') for call in loop.get('function_calls', []) if call.get('function')})
+
+    def _relative(self, file_path: str, scan_path: str) -> str:
+        """File path relative to its run's scan root, so runs of different checkouts compare."""
+        try:
+            return Path(file_path).relative_to(scan_path).as_posix() if scan_path else file_path
+        except ValueError:
+            return file_path
+
+    def format_text(self, report: Dict[str, Any], limit: int = 50) -> str:
+        """Human-readable report for review comments and terminals."""
+        summary = report['summary']
+        lines = [f"{summary['old_loops']} -> {summary['new_loops']} loops: {summary['added']} added, "
+                 f"{summary['removed']} removed, {summary['changed']} changed, "
+                 f"{summary['regressions']} regressions; total cost {summary['old_cost']:.4g} -> "
+                 f"{summary['new_cost']:.4g}"]
+        for marker, section in (('+', 'added'), ('-', 'removed'), ('~', 'changed')):
+            for entry in report[section][:limit]:
+                flag = ' [regression]' if section != 'removed' and entry['regression'] else ''
+                where = f"{entry['file']}:{entry['start_line']} {entry['function']}"
+                if section == 'changed':
+                    details = ', '.join(self._format_delta(name, delta) for name, delta in entry['deltas'].items()) \
+                        or 'body changed'
+                    lines.append(f"{marker} {where} ({entry['match']}): {details}{flag}")
+                else:
+                    lines.append(f"{marker} {where} {entry['type']} nesting {entry['nesting_level']} "
+                                 f"cost {entry['cost']:.4g}{flag}")
+            if len(report[section]) > limit:
+                lines.append(f"  ... {len(report[section]) - limit} more {section}")
+        return '\n'.join(lines)
+
+    def _format_delta(self, name: str, delta: Dict[str, Any]) -> str:
+        """One delta as 'name old -> new'."""
+        if name == 'calls_in_loop':
+            parts = [f"+{call}" for call in delta['added']] + [f"-{call}" for call in delta['removed']]
+            return f"calls {' '.join(parts)}"
+        if name == 'cost' and delta['percent'] is not None:
+            return f"cost {delta['old']:.4g} -> {delta['new']:.4g} ({delta['percent']:+.1f}%)"
+        return f"{name} {delta['old']} -> {delta['new']}"
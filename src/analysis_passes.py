@@ -0,0 +1,353 @@
+"""
+Analysis pass framework.
+
+LoopAnalyzer walks each translation unit once; passes subscribe to the
+cursor kinds they care about inside loop bodies and get file, function and
+loop hooks. Each pass declares the loop record fields it fills, so a run
+only pays for the analyses that were selected with `--passes`.
+"""
+
+import logging
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple, Type, FrozenSet
+
+try:
+    from clang.cindex import TranslationUnit, CursorKind, Cursor
+except ImportError as e:
+    raise ImportError("libclang not found. Please install with: pip install libclang") from e
+
+from .config import Config
+from .ast_parser import ASTParser
+
+
+class AnalysisPass:
+    """Base class for passes driven by LoopAnalyzer's single traversal.
+
+    `cursor_kinds` selects which cursors inside loop bodies reach `visit`.
+    `loop_keys` names the loop record fields the pass fills and
+    `extension_keys` the keys it adds under `loop['extensions']`.
+    """
+
+    name = ''
+    description = ''
+    default = False
+    cursor_kinds: FrozenSet[CursorKind] = frozenset()
+    loop_keys: Tuple[str, ...] = ()
+    extension_keys: Tuple[str, ...] = ()
+
+    def __init__(self, config: Config, ast_parser: ASTParser):
+        """Initialize the pass with the analyzer's configuration and parser."""
+        self.config = config
+        self.ast_parser = ast_parser
+        self.logger = logging.getLogger(__name__)
+
+    def begin_file(self, translation_unit: TranslationUnit, file_path: Path, file_analysis: Dict[str, Any]) -> None:
+        """Called before a translation unit is walked."""
+
+    def end_file(self, translation_unit: TranslationUnit, file_path: Path, file_analysis: Dict[str, Any]) -> None:
+        """Called after a translation unit is walked."""
+
+    def begin_function(self, cursor: Cursor, function_info: Dict[str, Any]) -> None:
+        """Called when a function or method record has been created."""
+
+    def end_function(self, cursor: Cursor, function_info: Dict[str, Any]) -> None:
+        """Called after the loops of a function or method have been analyzed."""
+
+    def begin_loop(self, cursor: Cursor, loop_info: Dict[str, Any]) -> None:
+        """Called before a loop body is walked."""
+
+    def visit(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict[str, Any]) -> None:
+        """Called for each subscribed cursor in the loop's own body (nested loop bodies excluded).
+
+        `location` is an ASTParser.lazy_location mapping with the get_cursor_location
+        keys; each field is read from libclang on first access, so read only what is used.
+        """
+
+    def end_loop(self, cursor: Cursor, loop_info: Dict[str, Any]) -> None:
+        """Called after a loop body, including its nested loops, has been walked."""
+
+    def extensions(self, loop_info: Dict[str, Any]) -> Dict[str, Any]:
+        """The loop's extensions dict, created on first use."""
+        return loop_info.setdefault('extensions', {})
+
+
+PASS_REGISTRY: Dict[str, Type[AnalysisPass]] = {}
+
+
+def register_pass(pass_class: Type[AnalysisPass]) -> Type[AnalysisPass]:
+    """Class decorator adding a pass to the registry under its name."""
+    if not pass_class.name:
+        raise ValueError(f"Pass {pass_class.__name__} has no name")
+    PASS_REGISTRY[pass_class.name] = pass_class
+    return pass_class
+
+
+def resolve_passes(names: Optional[List[str]] = None) -> List[str]:
+    """Validate pass names; None selects the default passes and 'all' every registered pass."""
+    if names is None:
+        return [name for name, pass_class in PASS_REGISTRY.items() if pass_class.default]
+    if 'all' in names:
+        return list(PASS_REGISTRY)
+
+    unknown = [name for name in names if name not in PASS_REGISTRY]
+    if unknown:
+        raise ValueError(f"Unknown passes: {', '.join(unknown)} (available: {', '.join(PASS_REGISTRY)})")
+    # Registry order, so output does not depend on the order given on the command line
+    return [name for name in PASS_REGISTRY if name in names]
+
+
+def describe_passes(names: List[str]) -> Dict[str, Dict[str, List[str]]]:
+    """Output keys of the given passes, for the analysis metadata."""
+    return {
+        name: {
+            'loop_keys': list(PASS_REGISTRY[name].loop_keys),
+            'extension_keys': list(PASS_REGISTRY[name].extension_keys),
+        }
+        for name in names
+    }
+
+
+@register_pass
+class OperationsPass(AnalysisPass):
+    """Classifies binary and unary operations in loop bodies."""
+
+    name = 'operations'
+    description = 'Arithmetic, logical, bitwise and unary operations'
+    default = True
+    cursor_kinds = frozenset({CursorKind.BINARY_OPERATOR, CursorKind.UNARY_OPERATOR})
+    loop_keys = ('operations',)
+
+    # Operation types for classification
+    ARITHMETIC_OPS = {
+        '+', '-', '*', '/', '%', '++', '--', '+=', '-=', '*=', '/=', '%='
+    }
+
+    LOGICAL_OPS = {
+        '&&', '||', '!', '==', '!=', '<', '>', '<=', '>='
+    }
+
+    BITWISE_OPS = {
+        '&', '|', '^', '~', '<<', '>>', '&=', '|=', '^=', '<<=', '>>='
+    }
+
+    def visit(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict[str, Any]) -> None:
+        """Record the operation under its type."""
+        if cursor.kind == CursorKind.BINARY_OPERATOR:
+            self._analyze_binary_operation(cursor, loop_info, location)
+        else:
+            self._analyze_unary_operation(cursor, loop_info, location)
+
+    def _analyze_binary_operation(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict) -> None:
+        """Analyze binary operations."""
+        try:
+            # Get the operator (this is tricky with libclang, approximate from source)
+            source_text = self.ast_parser.get_source_text(cursor)
+
+            # Simple heuristic to detect operation type
+            if any(op in source_text for op in self.ARITHMETIC_OPS):
+                op_type = 'arithmetic'
+            elif any(op in source_text for op in self.LOGICAL_OPS):
+                op_type = 'logical'
+            elif any(op in source_text for op in self.BITWISE_OPS):
+                op_type = 'bitwise'
+            else:
+                op_type = 'unknown'
+
+            operation = {
+                'type': op_type,
+                'expression': source_text.strip(),
+                'line': location['line'],
+            }
+
+            if op_type in loop_info['operations']:
+                loop_info['operations'][op_type].append(operation)
+            else:
+                loop_info['operations'].setdefault('other', []).append(operation)
+
+        except Exception as e:
+            self.logger.debug(f"Error analyzing binary operation: {e}")
+
+    def _analyze_unary_operation(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict) -> None:
+        """Analyze unary operations."""
+        try:
+            source_text = self.ast_parser.get_source_text(cursor)
+
+            operation = {
+                'type': 'unary',
+                'expression': source_text.strip(),
+                'line': location['line'],
+            }
+
+            loop_info['operations'].setdefault('unary', []).append(operation)
+
+        except Exception as e:
+            self.logger.debug(f"Error analyzing unary operation: {e}")
+
+
+@register_pass
+class FunctionCallPass(AnalysisPass):
+    """Records calls made in loop bodies."""
+
+    name = 'calls'
+    description = 'Function and method calls with their resolved definitions'
+    default = True
+    cursor_kinds = frozenset({CursorKind.CALL_EXPR})
+    loop_keys = ('function_calls', 'operations.function_calls')
+
+    def visit(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict[str, Any]) -> None:
+        """Analyze function calls."""
+        try:
+            function_name = self._extract_function_name(cursor)
+
+            # Extract arguments
+            arguments = []
+            for child in cursor.get_children():
+                if child.kind != CursorKind.UNEXPOSED_EXPR:
+                    arg_text = self.ast_parser.get_source_text(child).strip()
+                    if arg_text:
+                        arguments.append(arg_text)
+
+            function_call = {
+                'function': function_name,
+                'arguments': arguments,
+                'line': location['line'],
+            }
+
+            loop_info['operations']['function_calls'].append(function_call)
+
+            # Also add to detailed function calls
+            detailed_call = {
+                'function': function_name,
+                'location': {
+                    'line': location['line'],
+                    'column': location['column'],
+                },
+                'resolved': bool(cursor.referenced),
+                'definition_file': str(cursor.referenced.location.file) if cursor.referenced and cursor.referenced.location.file else '',
+            }
+
+            loop_info['function_calls'].append(detailed_call)
+
+        except Exception as e:
+            self.logger.debug(f"Error analyzing function call: {e}")
+
+    def _extract_function_name(self, cursor: Cursor) -> str:
+        """Extract function name from call expression, handling C++ method calls."""
+        try:
+            # Try to get the full qualified name from source text first
+            # This is most reliable for qualified names like Class::method
+            full_source = self.ast_parser.get_source_text(cursor).strip()
+            if full_source and '(' in full_source:
+                # Extract everything before the first '('
+                func_part = full_source.split('(')[0].strip()
+                if func_part:
+                    # Return the full qualified name if it contains ::
+                    if '::' in func_part:
+                        return func_part
+                    # For simple function calls, continue to child analysis
+                    # to get more accurate names from AST
+
+            # For C++ method calls, examine the children
+            children = list(cursor.get_children())
+            if not children:
+                # Fallback to spelling if no children
+                return cursor.spelling or "unknown_function"
+
+            first_child = children[0]
+
+            # Handle different types of function calls
+            if first_child.kind == CursorKind.MEMBER_REF_EXPR:
+                # Method call: object.method() or object->method()
+                method_name = first_child.spelling
+                if method_name:
+                    return method_name
+
+            elif first_child.kind == CursorKind.DECL_REF_EXPR:
+                # Simple function call: function()
+                func_name = first_child.spelling
+                if func_name:
+                    return func_name
+
+            elif first_child.kind in [CursorKind.UNEXPOSED_EXPR, CursorKind.CALL_EXPR]:
+                # Nested or complex expression, try to get source text
+                source_text = self.ast_parser.get_source_text(first_child).strip()
+                if source_text:
+                    # Extract function name from source text
+                    if '(' in source_text:
+                        source_text = source_text.split('(')[0].strip()
+                    return source_text
+
+            elif first_child.kind == CursorKind.OVERLOADED_DECL_REF:
+                # Overloaded function reference
+                return first_child.spelling or "overloaded_function"
+
+            # Final fallback: use the source text we extracted earlier
+            if full_source and '(' in full_source:
+                func_part = full_source.split('(')[0].strip()
+                if func_part:
+                    # For method calls with . or ->, extract just the method name
+                    if '.' in func_part and '::' not in func_part:
+                        return func_part.split('.')[-1]
+                    elif '->' in func_part and '::' not in func_part:
+                        return func_part.split('->')[-1]
+                    else:
+                        return func_part
+
+            # Final fallback
+            return cursor.spelling or "unknown_function"
+
+        except Exception as e:
+            self.logger.debug(f"Error extracting function name: {e}")
+            return "unknown_function"
+
+
+@register_pass
+class MemoryAccessPass(AnalysisPass):
+    """Records variable and array references in loop bodies."""
+
+    name = 'memory'
+    description = 'Variable, array, pointer and member accesses'
+    default = True
+    cursor_kinds = frozenset({CursorKind.DECL_REF_EXPR, CursorKind.ARRAY_SUBSCRIPT_EXPR})
+    loop_keys = ('memory_access',)
+
+    def visit(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict[str, Any]) -> None:
+        """Analyze memory access patterns."""
+        try:
+            source_text = self.ast_parser.get_source_text(cursor).strip()
+            if not source_text:
+                return
+
+            # Determine access type
+            access_type = 'unknown'
+            if '[' in source_text and ']' in source_text:
+                # Array access
+                if source_text.count('[') == 1:
+                    access_type = '1d_array'
+                elif source_text.count('[') == 2:
+                    access_type = '2d_array'
+                else:
+                    access_type = 'multi_array'
+            elif '*' in source_text:
+                access_type = 'pointer'
+            elif '.' in source_text or '->' in source_text:
+                access_type = 'struct_member'
+            else:
+                access_type = 'variable'
+
+            # Extract variable name (simple heuristic)
+            variable_name = source_text.split('[')[0].split('.')[0].split('->')[0].strip()
+
+            memory_access = {
+                'variable': variable_name,
+                'access_pattern': source_text,
+                'access_type': access_type,
+                'stride_pattern': 'unknown',  # Would need more sophisticated analysis
+                'line': location['line'],
+            }
+
+            # For now, assume all accesses are reads (write detection would need more context)
+            loop_info['memory_access']['reads'].append(memory_access)
+
+        except Exception as e:
+            self.logger.debug(f"Error analyzing memory access: {e}")
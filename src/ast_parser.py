@@ -2,9 +2,12 @@
 Clang AST parser module for parsing C/C++ source files.
 """
 
+import ctypes
 import logging
+import time
 from pathlib import Path
-from typing import Optional, List
+from collections.abc import Mapping
+from typing import Optional, List, Dict, Any, Iterator
 
 try:
     import clang.cindex as clang
@@ -13,6 +16,7 @@ except ImportError as e:
     raise ImportError("libclang not found. Please install with: pip install libclang") from e
 
 from .config import Config
+from .run_metrics import RunMetrics
 
 
 class ASTParser:
@@ -23,6 +27,15 @@ class ASTParser:
         self.config = config
         self.logger = logging.getLogger(__name__)
         self.index = None
+        # Wall time of the last parse_file call, split into parse and diagnostics
+        self.last_timings = {'parse': 0.0, 'diagnostics': 0.0}
+        # is_in_file memos: (CXFile address, target) -> bool, valid for live units only,
+        # and path -> resolved path string
+        self._in_file_cache = {}
+        self._resolved_paths = {}
+        # Files disposed since the index was last created, and how often it was recreated
+        self.files_since_recycle = 0
+        self.index_recycles = 0
         self._initialize_clang()
     
     def _initialize_clang(self) -> None:
@@ -56,15 +69,50 @@ class ASTParser:
             self.logger.error(f"Failed to initialize Clang: {e}")
             raise
     
+    def dispose(self, translation_unit: TranslationUnit) -> None:
+        """Free a translation unit now instead of whenever its last cursor is collected.
+
+        Cursors of the unit must not be used afterwards. Also recreates the
+        index every `config.index_recycle_files` files or once RSS exceeds
+        `config.index_recycle_rss_mb`, so long runs keep a flat footprint.
+        """
+        clang.conf.lib.clang_disposeTranslationUnit(translation_unit)
+        # Turn the binding's own disposal in __del__ into a no-op on a NULL unit
+        translation_unit.obj = translation_unit._as_parameter_ = None
+        # CXFile addresses of the unit may be reused by the next one
+        self._in_file_cache.clear()
+        
+        self.files_since_recycle += 1
+        recycle_files = self.config.index_recycle_files
+        recycle_rss = self.config.index_recycle_rss_mb
+        if recycle_files and self.files_since_recycle >= recycle_files:
+            self.recycle_index(f"after {self.files_since_recycle} files")
+        elif recycle_rss:
+            rss_mb = RunMetrics.current_rss_mb()
+            if rss_mb is not None and rss_mb > recycle_rss:
+                self.recycle_index(f"RSS {rss_mb:.0f} MB above {recycle_rss} MB")
+    
+    def recycle_index(self, reason: str = '') -> None:
+        """Replace the clang index with a fresh one and return freed heap memory to the OS."""
+        # The old index is disposed once the last translation unit referring to it is gone
+        self.index = clang.Index.create()
+        self.files_since_recycle = 0
+        self.index_recycles += 1
+        RunMetrics.release_free_memory()
+        self.logger.debug(f"Recycled clang index{' (' + reason + ')' if reason else ''}")
+    
     def parse_file(self, file_path: Path) -> Optional[TranslationUnit]:
         """Parse a single source file and return the translation unit."""
+        self.last_timings = {'parse': 0.0, 'diagnostics': 0.0}
+        # Units released without dispose() free their CXFiles whenever they are collected
+        self._in_file_cache.clear()
         if self.index is None:
             self.logger.error("Clang index not initialized")
             return None
         
         try:
             # Get compiler flags
-            flags = self.config.get_compiler_flags()
+            flags = self.config.get_compiler_flags(file_path)
             
             # Add file-specific flags if needed
             if file_path.suffix in {'.hpp', '.h', '.hxx'}:
@@ -75,17 +123,20 @@ class ASTParser:
             self.logger.debug(f"Parsing {file_path} with flags: {flags}")
             
             # Parse the file
+            parse_started = time.perf_counter()
             translation_unit = self.index.parse(
                 str(file_path),
                 args=flags,
                 options=TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD
             )
+            self.last_timings['parse'] = time.perf_counter() - parse_started
             
             if translation_unit is None:
                 self.logger.error(f"Failed to parse {file_path}")
                 return None
             
             # Check for parsing errors
+            diagnostics_started = time.perf_counter()
             diagnostics = list(translation_unit.diagnostics)
             if diagnostics:
                 error_count = sum(1 for d in diagnostics if d.severity >= clang.Diagnostic.Error)
@@ -98,6 +149,7 @@ class ASTParser:
                             self.logger.debug(f"  Error: {diag}")
                 elif warning_count > 0:
                     self.logger.debug(f"Parse warnings in {file_path}: {warning_count} warnings")
+            self.last_timings['diagnostics'] = time.perf_counter() - diagnostics_started
             
             self.logger.debug(f"Successfully parsed {file_path}")
             return translation_unit
@@ -171,11 +223,63 @@ class ASTParser:
     def is_in_file(self, cursor: Cursor, target_file: Path) -> bool:
         """Check if a cursor is located in the target file."""
         try:
-            location = cursor.location
-            if location.file:
-                cursor_file = Path(location.file.name).resolve()
-                target_file = target_file.resolve()
-                return cursor_file == target_file
-        except:
-            pass
-        return False
\ No newline at end of file
+            cursor_file = cursor.location.file
+            if cursor_file is None:
+                return False
+            # libclang hands out one CXFile per file and translation unit, so its address
+            # identifies the file without touching the file system again
+            key = (ctypes.cast(cursor_file.obj, ctypes.c_void_p).value, target_file)
+            in_file = self._in_file_cache.get(key)
+            if in_file is None:
+                in_file = self._resolve(cursor_file.name) == self._resolve(target_file)
+                self._in_file_cache[key] = in_file
+            return in_file
+        except Exception:
+            return False
+    
+    def _resolve(self, path) -> str:
+        """Resolved path string, memoized for the lifetime of the parser."""
+        resolved = self._resolved_paths.get(path)
+        if resolved is None:
+            resolved = str(Path(path).resolve())
+            self._resolved_paths[path] = resolved
+        return resolved
+    
+    def lazy_location(self, cursor: Cursor) -> 'CursorLocation':
+        """Location of a cursor whose fields are only read from libclang when accessed."""
+        return CursorLocation(cursor)
+
+
+class CursorLocation(Mapping):
+    """Read-only view of the get_cursor_location fields of a cursor, computed on first access.
+
+    Passes that only need `line` avoid the extent lookups; nothing is read
+    from libclang for a location that never ends up in a record.
+    """
+
+    KEYS = ('file', 'line', 'column', 'start_line', 'end_line', 'start_column', 'end_column')
+
+    def __init__(self, cursor: Cursor):
+        """Wrap a cursor; no libclang calls are made here."""
+        self._cursor = cursor
+        self._fields: Dict[str, Any] = {}
+
+    def __getitem__(self, key: str) -> Any:
+        if key not in self._fields:
+            if key not in self.KEYS:
+                raise KeyError(key)
+            if key in ('file', 'line', 'column'):
+                location = self._cursor.location
+                self._fields.update(file=str(location.file) if location.file else '',
+                                    line=location.line, column=location.column)
+            else:
+                extent = self._cursor.extent
+                self._fields.update(start_line=extent.start.line, end_line=extent.end.line,
+                                    start_column=extent.start.column, end_column=extent.end.column)
+        return self._fields[key]
+
+    def __iter__(self) -> Iterator[str]:
+        return iter(self.KEYS)
+
+    def __len__(self) -> int:
+        return len(self.KEYS)
@@ -0,0 +1,170 @@
+"""
+Benchmark harness.
+
+Runs the extractor on a corpus (usually one written by CorpusGenerator) in
+a child process, repeats the run, and reports throughput (files/s,
+cursors/s), peak memory and output size as JSON. Two result files can be
+compared; metrics that got worse by more than a threshold are flagged as
+regressions so the comparison can gate CI.
+"""
+
+import importlib.metadata
+import json
+import logging
+import os
+import platform
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from datetime import datetime
+from pathlib import Path
+from typing import Dict, List, Any, Optional
+
+from . import __version__
+from .corpus_generator import CorpusGenerator
+
+
+class BenchmarkHarness:
+    """Measures extractor runs and compares benchmark results."""
+
+    RESULT_VERSION = 1
+
+    # Metric name -> True when higher is better
+    METRICS = {
+        'wall_seconds': False,
+        'files_per_second': True,
+        'cursors_per_second': True,
+        'peak_rss_mb': False,
+        'output_bytes': False,
+    }
+
+    def __init__(self, extractor: Optional[Path] = None, extra_args: Optional[List[str]] = None):
+        """Initialize the harness; extractor defaults to the loop_extractor.py next to src/."""
+        self.extractor = (extractor or Path(__file__).parent.parent / 'loop_extractor.py').resolve()
+        self.extra_args = extra_args or []
+        self.logger = logging.getLogger(__name__)
+
+    def run(self, corpus_dir: Path, repeat: int = 3, warmup: int = 1) -> Dict[str, Any]:
+        """Benchmark the extractor on corpus_dir; returns the result document."""
+        if repeat < 1:
+            raise ValueError("repeat must be at least 1")
+
+        runs = []
+        with tempfile.TemporaryDirectory(prefix='loop-bench-') as work_dir:
+            for number in range(warmup + repeat):
+                measured = number >= warmup
+                label = f"run {number - warmup + 1}/{repeat}" if measured else f"warm-up {number + 1}/{warmup}"
+                self.logger.info(f"Benchmark {label} on {corpus_dir}")
+                result = self._run_once(corpus_dir, Path(work_dir) / f'run_{number}.json')
+                if measured:
+                    runs.append(result)
+
+        return {
+            'benchmark_version': self.RESULT_VERSION,
+            'generated_at': datetime.now().isoformat(),
+            'environment': self._environment(),
+            'corpus': self._corpus_info(corpus_dir),
+            'extra_args': self.extra_args,
+            'runs': runs,
+            # Median, so one noisy run does not decide a comparison
+            'summary': {name: round(statistics.median(run[name] for run in runs), 3) for name in self.METRICS},
+        }
+
+    def _run_once(self, corpus_dir: Path, output_path: Path) -> Dict[str, Any]:
+        """One extractor run in a child process."""
+        # The child runs in the work directory (so its log lands there); paths must not be relative
+        corpus_dir, output_path = corpus_dir.resolve(), output_path.resolve()
+        command = [sys.executable, str(self.extractor), str(corpus_dir), '-o', str(output_path),
+                   '--log-level', 'WARNING'] + self.extra_args
+
+        started = time.perf_counter()
+        completed = subprocess.run(command, cwd=output_path.parent, capture_output=True, text=True)
+        wall_seconds = time.perf_counter() - started
+        if completed.returncode != 0 or not output_path.exists():
+            raise RuntimeError(f"Extractor failed with exit code {completed.returncode}: "
+                               f"{completed.stderr.strip() or completed.stdout.strip()}")
+
+        with open(output_path, 'r', encoding='utf-8') as f:
+            metadata = json.load(f)['metadata']
+        performance = metadata.get('performance', {})
+        files = metadata.get('total_files_scanned', 0)
+        cursors = performance.get('cursors_visited', 0)
+
+        return {
+            'wall_seconds': round(wall_seconds, 3),
+            'files': files,
+            'loops': metadata.get('total_loops_found', 0),
+            'cursors': cursors,
+            'files_per_second': round(files / wall_seconds, 3) if wall_seconds else 0.0,
+            'cursors_per_second': round(cursors / wall_seconds, 1) if wall_seconds else 0.0,
+            'peak_rss_mb': performance.get('peak_rss_mb') or 0.0,
+            'output_bytes': output_path.stat().st_size,
+            'phases': performance.get('phases', {}),
+        }
+
+    def _corpus_info(self, corpus_dir: Path) -> Dict[str, Any]:
+        """Generator manifest of the corpus, or just its path for hand-written corpora."""
+        info: Dict[str, Any] = {'path': str(corpus_dir)}
+        manifest_path = corpus_dir / CorpusGenerator.MANIFEST_NAME
+        if manifest_path.exists():
+            with open(manifest_path, 'r', encoding='utf-8') as f:
+                manifest = json.load(f)
+            info.update({key: manifest[key] for key in ('parameters', 'source_files', 'lines', 'digest')})
+        return info
+
+    def _environment(self) -> Dict[str, Any]:
+        """Machine and tool versions the numbers were measured with."""
+        environment = {
+            'tool_version': __version__,
+            'python': platform.python_version(),
+            'platform': platform.platform(),
+            'processor': platform.processor() or platform.machine(),
+            'cpu_count': os.cpu_count(),
+        }
+        try:
+            environment['libclang'] = importlib.metadata.version('libclang')
+        except importlib.metadata.PackageNotFoundError:
+            pass
+        return environment
+
+    def write(self, result: Dict[str, Any], output_path: Path) -> None:
+        """Write a result document."""
+        output_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(output_path, 'w', encoding='utf-8') as f:
+            json.dump(result, f, indent=2)
+            f.write('\n')
+        self.logger.info(f"Benchmark results written to: {output_path}")
+
+    def compare(self, baseline: Dict[str, Any], current: Dict[str, Any], threshold: float = 10.0) -> Dict[str, Any]:
+        """Compare two result documents; a metric regresses when it is worse by more than threshold percent."""
+        warnings = []
+        if baseline.get('corpus', {}).get('digest') != current.get('corpus', {}).get('digest'):
+            warnings.append('corpus differs between runs; numbers are not directly comparable')
+        if baseline.get('extra_args') != current.get('extra_args'):
+            warnings.append('extractor arguments differ between runs')
+        if baseline.get('environment', {}).get('platform') != current.get('environment', {}).get('platform'):
+            warnings.append('runs were measured on different platforms')
+
+        metrics = {}
+        for name, higher_is_better in self.METRICS.items():
+            before = baseline['summary'].get(name)
+            after = current['summary'].get(name)
+            if not before or after is None:
+                continue
+            change = (after - before) / before * 100.0
+            worse_by = -change if higher_is_better else change
+            metrics[name] = {
+                'baseline': before,
+                'current': after,
+                'change_percent': round(change, 1),
+                'regression': worse_by > threshold,
+            }
+
+        return {
+            'threshold_percent': threshold,
+            'warnings': warnings,
+            'metrics': metrics,
+            'regressions': [name for name, metric in metrics.items() if metric['regression']],
+        }
@@ -0,0 +1,212 @@
+"""
+Call-graph export module.
+
+Builds a caller -> callee graph from the call sites recorded in loop bodies
+and writes it as Graphviz DOT or GraphML. Edges are weighted by how often
+their call sites run (call-site count x loop-nest multiplicity); nodes are
+colored by the cost of the function's own loops.
+"""
+
+import logging
+import math
+import xml.etree.ElementTree as ET
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+from .loop_index import LoopIndex
+from .loop_cost import LoopCostModel
+
+
+class CallGraphExporter:
+    """Exports loop call sites as a weighted call graph."""
+
+    FORMATS = ('dot', 'graphml')
+
+    # ColorBrewer Reds, light to dark; nodes are bucketed on a log scale of loop cost
+    COST_COLORS = ['#fff5f0', '#fee0d2', '#fcbba1', '#fc9272', '#fb6a4a',
+                   '#ef3b2c', '#cb181d', '#a50f15', '#67000d']
+
+    def __init__(self, default_iterations: int = 100, min_weight: float = 0.0,
+                 min_cost: Optional[float] = None, include_external: bool = False):
+        """Initialize the exporter.
+
+        Args:
+            default_iterations: trip count assumed when none is known
+            min_weight: drop edges whose weight is below this value
+            min_cost: keep nodes without remaining edges if their loop cost reaches this value
+            include_external: keep callees that are not defined in the analyzed sources
+        """
+        self.cost_model = LoopCostModel(default_iterations)
+        self.min_weight = min_weight
+        self.min_cost = min_cost
+        self.include_external = include_external
+        self.logger = logging.getLogger(__name__)
+
+    def build(self, analysis_results: Dict[str, Any]) -> Tuple[Dict[str, Dict[str, Any]], Dict[Tuple[str, str], Dict[str, Any]]]:
+        """Return (nodes by id, edges by (caller id, callee id)) before filtering."""
+        index = LoopIndex(analysis_results)
+        nodes: Dict[str, Dict[str, Any]] = {}
+        edges: Dict[Tuple[str, str], Dict[str, Any]] = {}
+
+        def node_for(file_path: str, function_name: str, external: bool = False) -> str:
+            node_id = function_name if external else f"{file_path}:{function_name or '<global>'}"
+            nodes.setdefault(node_id, {
+                'name': function_name or '<global>',
+                'file': file_path,
+                'loop_cost': 0.0,
+                'loops': 0,
+                'external': external,
+            })
+            return node_id
+
+        def walk(caller: str, loops: List[Dict[str, Any]], parent_executions: float, depth: int) -> None:
+            for loop in loops:
+                executions = self.cost_model.executions(loop, parent_executions)
+                nodes[caller]['loop_cost'] += executions * self.cost_model.body_cost(loop)
+                nodes[caller]['loops'] += 1
+
+                for call in loop.get('function_calls', []):
+                    name = call.get('function', '')
+                    if not name:
+                        continue
+                    callee = index.resolve_function(name, call.get('definition_file', ''))
+                    if callee is not None:
+                        callee_id = node_for(*callee)
+                    elif self.include_external:
+                        callee_id = node_for(call.get('definition_file', ''), name, external=True)
+                    else:
+                        continue
+
+                    edge = edges.setdefault((caller, callee_id), {
+                        'call_sites': 0,
+                        'weight': 0.0,
+                        'max_nesting': 0,
+                    })
+                    edge['call_sites'] += 1
+                    edge['weight'] += executions
+                    edge['max_nesting'] = max(edge['max_nesting'], depth)
+
+                walk(caller, loop.get('nested_loops', []), executions, depth + 1)
+
+        for file_path, function_name, loops in index.iter_functions():
+            caller = node_for(file_path, function_name)
+            walk(caller, loops, 1.0, 1)
+
+        return nodes, edges
+
+    def filter(self, nodes: Dict[str, Dict[str, Any]], edges: Dict[Tuple[str, str], Dict[str, Any]]):
+        """Drop light edges, then nodes left without edges unless their loops are costly enough."""
+        kept_edges = {key: edge for key, edge in edges.items() if edge['weight'] >= self.min_weight}
+        connected = {node_id for key in kept_edges for node_id in key}
+        kept_nodes = {}
+        for node_id, node in nodes.items():
+            if node_id in connected:
+                kept_nodes[node_id] = node
+            elif self.min_cost is not None and node['loop_cost'] >= self.min_cost and node['loops']:
+                kept_nodes[node_id] = node
+        return kept_nodes, kept_edges
+
+    def export(self, analysis_results: Dict[str, Any], output_paths: List[Path],
+               output_format: Optional[str] = None) -> Dict[str, Any]:
+        """Build, filter and write the graph to each output path; returns a run summary."""
+        nodes, edges = self.build(analysis_results)
+        kept_nodes, kept_edges = self.filter(nodes, edges)
+
+        for output_path in output_paths:
+            graph_format = output_format or self.detect_format(output_path)
+            output_path.parent.mkdir(parents=True, exist_ok=True)
+            if graph_format == 'dot':
+                output_path.write_text(self.to_dot(kept_nodes, kept_edges), encoding='utf-8')
+            elif graph_format == 'graphml':
+                self.write_graphml(kept_nodes, kept_edges, output_path)
+            else:
+                raise ValueError(f"Unsupported graph format: {graph_format}")
+            self.logger.info(f"Call graph with {len(kept_nodes)} nodes and {len(kept_edges)} edges "
+                             f"written to: {output_path}")
+
+        return {
+            'nodes': len(nodes),
+            'edges': len(edges),
+            'nodes_kept': len(kept_nodes),
+            'edges_kept': len(kept_edges),
+        }
+
+    def detect_format(self, output_path: Path) -> str:
+        """Pick the format from the file extension; DOT is the default."""
+        return 'graphml' if output_path.suffix.lower() in {'.graphml', '.xml'} else 'dot'
+
+    def to_dot(self, nodes: Dict[str, Dict[str, Any]], edges: Dict[Tuple[str, str], Dict[str, Any]]) -> str:
+        """Render the graph as Graphviz DOT."""
+        lines = [
+            'digraph loop_call_graph {',
+            '    rankdir=LR;',
+            '    node [shape=box, style="rounded,filled", fontname="Helvetica", fontsize=10];',
+            '    edge [fontname="Helvetica", fontsize=8];',
+        ]
+        max_cost = max((node['loop_cost'] for node in nodes.values()), default=0.0)
+        for node_id, node in sorted(nodes.items()):
+            color = self._cost_color(node['loop_cost'], max_cost)
+            font = 'white' if self.COST_COLORS.index(color) >= 6 else 'black'
+            tooltip = f"{node['file']}: {node['loops']} loops, cost {node['loop_cost']:.0f}"
+            style = ', style="rounded,filled,dashed"' if node['external'] else ''
+            lines.append(f'    {self._dot_id(node_id)} [label={self._dot_id(node["name"])}, '
+                         f'fillcolor="{color}", fontcolor={font}, tooltip={self._dot_id(tooltip)}{style}];')
+
+        max_weight = max((edge['weight'] for edge in edges.values()), default=1.0)
+        for (caller, callee), edge in sorted(edges.items()):
+            width = 1.0 + 4.0 * math.log1p(edge['weight']) / math.log1p(max_weight) if max_weight > 0 else 1.0
+            label = f"{edge['weight']:.0f} ({edge['call_sites']} sites)"
+            lines.append(f'    {self._dot_id(caller)} -> {self._dot_id(callee)} '
+                         f'[label={self._dot_id(label)}, penwidth={width:.2f}, weight={max(1, int(edge["weight"]))}];')
+        lines.append('}')
+        return '\n'.join(lines) + '\n'
+
+    def write_graphml(self, nodes: Dict[str, Dict[str, Any]], edges: Dict[Tuple[str, str], Dict[str, Any]],
+                      output_path: Path) -> None:
+        """Write the graph as GraphML with node and edge attributes."""
+        namespace = 'http://graphml.graphdrawing.org/xmlns'
+        ET.register_namespace('', namespace)
+        root = ET.Element(f'{{{namespace}}}graphml')
+
+        attributes = [
+            ('name', 'node', 'string'), ('file', 'node', 'string'), ('loop_cost', 'node', 'double'),
+            ('loops', 'node', 'int'), ('external', 'node', 'boolean'), ('color', 'node', 'string'),
+            ('weight', 'edge', 'double'), ('call_sites', 'edge', 'int'), ('max_nesting', 'edge', 'int'),
+        ]
+        for name, domain, attr_type in attributes:
+            ET.SubElement(root, f'{{{namespace}}}key', {
+                'id': name, 'for': domain, 'attr.name': name, 'attr.type': attr_type,
+            })
+
+        graph = ET.SubElement(root, f'{{{namespace}}}graph', {'id': 'loop_call_graph', 'edgedefault': 'directed'})
+        max_cost = max((node['loop_cost'] for node in nodes.values()), default=0.0)
+        for node_id, node in sorted(nodes.items()):
+            element = ET.SubElement(graph, f'{{{namespace}}}node', {'id': node_id})
+            values = dict(node, color=self._cost_color(node['loop_cost'], max_cost))
+            for name in ('name', 'file', 'loop_cost', 'loops', 'external', 'color'):
+                data = ET.SubElement(element, f'{{{namespace}}}data', {'key': name})
+                value = values[name]
+                data.text = str(value).lower() if isinstance(value, bool) else str(value)
+
+        for number, ((caller, callee), edge) in enumerate(sorted(edges.items())):
+            element = ET.SubElement(graph, f'{{{namespace}}}edge', {
+                'id': f'e{number}', 'source': caller, 'target': callee,
+            })
+            for name in ('weight', 'call_sites', 'max_nesting'):
+                data = ET.SubElement(element, f'{{{namespace}}}data', {'key': name})
+                data.text = str(edge[name])
+
+        tree = ET.ElementTree(root)
+        ET.indent(tree)
+        tree.write(output_path, encoding='utf-8', xml_declaration=True)
+
+    def _cost_color(self, cost: float, max_cost: float) -> str:
+        """Bucket a node's loop cost on a log scale relative to the costliest node."""
+        if cost <= 0 or max_cost <= 0:
+            return self.COST_COLORS[0]
+        fraction = math.log1p(cost) / math.log1p(max_cost)
+        return self.COST_COLORS[min(len(self.COST_COLORS) - 1, int(fraction * (len(self.COST_COLORS) - 1) + 0.5))]
+
+    def _dot_id(self, value: str) -> str:
+        """Quote a DOT identifier or label."""
+        return '"' + value.replace('\\', '\\\\').replace('"', '\\"') + '"'
@@ -2,9 +2,13 @@
 Configuration management for Loop Extractor.
 """
 
+import os
 from dataclasses import dataclass
+from functools import cached_property
 from pathlib import Path
-from typing import List
+from typing import List, Optional
+
+from .path_filter import PathFilter
 
 
 @dataclass
@@ -18,6 +22,25 @@ class Config:
     cpp_standard: str
     log_level: str
     
+    # Optional LLVM IR backend (see llvm_backend.py)
+    llvm_backend: bool = False
+    clang_path: str = 'clang'
+    opt_path: str = 'opt'
+    
+    # Analysis passes to run (see analysis_passes.py); None runs the default passes
+    passes: Optional[List[str]] = None
+    
+    # Per-file budgets (see file_supervisor.py); 0 analyzes files in-process without limits
+    file_timeout: float = 0.0
+    file_memory_limit_mb: int = 0
+    
+    # Clang index recycling (see ASTParser.dispose); 0 disables the respective trigger
+    index_recycle_files: int = 200
+    index_recycle_rss_mb: int = 0
+    
+    # File discovery (see file_discovery.py): 'walk' the tree or list files with 'git' ls-files
+    discovery: str = 'walk'
+    
     # Default file extensions to search for
     DEFAULT_EXTENSIONS = {'.c', '.cpp', '.cc', '.cxx', '.h', '.hpp', '.hxx'}
     
@@ -37,9 +60,21 @@ class Config:
         'c++20': ['-std=c++20'],
     }
     
-    def get_compiler_flags(self) -> List[str]:
-        """Get compiler flags for the specified C++ standard."""
-        flags = self.STANDARD_FLAGS.get(self.cpp_standard, ['-std=c++17'])
+    # C standard used for .c files, by the selected C++ standard
+    C_STANDARD_FLAGS = {
+        'c++11': ['-std=c11'],
+        'c++14': ['-std=c11'],
+        'c++17': ['-std=c17'],
+        'c++20': ['-std=c17'],
+    }
+    
+    def get_compiler_flags(self, file_path: Optional[Path] = None) -> List[str]:
+        """Get compiler flags for the specified C++ standard (its C counterpart for a .c file_path)."""
+        # Copy so callers appending file-specific flags don't modify the shared defaults
+        if file_path is not None and file_path.suffix == '.c':
+            flags = list(self.C_STANDARD_FLAGS.get(self.cpp_standard, ['-std=c17']))
+        else:
+            flags = list(self.STANDARD_FLAGS.get(self.cpp_standard, ['-std=c++17']))
         
         # Add default include directories (avoid duplicates)
         added_includes = set()
@@ -50,24 +85,16 @@ class Config:
         
         return flags
     
+    @cached_property
+    def path_filter(self) -> PathFilter:
+        """Include/exclude patterns compiled once (see path_filter.py)."""
+        return PathFilter(self.include_patterns, self.exclude_patterns)
+    
     def should_include_file(self, file_path: Path) -> bool:
-        """Check if a file should be included based on patterns."""
-        file_str = str(file_path)
-        
-        # Check extension
+        """Check if a file should be included based on extension and patterns."""
         if file_path.suffix not in self.DEFAULT_EXTENSIONS:
             return False
         
-        # Check exclude patterns
-        for pattern in self.exclude_patterns:
-            if pattern in file_str:
-                return False
-        
-        # Check include patterns (if specified)
-        if self.include_patterns:
-            for pattern in self.include_patterns:
-                if pattern in file_str:
-                    return True
-            return False
-        
-        return True
\ No newline at end of file
+        file_str = str(file_path)
+        relative = os.path.relpath(file_str, self.source_path).replace(os.sep, '/')
+        return self.path_filter.includes_file(file_str, relative)
\ No newline at end of file
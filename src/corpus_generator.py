@@ -0,0 +1,233 @@
+"""
+Synthetic corpus generator.
+
+Writes a deterministic C++ code base with tunable loop structure, used by
+the benchmark harness to measure the extractor on inputs of known shape.
+The same parameters and seed always produce byte-identical files; the
+manifest records both and a digest of the contents so benchmark results
+can be tied to the corpus they were measured on.
+
+Generated files include only `corpus_common.hh`, which defines the loop
+macros and small ObjexxFCL-style array classes (1-based, indexed with
+operator()), so parsing does not depend on system headers.
+"""
+
+import hashlib
+import json
+import logging
+import random
+from dataclasses import dataclass, asdict
+from pathlib import Path
+from typing import Dict, List, Any, Optional
+
+
+@dataclass
+class CorpusParameters:
+    """Knobs of a synthetic corpus."""
+
+    files: int = 20
+    functions_per_file: int = 8
+    loop_depth: int = 3
+    body_size: int = 6
+    macro_density: float = 0.2
+    objexx_density: float = 0.3
+    seed: int = 1
+
+    def validate(self) -> None:
+        """Raise ValueError for out-of-range knobs."""
+        for name in ('files', 'functions_per_file', 'loop_depth', 'body_size'):
+            if getattr(self, name) < 1:
+                raise ValueError(f"{name} must be at least 1")
+        if self.loop_depth > len(CorpusGenerator.LOOP_VARIABLES):
+            raise ValueError(f"loop_depth must be at most {len(CorpusGenerator.LOOP_VARIABLES)}")
+        for name in ('macro_density', 'objexx_density'):
+            if not 0.0 <= getattr(self, name) <= 1.0:
+                raise ValueError(f"{name} must be between 0 and 1")
+
+
+COMMON_HEADER = """\
+// Generated by loop_extractor.py generate-corpus; do not edit.
+#ifndef CORPUS_COMMON_HH
+#define CORPUS_COMMON_HH
+
+#define CORPUS_FOR(i, lo, hi) for (int i = (lo); i < (hi); ++i)
+#define CORPUS_FOR_STEP(i, lo, hi, s) for (int i = (lo); i < (hi); i += (s))
+#define CORPUS_AXPY(y, a, x, i) ((y)[i] += (a) * (x)[i])
+#define CORPUS_SQR(x) ((x) * (x))
+
+namespace corpus {
+
+// Minimal stand-ins for ObjexxFCL arrays: 1-based, column-major, operator() indexing
+template <typename T>
+class Array1D {
+public:
+    explicit Array1D(int n) : n_(n), data_(new T[n]()) {}
+    ~Array1D() { delete[] data_; }
+    T &operator()(int i) { return data_[i - 1]; }
+    const T &operator()(int i) const { return data_[i - 1]; }
+    int size() const { return n_; }
+    int l() const { return 1; }
+    int u() const { return n_; }
+private:
+    int n_;
+    T *data_;
+};
+
+template <typename T>
+class Array2D {
+public:
+    Array2D(int n1, int n2) : n1_(n1), n2_(n2), data_(new T[n1 * n2]()) {}
+    ~Array2D() { delete[] data_; }
+    T &operator()(int i, int j) { return data_[(j - 1) * n1_ + (i - 1)]; }
+    const T &operator()(int i, int j) const { return data_[(j - 1) * n1_ + (i - 1)]; }
+    int size1() const { return n1_; }
+    int size2() const { return n2_; }
+private:
+    int n1_;
+    int n2_;
+    T *data_;
+};
+
+} // namespace corpus
+
+#endif
+"""
+
+
+class CorpusGenerator:
+    """Generates a synthetic loop corpus from CorpusParameters."""
+
+    HEADER_NAME = 'corpus_common.hh'
+    MANIFEST_NAME = 'corpus.json'
+
+    LOOP_KINDS = ('for', 'for', 'for', 'while', 'do_while', 'step')
+    # Loop variables by nesting level; avoids the parameter names x, y, m, n
+    LOOP_VARIABLES = 'ijklpqrs'
+
+    def __init__(self, parameters: CorpusParameters):
+        """Initialize the generator; all randomness comes from parameters.seed."""
+        parameters.validate()
+        self.parameters = parameters
+        self.logger = logging.getLogger(__name__)
+
+    def generate(self, output_dir: Path) -> Dict[str, Any]:
+        """Write the corpus and its manifest to output_dir; returns the manifest."""
+        output_dir.mkdir(parents=True, exist_ok=True)
+        files = {self.HEADER_NAME: COMMON_HEADER}
+        for index in range(self.parameters.files):
+            files[f'module_{index:04d}.cpp'] = self.render_file(index)
+
+        digest = hashlib.sha256()
+        lines = 0
+        for name in sorted(files):
+            content = files[name]
+            (output_dir / name).write_text(content, encoding='utf-8')
+            digest.update(name.encode('utf-8') + b'\0' + content.encode('utf-8'))
+            lines += content.count('\n')
+
+        manifest = {
+            'parameters': asdict(self.parameters),
+            'files': sorted(files),
+            'source_files': self.parameters.files,
+            'lines': lines,
+            'bytes': sum(len(content.encode('utf-8')) for content in files.values()),
+            'digest': digest.hexdigest(),
+        }
+        with open(output_dir / self.MANIFEST_NAME, 'w', encoding='utf-8') as f:
+            json.dump(manifest, f, indent=2)
+            f.write('\n')
+
+        self.logger.info(f"Generated {self.parameters.files} files ({lines} lines) in {output_dir}")
+        return manifest
+
+    def render_file(self, index: int) -> str:
+        """Source text of one translation unit; depends only on the parameters and index."""
+        # Seeded per file so a file does not change when the file count does
+        rng = random.Random(f'{self.parameters.seed}:{index}')
+        objexx = [rng.random() < self.parameters.objexx_density for _ in range(self.parameters.functions_per_file)]
+        functions = [self._render_function(rng, index, number, objexx) for number in range(len(objexx))]
+        return (f'// Generated by loop_extractor.py generate-corpus (seed {self.parameters.seed}); do not edit.\n'
+                f'#include "{self.HEADER_NAME}"\n\n'
+                f'namespace module_{index:04d} {{\n\n' + '\n'.join(functions) + '\n} // namespace\n')
+
+    def _render_function(self, rng: random.Random, file_index: int, number: int, objexx_flags: List[bool]) -> str:
+        """One function whose body is a loop nest of random depth, possibly calling an earlier function."""
+        objexx = objexx_flags[number]
+        # Only earlier functions with the same array style can be called
+        callees = [earlier for earlier in range(number) if objexx_flags[earlier] == objexx]
+        callee = None
+        if callees and rng.random() < 0.3:
+            callee = f'kernel_{file_index:04d}_{rng.choice(callees):02d}'
+        name = f'kernel_{file_index:04d}_{number:02d}'
+        if objexx:
+            signature = (f'void {name}(corpus::Array1D<double> &x, corpus::Array1D<double> &y, '
+                         f'corpus::Array2D<double> &m, int n, double alpha)')
+        else:
+            signature = f'void {name}(double *x, double *y, double *m, int n, double alpha)'
+
+        lines = [signature, '{', '    double acc = 0.0;']
+        depth = rng.randint(1, self.parameters.loop_depth)
+        lines += self._render_loop(rng, level=0, depth=depth, objexx=objexx, callee=callee, indent='    ')
+        lines += ['    y(1) = acc;' if objexx else '    y[0] = acc;', '}', '']
+        return '\n'.join(lines)
+
+    def _render_loop(self, rng: random.Random, level: int, depth: int, objexx: bool,
+                     callee: Optional[str], indent: str) -> List[str]:
+        """A loop at the given nesting level with nested loops down to depth."""
+        var = self.LOOP_VARIABLES[level]
+        lower, upper = ('1', 'n + 1') if objexx else ('0', 'n')
+        macro = rng.random() < self.parameters.macro_density
+        kind = rng.choice(self.LOOP_KINDS)
+        inner = indent + '    '
+
+        body = self._render_body(rng, level, objexx, inner)
+        if level + 1 < depth:
+            body += self._render_loop(rng, level + 1, depth, objexx, callee, inner)
+        if callee and level + 1 == depth:
+            args = 'x, y, m, n, alpha * 0.5'
+            body.append(f'{inner}if (alpha > 1.0e6) {callee}({args});')
+
+        if macro and kind in ('for', 'step'):
+            if kind == 'step':
+                header = f'{indent}CORPUS_FOR_STEP({var}, {lower}, {upper}, {rng.choice((2, 4))}) {{'
+            else:
+                header = f'{indent}CORPUS_FOR({var}, {lower}, {upper}) {{'
+            return [header] + body + [f'{indent}}}']
+        if kind == 'while':
+            return ([f'{indent}int {var} = {lower};', f'{indent}while ({var} < {upper}) {{'] + body +
+                    [f'{inner}++{var};', f'{indent}}}'])
+        if kind == 'do_while':
+            return ([f'{indent}int {var} = {lower};', f'{indent}if (n > 0) do {{'] + body +
+                    [f'{inner}++{var};', f'{indent}}} while ({var} < {upper});'])
+        step = f'{var} += {rng.choice((2, 4))}' if kind == 'step' else f'++{var}'
+        return [f'{indent}for (int {var} = {lower}; {var} < {upper}; {step}) {{'] + body + [f'{indent}}}']
+
+    def _render_body(self, rng: random.Random, level: int, objexx: bool, indent: str) -> List[str]:
+        """body_size statements using the loop variables in scope."""
+        variables = self.LOOP_VARIABLES[:level + 1]
+        var = variables[-1]
+        outer = variables[0]
+        macro = rng.random() < self.parameters.macro_density
+
+        if objexx:
+            x, y = f'x({var})', f'y({var})'
+            matrix = f'm({outer}, {var})'
+        else:
+            x, y = f'x[{var}]', f'y[{var}]'
+            matrix = f'm[{outer} * n + {var}]'
+
+        templates = [
+            f'acc += {x} * {y};',
+            f'{y} = alpha * {x} + {y};',
+            f'acc += {matrix} * {x};',
+            f'{matrix} = {matrix} * 0.5 + acc;',
+            f'if ({x} > acc) acc = {x};',
+            f'acc -= {var} % 3 == 0 ? {y} : 0.0;',
+            f'{y} += ({x} - {y}) / ({var} + 1);',
+        ]
+        if macro:
+            templates.append(f'acc += CORPUS_SQR({x});')
+            if not objexx:
+                templates.append(f'CORPUS_AXPY(y, alpha, x, {var});')
+
+        return [indent + rng.choice(templates) for _ in range(self.parameters.body_size)]
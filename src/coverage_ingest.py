@@ -0,0 +1,164 @@
+"""
+Coverage ingestion module for measuring loop trip counts from line execution counts.
+
+Supported inputs:
+  - gcov JSON (`gcov --json-format`, plain or gzip-compressed)
+  - `llvm-cov export` JSON
+"""
+
+import gzip
+import json
+import logging
+from collections import Counter
+from pathlib import Path
+from typing import Dict, List, Any, Optional
+
+from .loop_index import LoopIndex
+
+
+class CoverageIngest:
+    """Derives measured trip counts from loop header and body execution counts."""
+
+    def __init__(self):
+        self.logger = logging.getLogger(__name__)
+        # (file, line) -> execution count, summed over all ingested files
+        self.line_counts: Counter = Counter()
+        self.sources: List[str] = []
+
+    def load(self, coverage_path: Path) -> None:
+        """Load one gcov or llvm-cov JSON file and merge its line counts."""
+        opener = gzip.open if coverage_path.suffix == '.gz' else open
+        with opener(coverage_path, 'rt', encoding='utf-8') as f:
+            data = json.load(f)
+
+        if 'data' in data and data.get('type', '').startswith('llvm.coverage'):
+            self._load_llvm_cov(data)
+            self.sources.append('llvm-cov')
+        elif 'files' in data:
+            self._load_gcov(data)
+            self.sources.append('gcov')
+        else:
+            raise ValueError(f"Unrecognized coverage format in {coverage_path}")
+
+        self.logger.debug(f"Loaded coverage from {coverage_path}")
+
+    def _load_gcov(self, data: Dict[str, Any]) -> None:
+        """Merge line counts from gcov's JSON intermediate format."""
+        cwd = data.get('current_working_directory', '')
+        for file_data in data.get('files', []):
+            file_name = file_data.get('file', '')
+            if cwd and not Path(file_name).is_absolute():
+                file_name = str(Path(cwd) / file_name)
+
+            for line in file_data.get('lines', []):
+                self.line_counts[(file_name, line['line_number'])] += line.get('count', 0)
+
+    def _load_llvm_cov(self, data: Dict[str, Any]) -> None:
+        """Merge line counts from `llvm-cov export` segments.
+
+        A line's count is the highest count among the regions active on it,
+        matching what `llvm-cov show` displays.
+        """
+        for export in data.get('data', []):
+            for file_data in export.get('files', []):
+                file_name = file_data.get('filename', '')
+                segments = file_data.get('segments', [])
+                line_counts: Dict[int, int] = {}
+                active: Optional[int] = None
+
+                for i, segment in enumerate(segments):
+                    line, _, count, has_count = segment[0], segment[1], segment[2], segment[3]
+                    active = count if has_count else None
+                    next_line = segments[i + 1][0] if i + 1 < len(segments) else line
+                    if active is None:
+                        continue
+                    for covered_line in range(line, max(line, next_line) + 1):
+                        line_counts[covered_line] = max(line_counts.get(covered_line, 0), active)
+
+                for line, count in line_counts.items():
+                    self.line_counts[(file_name, line)] += count
+
+    def annotate(self, analysis_results: Dict[str, Any]) -> Dict[str, Any]:
+        """Replace estimated iterations with measured trip counts; returns a run summary."""
+        index = LoopIndex(analysis_results)
+
+        # Re-key counts by analyzed file so loop lookups are plain dict hits
+        counts_by_file: Dict[str, Dict[int, int]] = {}
+        for (file_name, line), count in self.line_counts.items():
+            file_key = index.resolve_file(file_name)
+            if file_key is not None:
+                lines = counts_by_file.setdefault(file_key, {})
+                lines[line] = lines.get(line, 0) + count
+
+        measured = 0
+        not_executed = 0
+        for file_path, _, loop in index.iter_loops():
+            trip_info = self._measure_loop(loop, counts_by_file.get(file_path, {}))
+            if trip_info is None:
+                continue
+
+            loop.setdefault('extensions', {})['coverage'] = trip_info
+            if trip_info['entries'] > 0:
+                loop['loop_bounds']['estimated_iterations'] = trip_info['average_trip_count']
+                measured += 1
+            else:
+                not_executed += 1
+
+        summary = {
+            'sources': sorted(set(self.sources)),
+            'lines_with_counts': len(self.line_counts),
+            'loops_measured': measured,
+            'loops_not_executed': not_executed,
+        }
+        self.logger.info(f"Measured trip counts for {measured} loops ({not_executed} never executed)")
+        return summary
+
+    def _measure_loop(self, loop: Dict[str, Any], line_counts: Dict[int, int]) -> Optional[Dict[str, Any]]:
+        """Estimate entries and iterations of one loop from its line counts."""
+        location = loop.get('location', {})
+        start_line = location.get('start_line', 0)
+        end_line = location.get('end_line', 0)
+
+        header_count = line_counts.get(start_line)
+        if header_count is None:
+            return None
+
+        # The first counted statement of the body runs once per iteration. When
+        # that statement is itself a loop, its header count also includes the
+        # inner iterations, so use the inner loop's entries instead.
+        nested_by_line = {
+            nested.get('location', {}).get('start_line'): nested
+            for nested in loop.get('nested_loops', [])
+        }
+        body_count = None
+        for line in range(start_line + 1, end_line + 1):
+            if line in line_counts:
+                body_count = line_counts[line]
+                if line in nested_by_line:
+                    nested_info = self._measure_loop(nested_by_line[line], line_counts)
+                    if nested_info is not None:
+                        body_count = nested_info['entries']
+                break
+
+        if body_count is None:
+            return None
+
+        if loop.get('type') == 'do_while_loop':
+            # `do {` is reached once per entry; the body runs at least once
+            entries = header_count
+        elif header_count > body_count:
+            # gcov counts the condition once per test: iterations + entries
+            entries = header_count - body_count
+        else:
+            # llvm-cov style: the header line reflects entries only
+            entries = header_count
+
+        average = round(body_count / entries, 2) if entries else 0
+
+        return {
+            'header_count': header_count,
+            'body_count': body_count,
+            'entries': entries,
+            'iterations': body_count,
+            'average_trip_count': average,
+        }
@@ -1,10 +1,18 @@
 """
 File discovery module for finding C/C++ source files.
+
+The tree is walked with os.scandir, which reports entry types from the
+directory listing instead of a stat per entry, or listed with
+`git ls-files` (--discovery git), which honours .gitignore and never
+touches ignored build trees. Include/exclude patterns are compiled once
+(see path_filter.py).
 """
 
 import logging
+import os
+import subprocess
 from pathlib import Path
-from typing import List, Set
+from typing import Dict, List, Optional, Tuple
 
 from .config import Config
 
@@ -12,17 +20,38 @@ from .config import Config
 class FileDiscovery:
     """Handles discovery of C/C++ source files in a directory tree."""
     
+    # Version control, build output and tool directories never walked
+    SKIP_DIRECTORIES = {
+        '.git', '.svn', '.hg',  # Version control
+        'build', 'builds', 'Build', 'BUILD',  # Build directories
+        'cmake-build-debug', 'cmake-build-release',  # CMake build dirs
+        'out', 'output', 'bin', 'obj',  # Output directories
+        '.vscode', '.idea',  # IDE directories
+        'node_modules',  # Node.js
+        '__pycache__', '.pytest_cache',  # Python
+        'target',  # Rust/Java
+        '.vs',  # Visual Studio
+    }
+    
     def __init__(self, config: Config):
         """Initialize file discovery with configuration."""
         self.config = config
         self.logger = logging.getLogger(__name__)
+        # Relative directory -> whether it or a parent is skipped, for is_source_file
+        self._skipped_directories: Dict[str, bool] = {}
     
     def discover_files(self) -> List[Path]:
         """Discover all C/C++ source files in the configured path."""
         discovered_files = []
         
         try:
-            discovered_files = self._traverse_directory(self.config.source_path)
+            if self.config.discovery == 'git':
+                discovered_files = self._list_git_files(self.config.source_path)
+                if discovered_files is None:
+                    self.logger.warning(f"git ls-files failed in {self.config.source_path}; walking the directory tree")
+                    discovered_files = self._traverse_directory(self.config.source_path)
+            else:
+                discovered_files = self._traverse_directory(self.config.source_path)
             self.logger.info(f"Discovered {len(discovered_files)} source files")
             
         except Exception as e:
@@ -31,72 +60,136 @@ class FileDiscovery:
         return discovered_files
     
     def _traverse_directory(self, directory: Path) -> List[Path]:
-        """Recursively traverse directory to find source files."""
+        """Walk the tree with os.scandir, in name order: a directory's files, then its subdirectories.
+        
+        Entry types come from the directory listing, so only symlinks cost a stat.
+        """
         files = []
+        extensions = self.config.DEFAULT_EXTENSIONS
+        path_filter = self.config.path_filter
+        visited = {os.path.realpath(directory)}
+        # (path, path relative to the scan root or '' for the root)
+        pending = [(str(directory), '')]
         
-        try:
-            for item in directory.iterdir():
-                if item.is_file():
-                    if self.config.should_include_file(item):
-                        files.append(item)
-                        self.logger.debug(f"Including file: {item}")
-                    else:
-                        self.logger.debug(f"Excluding file: {item}")
-                        
-                elif item.is_dir():
-                    # Skip hidden directories and common build directories
-                    if self._should_skip_directory(item):
-                        self.logger.debug(f"Skipping directory: {item}")
-                        continue
-                        
-                    # Recursively process subdirectory
-                    try:
-                        subdir_files = self._traverse_directory(item)
-                        files.extend(subdir_files)
-                    except PermissionError:
-                        self.logger.warning(f"Permission denied accessing directory: {item}")
-                    except Exception as e:
-                        self.logger.warning(f"Error accessing directory {item}: {e}")
-                        
-        except PermissionError:
-            self.logger.warning(f"Permission denied accessing directory: {directory}")
-        except Exception as e:
-            self.logger.error(f"Error traversing directory {directory}: {e}")
+        while pending:
+            current, relative = pending.pop()
+            try:
+                with os.scandir(current) as entries:
+                    entries = sorted(entries, key=lambda entry: entry.name)
+            except PermissionError:
+                self.logger.warning(f"Permission denied accessing directory: {current}")
+                continue
+            except OSError as e:
+                self.logger.warning(f"Error accessing directory {current}: {e}")
+                continue
+            
+            subdirectories = []
+            for entry in entries:
+                entry_relative = f"{relative}/{entry.name}" if relative else entry.name
+                try:
+                    if entry.is_file():
+                        if os.path.splitext(entry.name)[1] in extensions and \
+                                path_filter.includes_file(entry.path, entry_relative):
+                            files.append(Path(entry.path))
+                            self.logger.debug(f"Including file: {entry.path}")
+                        else:
+                            self.logger.debug(f"Excluding file: {entry.path}")
+                    
+                    elif entry.is_dir():
+                        # Skip hidden directories and common build directories
+                        if self._should_skip_directory(entry.name, entry.path, entry_relative):
+                            self.logger.debug(f"Skipping directory: {entry.path}")
+                            continue
+                        # Follow directory symlinks once, so a link back up the tree does not loop
+                        if entry.is_symlink():
+                            target = os.path.realpath(entry.path)
+                            if target in visited:
+                                continue
+                            visited.add(target)
+                        subdirectories.append((entry.path, entry_relative))
+                except OSError as e:
+                    self.logger.warning(f"Error accessing {entry.path}: {e}")
+            
+            # Reversed so the stack pops subdirectories in name order
+            pending.extend(reversed(subdirectories))
             
         return files
     
-    def _should_skip_directory(self, directory: Path) -> bool:
-        """Check if a directory should be skipped during traversal."""
-        skip_dirs = {
-            '.git', '.svn', '.hg',  # Version control
-            'build', 'builds', 'Build', 'BUILD',  # Build directories
-            'cmake-build-debug', 'cmake-build-release',  # CMake build dirs
-            'out', 'output', 'bin', 'obj',  # Output directories
-            '.vscode', '.idea',  # IDE directories
-            'node_modules',  # Node.js
-            '__pycache__', '.pytest_cache',  # Python
-            'target',  # Rust/Java
-            '.vs',  # Visual Studio
-        }
+    def _list_git_files(self, directory: Path) -> Optional[List[Path]]:
+        """Tracked and untracked-but-not-ignored files from git ls-files; None if git fails.
+        
+        Honours .gitignore and skips the directory walk entirely; the same
+        directory and pattern rules as the walk are then applied to the paths.
+        """
+        try:
+            result = subprocess.run(
+                ['git', '-C', str(directory), 'ls-files', '-z', '--cached', '--others', '--exclude-standard'],
+                capture_output=True, check=True
+            )
+        except (OSError, subprocess.CalledProcessError) as e:
+            self.logger.debug(f"git ls-files: {e}")
+            return None
         
+        files = []
+        extensions = self.config.DEFAULT_EXTENSIONS
+        path_filter = self.config.path_filter
+        skipped_directories: Dict[str, bool] = {}
+        root = str(directory)
+        for name in sorted(set(os.fsdecode(raw) for raw in result.stdout.split(b'\0') if raw)):
+            if os.path.splitext(name)[1] not in extensions:
+                continue
+            if self._in_skipped_directory(root, name, skipped_directories):
+                continue
+            file_path = os.path.join(root, name)
+            # Tracked files deleted from the working tree are still listed
+            if path_filter.includes_file(file_path, name) and os.path.isfile(file_path):
+                files.append(Path(file_path))
+        return files
+    
+    def order_key(self, file_path: Path) -> Tuple:
+        """Sort key placing a file under the scan root where discover_files lists it."""
+        relative = os.path.relpath(file_path, self.config.source_path).replace(os.sep, '/')
+        if self.config.discovery == 'git':
+            return (relative,)
+        # The walk lists a directory's files before its subdirectories, each in name order
+        parts = relative.split('/')
+        return tuple((1, part) for part in parts[:-1]) + ((0, parts[-1]),)
+    
+    def is_source_file(self, file_path: Path) -> bool:
+        """Whether discovery would list a file under the scan root (extension, directories, patterns)."""
+        root = str(self.config.source_path)
+        relative = os.path.relpath(file_path, root).replace(os.sep, '/')
+        if relative.startswith('../') or os.path.splitext(relative)[1] not in self.config.DEFAULT_EXTENSIONS:
+            return False
+        if self._in_skipped_directory(root, relative, self._skipped_directories):
+            return False
+        return self.config.path_filter.includes_file(str(file_path), relative)
+    
+    def _in_skipped_directory(self, root: str, relative: str, cache: Dict[str, bool]) -> bool:
+        """Whether any parent directory of a listed file would be skipped by the walk."""
+        parent = relative.rpartition('/')[0]
+        if not parent:
+            return False
+        if parent not in cache:
+            cache[parent] = self._in_skipped_directory(root, parent, cache) or \
+                self._should_skip_directory(parent.rpartition('/')[2], os.path.join(root, parent), parent)
+        return cache[parent]
+    
+    def _should_skip_directory(self, name: str, path: str, relative: str) -> bool:
+        """Check if a directory should be skipped during traversal."""
         # Skip hidden directories (starting with .)
-        if directory.name.startswith('.') and directory.name not in {'.', '..'}:
+        if name.startswith('.') and name not in {'.', '..'}:
             # Allow some specific hidden directories that might contain source
             allowed_hidden = {'.config', '.src'}
-            if directory.name not in allowed_hidden:
+            if name not in allowed_hidden:
                 return True
         
         # Skip known build/output directories
-        if directory.name in skip_dirs:
+        if name in self.SKIP_DIRECTORIES:
             return True
             
         # Check exclude patterns
-        dir_str = str(directory)
-        for pattern in self.config.exclude_patterns:
-            if pattern in dir_str:
-                return True
-                
-        return False
+        return self.config.path_filter.excludes_directory(path, relative)
     
     def get_file_info(self, file_path: Path) -> dict:
         """Get metadata information about a file."""
@@ -0,0 +1,153 @@
+"""
+Supervised per-file analysis.
+
+Parsing a single pathological translation unit (heavy templates, huge
+generated files) can hang `index.parse` or exhaust memory. With a per-file
+wall-clock or memory budget configured, each file is parsed and analyzed in
+a forked child process; a child that exceeds its budget is killed and the
+file is recorded as `timed_out` or `oom` while the run continues. Without a
+budget files are analyzed in-process as before.
+"""
+
+import logging
+import multiprocessing
+import signal
+import time
+from pathlib import Path
+from typing import Dict, Any, Optional
+
+try:
+    import resource
+except ImportError:  # not available on Windows
+    resource = None
+
+from .config import Config
+from .ast_parser import ASTParser
+from .loop_analyzer import LoopAnalyzer
+
+
+class SupervisedFileAnalyzer:
+    """Parses and analyzes one file at a time, optionally in a budgeted child process."""
+
+    # Outcomes recorded in the output; 'ok', 'parse_failed' and 'failed' are handled by the caller
+    FAILURE_STATUSES = ('timed_out', 'oom', 'crashed')
+
+    def __init__(self, config: Config, ast_parser: ASTParser, loop_analyzer: LoopAnalyzer):
+        """Initialize with the run's parser and analyzer; children inherit them through fork."""
+        self.config = config
+        self.ast_parser = ast_parser
+        self.loop_analyzer = loop_analyzer
+        self.logger = logging.getLogger(__name__)
+
+        self.supervised = bool(config.file_timeout or config.file_memory_limit_mb)
+        if self.supervised and 'fork' not in multiprocessing.get_all_start_methods():
+            self.logger.warning("Per-file budgets need fork(); analyzing files in-process without limits")
+            self.supervised = False
+        if config.file_memory_limit_mb and resource is None:
+            self.logger.warning("Memory limits are not supported on this platform; only the timeout applies")
+        self._context = multiprocessing.get_context('fork') if self.supervised else None
+
+    def analyze(self, file_path: Path) -> Dict[str, Any]:
+        """Analyze one file.
+
+        Returns a dict with 'status' ('ok', 'parse_failed' or one of
+        FAILURE_STATUSES), 'seconds' and, when ok, 'analysis', 'timings' and
+        'stats' (as ASTParser.last_timings and LoopAnalyzer.last_file_stats).
+        Errors raised by the analysis are re-raised in the caller.
+        """
+        started = time.perf_counter()
+        if self.supervised:
+            outcome = self._analyze_in_child(file_path)
+        else:
+            outcome = self._analyze_here(file_path)
+        outcome['seconds'] = time.perf_counter() - started
+
+        if outcome['status'] == 'failed':
+            raise RuntimeError(outcome['error'])
+        return outcome
+
+    def failure_record(self, outcome: Dict[str, Any]) -> Dict[str, Any]:
+        """Source file entry for a file whose child was killed, so the run and its resume skip it."""
+        return {
+            'file_info': {
+                'analysis_status': outcome['status'],
+                'error': outcome.get('error', ''),
+                'seconds': round(outcome['seconds'], 3),
+            },
+            'classes': {},
+            'functions': {},
+            'global_loops': [],
+        }
+
+    def _analyze_here(self, file_path: Path) -> Dict[str, Any]:
+        """Parse and analyze in this process."""
+        translation_unit = self.ast_parser.parse_file(file_path)
+        if translation_unit is None:
+            return {'status': 'parse_failed'}
+        try:
+            analysis = self.loop_analyzer.analyze_file(translation_unit, file_path)
+        finally:
+            # The analysis holds no cursors, so the unit can go before the next file is parsed
+            self.ast_parser.dispose(translation_unit)
+        return {
+            'status': 'ok',
+            'analysis': analysis,
+            'timings': dict(self.ast_parser.last_timings),
+            'stats': dict(self.loop_analyzer.last_file_stats),
+        }
+
+    def _analyze_in_child(self, file_path: Path) -> Dict[str, Any]:
+        """Run _analyze_here in a forked child and enforce the wall-clock budget."""
+        receiver, sender = self._context.Pipe(duplex=False)
+        process = self._context.Process(target=self._child_main, args=(sender, file_path), daemon=True)
+        process.start()
+        sender.close()
+
+        outcome: Optional[Dict[str, Any]] = None
+        try:
+            # poll also returns when the child exits without sending (EOF)
+            if receiver.poll(self.config.file_timeout or None):
+                try:
+                    outcome = receiver.recv()
+                except EOFError:
+                    pass
+            else:
+                process.kill()
+                outcome = {'status': 'timed_out',
+                           'error': f"exceeded the {self.config.file_timeout:g}s per-file timeout"}
+        finally:
+            receiver.close()
+            process.join()
+
+        if outcome is None:
+            outcome = self._classify_exit(process.exitcode)
+        if outcome['status'] in self.FAILURE_STATUSES:
+            self.logger.warning(f"{file_path}: {outcome['status']} ({outcome['error']})")
+        return outcome
+
+    def _child_main(self, sender, file_path: Path) -> None:
+        """Body of the child process: apply the memory budget, analyze, send the outcome."""
+        try:
+            if self.config.file_memory_limit_mb and resource is not None:
+                limit = self.config.file_memory_limit_mb * 1024 * 1024
+                resource.setrlimit(resource.RLIMIT_AS, (limit, limit))
+            outcome = self._analyze_here(file_path)
+        except MemoryError:
+            outcome = {'status': 'oom',
+                       'error': f"exceeded the {self.config.file_memory_limit_mb} MB per-file memory limit"}
+        except Exception as e:
+            outcome = {'status': 'failed', 'error': str(e)}
+        try:
+            sender.send(outcome)
+        finally:
+            sender.close()
+
+    def _classify_exit(self, exitcode: Optional[int]) -> Dict[str, Any]:
+        """Outcome of a child that exited without reporting a result."""
+        # libclang aborts on failed allocations; the kernel OOM killer sends SIGKILL
+        memory_signals = {-signal.SIGKILL, -signal.SIGABRT, -signal.SIGSEGV}
+        if exitcode in memory_signals and (self.config.file_memory_limit_mb or exitcode == -signal.SIGKILL):
+            return {'status': 'oom', 'error': f"worker killed by {signal.Signals(-exitcode).name}"}
+        if exitcode is not None and exitcode < 0:
+            return {'status': 'crashed', 'error': f"worker killed by {signal.Signals(-exitcode).name}"}
+        return {'status': 'crashed', 'error': f"worker exited with status {exitcode} without a result"}
@@ -0,0 +1,189 @@
+"""
+Flame-graph export module.
+
+Writes the loop-nest tree as folded stacks (`file;function;loop_L12;loop_L14 <weight>`)
+for flamegraph.pl, inferno or speedscope. Weights are a static estimate
+(iterations x per-iteration operation count) or measured data attached by
+`loop_extractor.py annotate`.
+"""
+
+import logging
+from collections import Counter
+from pathlib import Path
+from typing import Dict, List, Any, Set, Tuple
+
+from .loop_index import LoopIndex
+from .loop_cost import LoopCostModel
+
+
+class FlameGraphExporter:
+    """Folds loop nests into weighted stacks."""
+
+    WEIGHTS = ('auto', 'static', 'counts', 'profile')
+
+    def __init__(self, weight: str = 'auto', default_iterations: int = 100,
+                 call_graph: bool = False, call_depth: int = 3):
+        """Initialize the exporter.
+
+        Args:
+            weight: 'static', 'counts' (coverage/instrumentation iterations),
+                'profile' (sampled self cost) or 'auto' to pick the best available
+            default_iterations: trip count assumed when none is known
+            call_graph: nest the loops of called functions under the calling loop
+            call_depth: maximum number of calls followed from one root
+        """
+        if weight not in self.WEIGHTS:
+            raise ValueError(f"Unsupported weight: {weight}")
+        self.weight = weight
+        self.cost_model = LoopCostModel(default_iterations)
+        self.call_graph = call_graph
+        self.call_depth = call_depth
+        self.logger = logging.getLogger(__name__)
+
+    def export(self, analysis_data: Dict[str, Any], output_path: Path) -> Dict[str, Any]:
+        """Write the folded stacks of an analysis; returns a run summary."""
+        mode = self.resolve_weight(analysis_data)
+        stacks = self.fold(analysis_data['source_files'], mode)
+
+        output_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(output_path, 'w', encoding='utf-8') as f:
+            for stack, weight in sorted(stacks.items()):
+                f.write(f"{stack} {weight}\n")
+
+        self.logger.info(f"Wrote {len(stacks)} stacks weighted by {mode} to {output_path}")
+        return {
+            'output': str(output_path),
+            'weight': mode,
+            'stacks': len(stacks),
+            'total_weight': sum(stacks.values()),
+        }
+
+    def resolve_weight(self, analysis_data: Dict[str, Any]) -> str:
+        """Pick the weight source for 'auto' from the annotations present."""
+        if self.weight != 'auto':
+            return self.weight
+        extensions = analysis_data.get('extensions', {})
+        if 'profile' in extensions:
+            return 'profile'
+        if 'instrumentation' in extensions or 'coverage' in extensions:
+            return 'counts'
+        return 'static'
+
+    def fold(self, analysis_results: Dict[str, Any], mode: str) -> Dict[str, int]:
+        """Return folded stack -> integer weight."""
+        index = LoopIndex(analysis_results)
+        functions = {(file_path, name): loops for file_path, name, loops in index.iter_functions()}
+        stacks: Counter = Counter()
+
+        # Measured weights are absolute, so a callee reached from several loops is split between them.
+        # Calls within a recursion cycle are not counted: its functions are drawn as roots instead.
+        callers: Counter = Counter()
+        component: Dict[Tuple[str, str], int] = {}
+        if self.call_graph:
+            calls = {function: [callee for loop in self._iter_tree(loops) for callee in self._callees(index, loop)]
+                     for function, loops in functions.items()}
+            component = self._components(calls)
+            for function, callees in calls.items():
+                for callee in callees:
+                    if component.get(callee) != component[function]:
+                        callers[callee] += 1
+
+        def walk(loops: List[Dict[str, Any]], prefix: List[str], parent_executions: float,
+                 share: float, depth: int, visiting: Set[Tuple[str, str]], function: Tuple[str, str]) -> None:
+            for loop in loops:
+                frame = f"loop_L{loop.get('location', {}).get('start_line', 0)}"
+                stack = prefix + [frame]
+                executions, weight = self._weigh(loop, mode, parent_executions, share)
+                if weight > 0:
+                    stacks[';'.join(stack)] += weight
+
+                walk(loop.get('nested_loops', []), stack, executions, share, depth, visiting, function)
+
+                if not self.call_graph or depth >= self.call_depth:
+                    continue
+                for callee in self._callees(index, loop):
+                    if callee in visiting or callee not in functions or \
+                            component.get(callee) == component.get(function):
+                        continue
+                    callee_share = share / max(1, callers[callee])
+                    walk(functions[callee], stack + [self._frame(callee[1])], executions,
+                         callee_share, depth + 1, visiting | {callee}, callee)
+
+        for (file_path, name), loops in functions.items():
+            if not loops or (self.call_graph and callers[(file_path, name)]):
+                # Functions called from loops are drawn under their callers
+                continue
+            walk(loops, [self._frame(file_path), self._frame(name or '<global>')], 1.0, 1.0, 0,
+                 {(file_path, name)}, (file_path, name))
+
+        return {stack: max(1, int(round(weight))) for stack, weight in stacks.items()}
+
+    def _weigh(self, loop: Dict[str, Any], mode: str, parent_executions: float,
+               share: float) -> Tuple[float, float]:
+        """Return (body executions, self weight) of one loop."""
+        extensions = loop.get('extensions', {})
+        if mode == 'profile':
+            return 0.0, extensions.get('profile', {}).get('self', 0) * share
+
+        measured = self.cost_model.measured_iterations(loop) if mode == 'counts' else None
+        if measured is not None:
+            executions = measured * share
+        else:
+            executions = self.cost_model.executions(loop, parent_executions, measured=False)
+        return executions, executions * self.cost_model.body_cost(loop)
+
+    def _components(self, calls: Dict[Tuple[str, str], List[Tuple[str, str]]]) -> Dict[Tuple[str, str], int]:
+        """Strongly connected component number of every function (Tarjan, iterative)."""
+        index_of: Dict[Tuple[str, str], int] = {}
+        lowlink: Dict[Tuple[str, str], int] = {}
+        component: Dict[Tuple[str, str], int] = {}
+        stack: List[Tuple[str, str]] = []
+        components = 0
+        for root in calls:
+            if root in index_of:
+                continue
+            work = [(root, iter(calls[root]))]
+            index_of[root] = lowlink[root] = len(index_of)
+            stack.append(root)
+            while work:
+                function, callees = work[-1]
+                callee = next((callee for callee in callees if callee in calls), None)
+                if callee is not None:
+                    if callee not in index_of:
+                        index_of[callee] = lowlink[callee] = len(index_of)
+                        stack.append(callee)
+                        work.append((callee, iter(calls[callee])))
+                    elif callee not in component:
+                        lowlink[function] = min(lowlink[function], index_of[callee])
+                    continue
+                work.pop()
+                if work:
+                    caller = work[-1][0]
+                    lowlink[caller] = min(lowlink[caller], lowlink[function])
+                if lowlink[function] == index_of[function]:
+                    while True:
+                        member = stack.pop()
+                        component[member] = components
+                        if member == function:
+                            break
+                    components += 1
+        return component
+
+    def _callees(self, index: LoopIndex, loop: Dict[str, Any]) -> List[Tuple[str, str]]:
+        """Analyzed functions called directly from a loop body."""
+        callees = []
+        for call in loop.get('function_calls', []):
+            callee = index.resolve_function(call.get('function', ''), call.get('definition_file', ''))
+            if callee is not None and callee not in callees:
+                callees.append(callee)
+        return callees
+
+    def _iter_tree(self, loops: List[Dict[str, Any]]):
+        """Yield loops and their nested loops."""
+        for loop in loops:
+            yield loop
+            yield from self._iter_tree(loop.get('nested_loops', []))
+
+    def _frame(self, name: str) -> str:
+        """Folded stacks use ';' between frames and a space before the weight."""
+        return name.replace(';', ':').replace('\n', ' ')
@@ -0,0 +1,232 @@
+"""
+Golden-output regression check.
+
+Analyzes every fixture in a directory (by default `test_code/`) one file at
+a time and compares the result with a checked-in golden JSON per fixture.
+Volatile fields (timestamps, timings) are removed and paths are made
+relative before comparing, so the goldens only change when loops, bounds,
+operations or calls change. Headers outside the fixture directory are all
+reduced to one marker, since which file declares e.g. std::vector depends on
+the toolchain, and a fixture with parse errors is reported as such rather
+than diffed. The OpenMP rewriter's verdict for every loop is recorded too,
+and the pragmas it inserts are kept as a golden patch (`<fixture>.patch`),
+so fixtures such as openmp_scalars.cpp cover its dependence check. Intended
+to be run before and after traversal, caching and parallelism changes.
+"""
+
+import difflib
+import json
+import logging
+import time
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+from clang.cindex import Diagnostic
+
+from .config import Config
+from .ast_parser import ASTParser
+from .loop_analyzer import LoopAnalyzer
+from .openmp_rewriter import OpenMPRewriter
+
+
+class GoldenCheck:
+    """Runs the analyzer over fixtures and diffs the output against golden files."""
+
+    # Keys whose values differ between runs of the same code
+    VOLATILE_KEYS = {'last_modified', 'generated_at', 'analysis_duration_seconds', 'performance'}
+    # Replaces paths outside the fixture directory (system headers)
+    EXTERNAL_PATH = '<external>'
+    # Parse errors listed for a fixture that fails to parse
+    MAX_PARSE_ERRORS = 5
+
+    def __init__(self, config: Config, golden_dir: Path, max_differences: int = 20):
+        """Initialize the check; config.source_path is the fixture directory."""
+        self.config = config
+        # Fixtures are parsed by absolute path so every path in the output has this prefix
+        self.fixture_dir = config.source_path.resolve()
+        self.golden_dir = golden_dir
+        self.max_differences = max_differences
+        self.logger = logging.getLogger(__name__)
+
+    def fixtures(self) -> List[Path]:
+        """Source files directly in the fixture directory, in name order."""
+        return sorted(path for path in self.fixture_dir.iterdir()
+                      if path.is_file() and self.config.should_include_file(path))
+
+    def run(self, update: bool = False) -> Dict[str, Any]:
+        """Check (or with update, rewrite) every golden file; returns a report."""
+        ast_parser = ASTParser(self.config)
+        # One analyzer for all fixtures, as in a normal run, so state leaking between files shows up
+        loop_analyzer = LoopAnalyzer(self.config, ast_parser)
+        rewriter = OpenMPRewriter(self.config)
+
+        results = []
+        for fixture in self.fixtures():
+            started = time.perf_counter()
+            actual, parse_errors = self._analyze(ast_parser, loop_analyzer, fixture)
+            patch = ''
+            if actual is not None:
+                actual['openmp'], patch = self._openmp(rewriter, fixture)
+            seconds = time.perf_counter() - started
+            golden_path = self.golden_dir / f'{fixture.name}.json'
+            patch_path = self.golden_dir / f'{fixture.name}.patch'
+
+            if parse_errors:
+                # A diff against the golden would only show everything as removed
+                status, differences = 'parse_error', parse_errors
+            elif update:
+                self._write(actual, golden_path)
+                self._write_patch(patch, patch_path)
+                status, differences = 'updated', []
+            elif not golden_path.exists():
+                status, differences = 'missing', [f"no golden file {golden_path}"]
+            else:
+                with open(golden_path, 'r', encoding='utf-8') as f:
+                    expected = json.load(f)
+                differences = self.diff(expected, actual) + self._diff_patch(patch, patch_path)
+                status = 'match' if not differences else 'mismatch'
+
+            loops = loop_analyzer.count_loops(actual) if actual is not None else 0
+            self.logger.info(f"{fixture.name}: {status} ({loops} loops, {seconds:.2f}s)")
+            for difference in differences[:self.max_differences]:
+                self.logger.info(f"  {difference}")
+            if len(differences) > self.max_differences:
+                self.logger.info(f"  ... {len(differences) - self.max_differences} more differences")
+
+            results.append({
+                'fixture': fixture.name,
+                'status': status,
+                'seconds': round(seconds, 3),
+                'loops': loops,
+                'differences': differences,
+            })
+
+        failed = [result['fixture'] for result in results
+                  if result['status'] in ('mismatch', 'missing', 'parse_error')]
+        return {
+            'fixture_dir': str(self.fixture_dir),
+            'golden_dir': str(self.golden_dir),
+            'fixtures': results,
+            'failed': failed,
+            'total_seconds': round(sum(result['seconds'] for result in results), 3),
+        }
+
+    def _analyze(self, ast_parser: ASTParser, loop_analyzer: LoopAnalyzer,
+                 fixture: Path) -> Tuple[Optional[Dict[str, Any]], List[str]]:
+        """Normalized analysis of one fixture, or None and its parse errors."""
+        translation_unit = ast_parser.parse_file(fixture)
+        if translation_unit is None:
+            return None, [f"{fixture.name} could not be parsed (see the log for the exception)"]
+        try:
+            errors = [diagnostic for diagnostic in translation_unit.diagnostics
+                      if diagnostic.severity >= Diagnostic.Error]
+            if errors:
+                messages = [f"parse error: {self._where(diagnostic)}: {diagnostic.spelling}"
+                            for diagnostic in errors[:self.MAX_PARSE_ERRORS]]
+                if len(errors) > self.MAX_PARSE_ERRORS:
+                    messages.append(f"... {len(errors) - self.MAX_PARSE_ERRORS} more parse errors")
+                return None, messages
+            return self.normalize(loop_analyzer.analyze_file(translation_unit, fixture)), []
+        finally:
+            ast_parser.dispose(translation_unit)
+
+    def _where(self, diagnostic: Diagnostic) -> str:
+        """'file:line' of a diagnostic; a missing system header shows its full path."""
+        location = diagnostic.location
+        name = str(location.file) if location.file else '<unknown>'
+        if name.startswith(str(self.fixture_dir) + '/'):
+            name = self._normalize_path(name)
+        return f"{name}:{location.line}"
+
+    def _openmp(self, rewriter: OpenMPRewriter, fixture: Path) -> Tuple[Any, str]:
+        """Parallelism verdict of each loop by 'line:column' (None when the rewriter skips the file)
+        and the patch inserting its pragmas."""
+        decisions = rewriter.rewrite_file(fixture)
+        if decisions is None:
+            return None, ''
+        original, rewritten, verdicts = decisions
+        patch = ''.join(difflib.unified_diff(rewriter._lines(original), rewriter._lines(rewritten),
+                                             fromfile=f"a/{fixture.name}", tofile=f"b/{fixture.name}"))
+        return {f"{line}:{column}": rewriter._extension(verdict)
+                for (line, column), verdict in sorted(verdicts.items())}, patch
+
+    def _diff_patch(self, patch: str, patch_path: Path) -> List[str]:
+        """Changed lines between the golden patch (none if the file is absent) and the proposed one."""
+        expected = patch_path.read_text(encoding='utf-8') if patch_path.exists() else ''
+        if patch == expected:
+            return []
+        changed = difflib.unified_diff(expected.splitlines(), patch.splitlines(), lineterm='', n=0)
+        return [f"{patch_path.name}: {line}" for line in changed
+                if line[:1] in '+-' and not line.startswith(('+++', '---'))]
+
+    def _write_patch(self, patch: str, patch_path: Path) -> None:
+        """Write the golden patch, or remove it once the fixture gets no pragmas."""
+        if patch:
+            patch_path.parent.mkdir(parents=True, exist_ok=True)
+            patch_path.write_text(patch, encoding='utf-8')
+        elif patch_path.exists():
+            patch_path.unlink()
+
+    def normalize(self, value: Any) -> Any:
+        """Copy of value without volatile keys and with machine-independent paths."""
+        if isinstance(value, dict):
+            return {self._normalize_path(key): self.normalize(item)
+                    for key, item in value.items() if key not in self.VOLATILE_KEYS}
+        if isinstance(value, list):
+            return [self.normalize(item) for item in value]
+        if isinstance(value, str):
+            return self._normalize_path(value)
+        return value
+
+    def _normalize_path(self, text: str) -> str:
+        """Fixture paths relative to the fixture directory, other absolute paths reduced to a marker."""
+        if not text.startswith('/') or '\n' in text:
+            return text
+        fixture_prefix = str(self.fixture_dir) + '/'
+        if text.startswith(fixture_prefix):
+            return text[len(fixture_prefix):]
+        return self.EXTERNAL_PATH
+
+    def diff(self, expected: Any, actual: Any, path: str = '$') -> List[str]:
+        """Differences between two JSON values as 'path: expected -> actual' lines."""
+        if isinstance(expected, dict) and isinstance(actual, dict):
+            differences = []
+            for key in expected:
+                if key not in actual:
+                    differences.append(f"{path}.{key}: removed")
+                else:
+                    differences.extend(self.diff(expected[key], actual[key], f"{path}.{key}"))
+            differences.extend(f"{path}.{key}: added" for key in actual if key not in expected)
+            return differences
+
+        if isinstance(expected, list) and isinstance(actual, list):
+            differences = []
+            for index, (before, after) in enumerate(zip(expected, actual)):
+                differences.extend(self.diff(before, after, f"{path}[{index}]"))
+            if len(expected) != len(actual):
+                differences.append(f"{path}: length {len(expected)} -> {len(actual)}")
+            return differences
+
+        if expected != actual:
+            return [f"{path}: {self._short(expected)} -> {self._short(actual)}"]
+        return []
+
+    def _short(self, value: Any) -> str:
+        """Compact JSON of a value for difference lines."""
+        text = json.dumps(value)
+        return text if len(text) <= 80 else text[:77] + '...'
+
+    def _write(self, data: Dict[str, Any], golden_path: Path) -> None:
+        """Write a golden file with stable formatting."""
+        golden_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(golden_path, 'w', encoding='utf-8') as f:
+            json.dump(data, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+    def write_report(self, report: Dict[str, Any], report_path: Path) -> None:
+        """Write the check report, including per-fixture runtimes."""
+        report_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(report_path, 'w', encoding='utf-8') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+        self.logger.info(f"Golden check report written to: {report_path}")
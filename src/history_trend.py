@@ -0,0 +1,306 @@
+"""
+Loop metrics over the git history of a repository.
+
+Commits from --since to --until (first parent only) are checked out one
+after another into a scratch worktree, so each checkout rewrites only the
+files the commit changed and includes resolve against the tree of that
+commit. A file is analyzed only when its blob hash has not been seen
+before; results are kept per blob in memory and on disk under the cache
+directory, so a later run over an overlapping range analyzes only new
+blobs. Files that include a changed header are not re-analyzed unless
+they changed themselves.
+
+Per function the series records loop count, estimated cost (executions x
+body cost, see loop_cost.py), deepest nesting and the functions called in
+its loops, with one point at every commit where any of them changed.
+"""
+
+import hashlib
+import json
+import logging
+import os
+import shutil
+import subprocess
+import time
+from datetime import datetime
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+from . import __version__
+from .config import Config
+from .file_discovery import FileDiscovery
+from .ast_parser import ASTParser
+from .loop_analyzer import LoopAnalyzer
+from .analysis_diff import AnalysisDiff
+
+
+class HistoryTrend:
+    """Analyzes a range of commits, re-analyzing only changed blobs."""
+
+    def __init__(self, config: Config, repository: Path, cache_dir: Path, default_iterations: int = 100):
+        """Initialize for the repository containing `repository`; config.source_path is set per run."""
+        self.config = config
+        self.logger = logging.getLogger(__name__)
+        self.cache_dir = cache_dir.resolve()
+        self.diff = AnalysisDiff(default_iterations=default_iterations)
+
+        self.top_level = Path(self._git(['rev-parse', '--show-toplevel'], repository).decode().strip())
+        # Only files below the given directory are analyzed, relative to it in the output
+        self.prefix = os.path.relpath(Path(repository).resolve(), self.top_level.resolve()).replace(os.sep, '/')
+        if self.prefix == '.':
+            self.prefix = ''
+        self.worktree = self.cache_dir / 'worktree'
+        self.config.source_path = self.worktree / self.prefix if self.prefix else self.worktree
+        self.file_discovery = FileDiscovery(self.config)
+        self.ast_parser = ASTParser(self.config)
+        self.loop_analyzer = LoopAnalyzer(self.config, self.ast_parser)
+
+        # Results depend on the analyzer and its settings as well as the blob
+        settings = json.dumps({'version': __version__, 'passes': self.loop_analyzer.pass_names,
+                               'flags': self.config.get_compiler_flags()}, sort_keys=True)
+        self.results_dir = self.cache_dir / 'results' / hashlib.sha1(settings.encode('utf-8')).hexdigest()[:12]
+        # Blob hash -> per-function metrics, or None when the blob failed to parse
+        self.metrics: Dict[str, Optional[Dict[str, Dict[str, Any]]]] = {}
+        self.stats = {'analyzed': 0, 'disk_hits': 0, 'memory_hits': 0, 'failed': 0}
+
+    def run(self, since: str, until: str = 'HEAD') -> Dict[str, Any]:
+        """Walk the commits and return the per-commit totals and per-function series."""
+        start_time = datetime.now()
+        commits = self._commits(since, until)
+        self.logger.info(f"Analyzing {len(commits)} commits from {commits[0]['commit'][:12]}")
+
+        entries: List[Dict[str, Any]] = []
+        series: Dict[str, List[Dict[str, Any]]] = {}
+        current: Dict[str, Dict[str, Any]] = {}
+        blobs: Dict[str, str] = {}
+        self._prepare_worktree(commits[0]['commit'])
+        try:
+            for index, commit in enumerate(commits):
+                started = time.perf_counter()
+                self._git(['checkout', '-q', '--detach', '--force', commit['commit']], self.worktree)
+                analyzed_before = self.stats['analyzed']
+                new_blobs = self._list_blobs(commit['commit'])
+                changed = [path for path, blob in new_blobs.items() if blobs.get(path) != blob]
+                removed = [path for path in blobs if path not in new_blobs]
+
+                failed = []
+                for path in changed:
+                    metrics = self._file_metrics(path, new_blobs[path])
+                    if metrics is None:
+                        # Keep the previous version's functions rather than report them as removed
+                        failed.append(path)
+                        if path in blobs:
+                            new_blobs[path] = blobs[path]
+                        continue
+                    self._replace_file(current, path, metrics)
+                for path in removed:
+                    self._replace_file(current, path, {})
+                blobs = new_blobs
+
+                point = {'commit': commit['commit'][:12], 'index': index}
+                for function_key in self._changed_functions(current, series):
+                    values = current.get(function_key, self._empty())
+                    series.setdefault(function_key, []).append(dict(point, **values))
+
+                entry = dict(commit,
+                             files_changed=len(changed) + len(removed),
+                             files_analyzed=self.stats['analyzed'] - analyzed_before,
+                             totals=self._totals(current),
+                             seconds=round(time.perf_counter() - started, 3))
+                if failed:
+                    entry['failed_files'] = sorted(failed)
+                entries.append(entry)
+                self.logger.info(f"[{index + 1}/{len(commits)}] {commit['commit'][:12]} {commit['subject'][:60]}: "
+                                 f"{entry['files_changed']} files changed, {entry['files_analyzed']} analyzed")
+        finally:
+            self._remove_worktree()
+
+        return {
+            'metadata': {
+                'generated_at': datetime.now().isoformat(),
+                'tool_version': __version__,
+                'repository': str(self.top_level),
+                'path': self.prefix or '.',
+                'since': since,
+                'until': until,
+                'commits': len(entries),
+                'cache': dict(self.stats),
+                'analysis_duration_seconds': (datetime.now() - start_time).total_seconds(),
+            },
+            'commits': entries,
+            'functions': dict(sorted(series.items())),
+        }
+
+    def _commits(self, since: str, until: str) -> List[Dict[str, Any]]:
+        """The since commit followed by the first-parent commits up to until, oldest first."""
+        fields = '%H%x00%cI%x00%an%x00%s'
+        output = self._git(['log', '--no-walk', f'--format={fields}', since], self.top_level)
+        output += self._git(['log', '--reverse', '--first-parent', f'--format={fields}', f'{since}..{until}'],
+                            self.top_level)
+        commits = []
+        for line in output.decode('utf-8', errors='replace').splitlines():
+            if line:
+                sha, date, author, subject = line.split('\0', 3)
+                commits.append({'commit': sha, 'date': date, 'author': author, 'subject': subject})
+        return commits
+
+    def _list_blobs(self, commit: str) -> Dict[str, str]:
+        """Blob hash of every source file discovery would analyze at a commit, by path relative to the scan root."""
+        arguments = ['ls-tree', '-r', '-z', '--full-tree', commit]
+        if self.prefix:
+            arguments += ['--', self.prefix]
+        blobs = {}
+        for record in self._git(arguments, self.top_level).split(b'\0'):
+            if not record:
+                continue
+            info, _, name = record.partition(b'\t')
+            mode, kind, blob = info.decode().split()
+            if kind != 'blob' or mode == '120000':
+                continue
+            path = os.fsdecode(name)
+            relative = path[len(self.prefix) + 1:] if self.prefix else path
+            if self.file_discovery.is_source_file(self.config.source_path / relative):
+                blobs[relative] = blob
+        return blobs
+
+    def _file_metrics(self, path: str, blob: str) -> Optional[Dict[str, Dict[str, Any]]]:
+        """Per-function metrics of one blob: memory, then the disk cache, then analysis of the checkout."""
+        if blob in self.metrics:
+            self.stats['memory_hits'] += 1
+            return self.metrics[blob]
+
+        cache_file = self.results_dir / blob[:2] / f"{blob}.json"
+        file_data = None
+        if cache_file.exists():
+            try:
+                with open(cache_file, 'r', encoding='utf-8') as f:
+                    file_data = json.load(f)
+                self.stats['disk_hits'] += 1
+            except (OSError, ValueError) as e:
+                self.logger.debug(f"Ignoring unreadable cache entry {cache_file}: {e}")
+        if file_data is None:
+            file_data = self._analyze(self.config.source_path / path)
+            if file_data is not None:
+                cache_file.parent.mkdir(parents=True, exist_ok=True)
+                temporary = cache_file.with_suffix('.tmp')
+                with open(temporary, 'w', encoding='utf-8') as f:
+                    json.dump(file_data, f)
+                os.replace(temporary, cache_file)
+
+        self.metrics[blob] = None if file_data is None else self._function_metrics(path, file_data)
+        return self.metrics[blob]
+
+    def _analyze(self, file_path: Path) -> Optional[Dict[str, Any]]:
+        """Parse and analyze one file of the checkout; None if it does not parse."""
+        translation_unit = self.ast_parser.parse_file(file_path)
+        if translation_unit is None:
+            self.logger.warning(f"Failed to parse {file_path}")
+            self.stats['failed'] += 1
+            return None
+        try:
+            self.stats['analyzed'] += 1
+            return self.loop_analyzer.analyze_file(translation_unit, file_path)
+        finally:
+            self.ast_parser.dispose(translation_unit)
+
+    def _function_metrics(self, path: str, file_data: Dict[str, Any]) -> Dict[str, Dict[str, Any]]:
+        """Loop count, cost, deepest nesting and calls in loops of every function with loops."""
+        analysis = {'metadata': {'scan_path': ''}, 'source_files': {path: file_data}}
+        metrics: Dict[str, Dict[str, Any]] = {}
+        calls: Dict[str, set] = {}
+        for facts in self.diff.loops(analysis).values():
+            values = metrics.setdefault(facts['function'], self._empty())
+            values['loops'] += 1
+            values['cost'] += facts['cost']
+            values['max_nesting'] = max(values['max_nesting'], facts['nest_path'].count('/'))
+            calls.setdefault(facts['function'], set()).update(
+                call.get('function', '') for call in facts['loop'].get('function_calls', []) if call.get('function'))
+        for function_name, values in metrics.items():
+            values['cost'] = round(values['cost'], 3)
+            values['calls_in_loops'] = sorted(calls.get(function_name, ()))
+        return metrics
+
+    def _replace_file(self, current: Dict[str, Dict[str, Any]], path: str,
+                      metrics: Dict[str, Dict[str, Any]]) -> None:
+        """Replace the functions of one file in the current state."""
+        prefix = f"{path}:"
+        for function_key in [key for key in current if key.startswith(prefix)]:
+            del current[function_key]
+        for function_name, values in metrics.items():
+            current[f"{path}:{function_name}"] = values
+
+    def _changed_functions(self, current: Dict[str, Dict[str, Any]],
+                           series: Dict[str, List[Dict[str, Any]]]) -> List[str]:
+        """Functions whose metrics differ from the last point of their series."""
+        changed = []
+        for function_key in set(current) | set(series):
+            values = current.get(function_key, self._empty())
+            last = series.get(function_key, [None])[-1]
+            if last is None:
+                if function_key in current:
+                    changed.append(function_key)
+            elif any(last[key] != value for key, value in values.items()):
+                changed.append(function_key)
+        return changed
+
+    def _totals(self, current: Dict[str, Dict[str, Any]]) -> Dict[str, Any]:
+        """Totals over all functions at one commit."""
+        return {
+            'loops': sum(values['loops'] for values in current.values()),
+            'cost': round(sum(values['cost'] for values in current.values()), 3),
+            'functions_with_loops': len(current),
+            'max_nesting': max((values['max_nesting'] for values in current.values()), default=0),
+        }
+
+    @staticmethod
+    def _empty() -> Dict[str, Any]:
+        """Metrics of a function without loops, also used for removed functions."""
+        return {'loops': 0, 'cost': 0.0, 'max_nesting': 0, 'calls_in_loops': []}
+
+    def _prepare_worktree(self, commit: str) -> None:
+        """Create the scratch worktree, replacing one left behind by an interrupted run."""
+        if self.worktree.exists():
+            self._remove_worktree()
+        self.worktree.parent.mkdir(parents=True, exist_ok=True)
+        self._git(['worktree', 'add', '-q', '--detach', '--force', str(self.worktree), commit], self.top_level)
+
+    def _remove_worktree(self) -> None:
+        """Remove the scratch worktree and its registration in the repository."""
+        try:
+            self._git(['worktree', 'remove', '--force', str(self.worktree)], self.top_level)
+        except RuntimeError as e:
+            self.logger.debug(f"git worktree remove: {e}")
+            shutil.rmtree(self.worktree, ignore_errors=True)
+            self._git(['worktree', 'prune'], self.top_level)
+
+    def _git(self, arguments: List[str], directory: Path) -> bytes:
+        """Run git in a directory; raises RuntimeError with git's message on failure."""
+        result = subprocess.run(['git', '-C', str(directory)] + arguments, capture_output=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"git {arguments[0]} failed: {result.stderr.decode(errors='replace').strip()}")
+        return result.stdout
+
+    def format_text(self, history: Dict[str, Any], limit: int = 10) -> str:
+        """Totals over the range and the functions whose loop cost grew most, with the commit of the largest step."""
+        commits = history['commits']
+        first, last = commits[0]['totals'], commits[-1]['totals']
+        lines = [f"{len(commits)} commits: loops {first['loops']} -> {last['loops']}, "
+                 f"cost {first['cost']:.4g} -> {last['cost']:.4g}, max nesting {first['max_nesting']} -> "
+                 f"{last['max_nesting']}; {history['metadata']['cache']['analyzed']} files analyzed"]
+
+        growth: List[Tuple[float, str, Dict[str, Any], Dict[str, Any]]] = []
+        for function_key, points in history['functions'].items():
+            start = points[0]['cost'] if points[0]['index'] == 0 else 0.0
+            steps = [(point['cost'] - (previous['cost'] if previous else 0.0), point)
+                     for previous, point in zip([None] + points[:-1], points)]
+            largest = max(steps, key=lambda step: step[0])
+            if points[-1]['cost'] > start and largest[0] > 0:
+                growth.append((points[-1]['cost'] - start, function_key, points[-1], largest[1]))
+
+        growth.sort(key=lambda item: -item[0])
+        for increase, function_key, final, step in growth[:limit]:
+            commit = commits[step['index']]
+            lines.append(f"  {function_key}: cost +{increase:.4g} to {final['cost']:.4g}, "
+                         f"nesting {final['max_nesting']}; largest step at {commit['commit'][:12]} "
+                         f"{commit['date'][:10]} {commit['subject'][:50]}")
+        return '\n'.join(lines)
@@ -0,0 +1,231 @@
+"""
+Incrementally maintained analysis output.
+
+Watch mode replaces the analysis of a few files at a time. Rebuilding the
+summary and call graph with JSONOutput.generate_output would walk every
+file on each save, so this keeps each file's contribution (loop type
+counts, nesting levels, call graph nodes) and applies the difference when
+a file is replaced or removed. With an order key, a new file is inserted
+where discovery lists it, and the result then matches generate_output over
+the same source files, down to the order of merged call lists; without one,
+new files go last and only the sets of calls are the same.
+"""
+
+import bisect
+import logging
+from collections import Counter
+from datetime import datetime
+from pathlib import Path
+from typing import Callable, Dict, List, Any, Optional, Set
+
+from .config import Config
+from .json_output import JSONOutput
+from .loop_analyzer import LoopAnalyzer
+
+
+class IncrementalOutput:
+    """Analysis output whose summary and call graph are updated per file."""
+
+    def __init__(self, config: Config, analysis_results: Dict[str, Any], start_time: datetime,
+                 order_key: Optional[Callable[[Path], Any]] = None):
+        """Build the output once from analysis_results, which is then owned and updated here.
+
+        order_key (e.g. FileDiscovery.order_key) places files added later in discovery order.
+        """
+        self.config = config
+        self.order_key = order_key
+        self.logger = logging.getLogger(__name__)
+        self.json_output = JSONOutput(config)
+        self.start_time = start_time
+
+        # Per-file contributions, so replacing a file only subtracts and adds its own share
+        self._loops: Dict[str, int] = {}
+        self._loop_types: Dict[str, Counter] = {}
+        self._nesting: Dict[str, Counter] = {}
+        self._functions_with_loops: Dict[str, int] = {}
+        self._nodes: Dict[str, Dict[str, Dict[str, List[str]]]] = {}
+        self._failed: Dict[str, Dict[str, Any]] = {}
+
+        self.total_loops = 0
+        self.loop_types: Counter = Counter()
+        self.nesting: Counter = Counter()
+        self.functions_with_loops = 0
+
+        # Call graph state: contributing files per node, resolved edges per caller,
+        # callers per unqualified callee name (re-resolved when that name appears or goes)
+        self._node_files: Dict[str, List[str]] = {}
+        self._edges: Dict[str, Set[str]] = {}
+        self._callers_by_name: Dict[str, Set[str]] = {}
+        self._nodes_by_name: Dict[str, Set[str]] = {}
+
+        self.output_data = self.json_output.generate_output(
+            analysis_results=analysis_results,
+            source_files=[Path(file_path) for file_path in analysis_results],
+            total_loops=sum(LoopAnalyzer.count_loops(file_data) for file_data in analysis_results.values()),
+            start_time=start_time
+        )
+        self.source_files = self.output_data['source_files']
+        for file_path, file_data in self.source_files.items():
+            self._add_contribution(file_path, file_data)
+        # The graph from generate_output is kept; the edges are rebuilt to track later changes
+        for name in self.call_graph:
+            self._nodes_by_name.setdefault(self._short(name), set()).add(name)
+        for caller in self.call_graph:
+            self._resolve_edges(caller)
+
+    @property
+    def call_graph(self) -> Dict[str, Any]:
+        """The call graph section of the output."""
+        return self.output_data['call_graph']
+
+    def update(self, file_path: str, file_data: Optional[Dict[str, Any]]) -> None:
+        """Replace the analysis of one file; None removes the file."""
+        old_nodes = set(self._nodes.get(file_path, {}))
+        if file_path in self.source_files:
+            self._remove_contribution(file_path)
+        if file_data is None:
+            self.source_files.pop(file_path, None)
+        elif file_path in self.source_files or self.order_key is None:
+            # Assigning in place keeps the file's position, and with it the order nodes merge in
+            self.source_files[file_path] = file_data
+            self._add_contribution(file_path, file_data)
+        else:
+            self._insert(file_path, file_data)
+            self._add_contribution(file_path, file_data)
+        new_nodes = set(self._nodes.get(file_path, {}))
+        self._update_call_graph(old_nodes | new_nodes)
+        self._update_metadata()
+
+    def _insert(self, file_path: str, file_data: Dict[str, Any]) -> None:
+        """Add a new file at its discovery position, keeping the source_files dict object."""
+        entries = list(self.source_files.items())
+        keys = [self.order_key(Path(path)) for path, _ in entries]
+        entries.insert(bisect.bisect(keys, self.order_key(Path(file_path))), (file_path, file_data))
+        self.source_files.clear()
+        self.source_files.update(entries)
+
+    def _add_contribution(self, file_path: str, file_data: Dict[str, Any]) -> None:
+        """Compute one file's share of the totals and add it."""
+        loop_types = {key: 0 for key in self.output_data['analysis_summary']['loop_types']}
+        nesting_levels: List[int] = []
+        containers = [file_data.get('functions', {})] + \
+            [class_data.get('methods', {}) for class_data in file_data.get('classes', {}).values()]
+        for container in containers:
+            self.json_output._count_loops_in_container(container, loop_types, nesting_levels)
+        for loop in file_data.get('global_loops', []):
+            loop_type = f"{loop.get('type', 'unknown')}s"
+            if loop_type in loop_types:
+                loop_types[loop_type] += 1
+            nesting_levels.append(loop.get('nesting_level', 1))
+
+        self._loops[file_path] = LoopAnalyzer.count_loops(file_data)
+        self._loop_types[file_path] = Counter(loop_types)
+        self._nesting[file_path] = Counter(nesting_levels)
+        self._functions_with_loops[file_path] = sum(
+            1 for container in containers for item in container.values() if item.get('loops'))
+        nodes = self.json_output._generate_call_graph({file_path: file_data})
+        self._nodes[file_path] = {name: {'calls': node['calls'], 'calls_in_loops': node['calls_in_loops']}
+                                  for name, node in nodes.items()}
+
+        if 'analysis_status' in file_data.get('file_info', {}):
+            self._failed[file_path] = {'file': file_path, **file_data['file_info']}
+
+        self.total_loops += self._loops[file_path]
+        self.loop_types.update(self._loop_types[file_path])
+        self.nesting.update(self._nesting[file_path])
+        self.functions_with_loops += self._functions_with_loops[file_path]
+        for name in self._nodes[file_path]:
+            self._node_files.setdefault(name, []).append(file_path)
+
+    def _remove_contribution(self, file_path: str) -> None:
+        """Subtract one file's share of the totals."""
+        self.total_loops -= self._loops.pop(file_path)
+        self.loop_types.subtract(self._loop_types.pop(file_path))
+        self.nesting.subtract(self._nesting.pop(file_path))
+        self.functions_with_loops -= self._functions_with_loops.pop(file_path)
+        self._failed.pop(file_path, None)
+        for name in self._nodes.pop(file_path):
+            self._node_files[name].remove(file_path)
+            if not self._node_files[name]:
+                del self._node_files[name]
+
+    def _update_call_graph(self, touched: Set[str]) -> None:
+        """Rebuild the nodes a file touched and re-resolve the callers whose edges may change."""
+        stale_callers = set(touched)
+        for name in touched:
+            if name in self._node_files:
+                node = self.call_graph.setdefault(name, {'calls': [], 'called_by': [], 'calls_in_loops': []})
+                # Nodes of the same name from several files concatenate their calls in file order
+                node['calls'] = []
+                node['calls_in_loops'] = []
+                contributors = self._node_files[name]
+                if len(contributors) > 1:
+                    contributors = sorted(contributors, key=list(self.source_files).index)
+                for contributor in contributors:
+                    contribution = self._nodes[contributor][name]
+                    node['calls'].extend(c for c in contribution['calls'] if c not in node['calls'])
+                    node['calls_in_loops'].extend(c for c in contribution['calls_in_loops']
+                                                  if c not in node['calls_in_loops'])
+            else:
+                self.call_graph.pop(name, None)
+            # A node appearing or disappearing changes how calls by that name resolve
+            same_name = self._nodes_by_name.setdefault(self._short(name), set())
+            if (name in self._node_files) != (name in same_name):
+                if name in self._node_files:
+                    same_name.add(name)
+                else:
+                    same_name.discard(name)
+                stale_callers |= self._callers_by_name.get(self._short(name), set())
+
+        for caller in stale_callers:
+            self._resolve_edges(caller)
+
+    def _resolve_edges(self, caller: str) -> None:
+        """Re-resolve one caller's calls to nodes and update called_by of old and new targets."""
+        for target in self._edges.pop(caller, set()):
+            if target in self.call_graph and caller in self.call_graph[target]['called_by']:
+                self.call_graph[target]['called_by'].remove(caller)
+        if caller not in self.call_graph:
+            return
+
+        targets = set()
+        for callee in self.call_graph[caller]['calls']:
+            self._callers_by_name.setdefault(self._short(callee), set()).add(caller)
+            if callee in self.call_graph:
+                targets.add(callee)
+            else:
+                targets |= self._nodes_by_name.get(self._short(callee), set()) & self.call_graph.keys()
+        self._edges[caller] = targets
+        for target in targets:
+            called_by = self.call_graph[target]['called_by']
+            if caller not in called_by:
+                called_by.append(caller)
+                called_by.sort()
+
+    def _update_metadata(self) -> None:
+        """Refresh the summary and the metadata totals from the running counts."""
+        nesting_count = sum(self.nesting.values())
+        summary = self.output_data['analysis_summary']
+        summary['loop_types'] = {key: self.loop_types[key] for key in summary['loop_types']}
+        summary['nesting_levels'] = {
+            'max_depth': max((level for level, count in self.nesting.items() if count > 0), default=0),
+            'average_depth': round(sum(level * count for level, count in self.nesting.items()) / nesting_count, 2)
+            if nesting_count else 0,
+        }
+        summary['functions_with_loops'] = self.functions_with_loops
+
+        metadata = self.output_data['metadata']
+        now = datetime.now()
+        metadata['generated_at'] = now.isoformat()
+        metadata['total_files_scanned'] = len(self.source_files)
+        metadata['total_loops_found'] = self.total_loops
+        metadata['analysis_duration_seconds'] = (now - self.start_time).total_seconds()
+        if self._failed:
+            metadata['failed_files'] = list(self._failed.values())
+        else:
+            metadata.pop('failed_files', None)
+
+    @staticmethod
+    def _short(name: str) -> str:
+        """Unqualified name, as JSONOutput matches calls to Class::method nodes."""
+        return name.split('::')[-1]
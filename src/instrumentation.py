@@ -0,0 +1,418 @@
+"""
+Source-to-source loop instrumentation module.
+
+Writes an instrumented copy of the analyzed source tree where every loop
+counts its entries and iterations (and optionally cycles) keyed by
+`loop_id`. A small header-only runtime dumps the counters at exit; the dump
+can be ingested back with `loop_extractor.py annotate --loop-counts`.
+"""
+
+import hashlib
+import logging
+import os
+import shutil
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+try:
+    from clang.cindex import CursorKind, Cursor
+except ImportError as e:
+    raise ImportError("libclang not found. Please install with: pip install libclang") from e
+
+from .config import Config
+from .ast_parser import ASTParser
+from .loop_index import LoopIndex
+
+
+RUNTIME_HEADER_NAME = 'loopx_runtime.h'
+
+RUNTIME_HEADER = r'''/*
+ * loopx_runtime.h - loop counters generated by loop_extractor instrument.
+ *
+ * Counters are plain increments; totals are exact for single-threaded code.
+ * Build with -DLOOPX_CYCLES (or instrument --cycles) to also accumulate
+ * inclusive rdtsc cycles per loop (nanoseconds on non-x86 targets).
+ * Counts are written at exit to $LOOPX_OUTPUT or loopx_counts.<pid>.tsv.
+ */
+#ifndef LOOPX_RUNTIME_H
+#define LOOPX_RUNTIME_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(LOOPX_CYCLES) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define LOOPX_NOW() ((uint64_t)__rdtsc())
+#elif defined(LOOPX_CYCLES)
+#include <time.h>
+static inline uint64_t loopx_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+#define LOOPX_NOW() loopx_now_ns()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct loopx_site {
+    const char *file;
+    const char *loop_id;
+    uint64_t entries;
+    uint64_t iterations;
+    uint64_t cycles;
+} loopx_site;
+
+typedef struct loopx_table {
+    loopx_site *sites;
+    size_t count;
+    struct loopx_table *next;
+} loopx_table;
+
+typedef struct loopx_scope {
+    loopx_site *site;
+    uint64_t start;
+} loopx_scope;
+
+/* Weak definitions so every translation unit shares one registry */
+__attribute__((weak)) loopx_table *loopx_tables = 0;
+__attribute__((weak)) int loopx_dump_registered = 0;
+
+static void loopx_dump(void) {
+    char default_path[64];
+    const char *path = getenv("LOOPX_OUTPUT");
+    if (!path) {
+        snprintf(default_path, sizeof(default_path), "loopx_counts.%ld.tsv", (long)getpid());
+        path = default_path;
+    }
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        return;
+    }
+    fprintf(out, "# loopx v1\tfile\tloop_id\tentries\titerations\tcycles\n");
+    for (loopx_table *table = loopx_tables; table; table = table->next) {
+        for (size_t i = 0; i < table->count; ++i) {
+            const loopx_site *site = &table->sites[i];
+            if (site->entries) {
+                fprintf(out, "%s\t%s\t%llu\t%llu\t%llu\n", site->file, site->loop_id,
+                        (unsigned long long)site->entries, (unsigned long long)site->iterations,
+                        (unsigned long long)site->cycles);
+            }
+        }
+    }
+    fclose(out);
+}
+
+static inline loopx_scope loopx_scope_begin(loopx_site *site) {
+    loopx_scope scope;
+    scope.site = site;
+    ++site->entries;
+#ifdef LOOPX_CYCLES
+    scope.start = LOOPX_NOW();
+#else
+    scope.start = 0;
+#endif
+    return scope;
+}
+
+static inline void loopx_scope_end(loopx_scope *scope) {
+#ifdef LOOPX_CYCLES
+    scope->site->cycles += LOOPX_NOW() - scope->start;
+#else
+    (void)scope;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#define LOOPX_CAT_(a, b) a##b
+#define LOOPX_CAT(a, b) LOOPX_CAT_(a, b)
+
+#define LOOPX_REGISTER(sites) \
+    static loopx_table LOOPX_CAT(sites, _table) = { sites, sizeof(sites) / sizeof(sites[0]), 0 }; \
+    __attribute__((constructor)) static void LOOPX_CAT(sites, _register)(void) { \
+        LOOPX_CAT(sites, _table).next = loopx_tables; \
+        loopx_tables = &LOOPX_CAT(sites, _table); \
+        if (!loopx_dump_registered) { loopx_dump_registered = 1; atexit(loopx_dump); } \
+    }
+
+/* Scope guard closed by the cleanup attribute, so early exits are still timed */
+#define LOOPX_ENTER(sites, idx) \
+    loopx_scope LOOPX_CAT(loopx_scope_, __LINE__) __attribute__((cleanup(loopx_scope_end))) = \
+        loopx_scope_begin(&sites[idx])
+
+#define LOOPX_ITER(sites, idx) (++sites[idx].iterations)
+
+#endif /* LOOPX_RUNTIME_H */
+'''
+
+
+class LoopInstrumenter:
+    """Writes an instrumented copy of the source tree with per-loop counters."""
+
+    LOOP_KINDS = {
+        CursorKind.FOR_STMT: 'for',
+        CursorKind.WHILE_STMT: 'while',
+        CursorKind.DO_STMT: 'do',
+        CursorKind.CXX_FOR_RANGE_STMT: 'for',
+    }
+
+    FUNCTION_KINDS = {
+        CursorKind.FUNCTION_DECL, CursorKind.CXX_METHOD, CursorKind.CONSTRUCTOR,
+        CursorKind.DESTRUCTOR, CursorKind.FUNCTION_TEMPLATE, CursorKind.LAMBDA_EXPR,
+    }
+
+    def __init__(self, config: Config, cycles: bool = False):
+        """Initialize the instrumenter with configuration."""
+        self.config = config
+        self.cycles = cycles
+        self.logger = logging.getLogger(__name__)
+        self.ast_parser = ASTParser(config)
+
+    def instrument_tree(self, analysis_results: Dict[str, Any], output_dir: Path) -> Dict[str, Any]:
+        """Copy the source tree to output_dir and instrument every analyzed file."""
+        source_root = self.config.source_path.resolve()
+        output_dir = output_dir.resolve()
+        if output_dir == source_root or source_root in output_dir.parents:
+            raise ValueError("Output directory must be outside the source tree")
+
+        shutil.copytree(source_root, output_dir, symlinks=True, dirs_exist_ok=True)
+        runtime_header = output_dir / RUNTIME_HEADER_NAME
+        runtime_header.write_text(RUNTIME_HEADER, encoding='utf-8')
+
+        index = LoopIndex(analysis_results)
+        loop_ids: Dict[Tuple[str, int, int], str] = {}
+        for file_path, _, loop in index.iter_loops():
+            location = loop.get('location', {})
+            key = (file_path, location.get('start_line', 0), location.get('start_column', 0))
+            loop_ids.setdefault(key, loop.get('loop_id', ''))
+
+        files_instrumented = 0
+        loops_instrumented = 0
+        for file_path in analysis_results:
+            source_file = Path(file_path).resolve()
+            try:
+                relative = source_file.relative_to(source_root)
+            except ValueError:
+                self.logger.warning(f"Skipping {file_path}: not under {source_root}")
+                continue
+
+            count = self.instrument_file(Path(file_path), file_path, output_dir / relative,
+                                         runtime_header, loop_ids)
+            if count:
+                files_instrumented += 1
+                loops_instrumented += count
+
+        self.logger.info(f"Instrumented {loops_instrumented} loops in {files_instrumented} files under {output_dir}")
+        return {
+            'output_dir': str(output_dir),
+            'runtime_header': str(runtime_header),
+            'files_instrumented': files_instrumented,
+            'loops_instrumented': loops_instrumented,
+        }
+
+    def instrument_file(self, source_file: Path, file_key: str, destination: Path,
+                        runtime_header: Path, loop_ids: Dict[Tuple[str, int, int], str]) -> int:
+        """Instrument one file; returns the number of loops instrumented."""
+        translation_unit = self.ast_parser.parse_file(source_file)
+        if translation_unit is None:
+            self.logger.warning(f"Failed to parse {source_file}; copied without instrumentation")
+            return 0
+
+        source = source_file.read_bytes()
+        sites: List[str] = []
+        insertions: List[Tuple[int, int, int, bytes]] = []
+        table = 'loopx_sites_' + hashlib.sha1(file_key.encode('utf-8')).hexdigest()[:12]
+
+        def visit(cursor: Cursor, depth: int, in_constexpr: bool) -> None:
+            for child in cursor.get_children():
+                if not self.ast_parser.is_in_file(child, source_file):
+                    continue
+
+                child_constexpr = in_constexpr
+                if child.kind in self.FUNCTION_KINDS:
+                    child_constexpr = self._is_constexpr(child, source)
+
+                if child.kind in self.LOOP_KINDS and not child_constexpr:
+                    site_index = len(sites)
+                    if self._instrument_loop(child, depth, source, table, site_index, insertions):
+                        location = child.location
+                        loop_id = loop_ids.get((file_key, child.extent.start.line, child.extent.start.column),
+                                               f"loop_{location.line}_{location.column}")
+                        sites.append(loop_id)
+                    visit(child, depth + 1, child_constexpr)
+                else:
+                    visit(child, depth, child_constexpr)
+
+        visit(translation_unit.cursor, 0, False)
+        if not sites:
+            return 0
+
+        include_path = os.path.relpath(runtime_header, destination.parent)
+        site_entries = ', '.join(
+            f'{{"{self._c_string(file_key)}", "{self._c_string(loop_id)}", 0, 0, 0}}' for loop_id in sites
+        )
+        preamble = [
+            f'#ifndef {table.upper()}',
+            f'#define {table.upper()}',
+        ]
+        if self.cycles:
+            preamble.append('#define LOOPX_CYCLES 1')
+        preamble += [
+            f'#include "{include_path}"',
+            f'static loopx_site {table}[] = {{{site_entries}}};',
+            f'LOOPX_REGISTER({table})',
+            '#endif',
+            # Keep diagnostics, debug info and profiles on the original line numbers
+            f'#line 1 "{self._c_string(str(source_file))}"',
+            '',
+        ]
+        insertions.append((0, 0, 0, '\n'.join(preamble).encode('utf-8')))
+
+        destination.parent.mkdir(parents=True, exist_ok=True)
+        destination.write_bytes(self._apply_insertions(source, insertions))
+        self.logger.debug(f"Instrumented {len(sites)} loops in {source_file}")
+        return len(sites)
+
+    def _instrument_loop(self, cursor: Cursor, depth: int, source: bytes, table: str,
+                         site_index: int, insertions: List[Tuple[int, int, int, bytes]]) -> bool:
+        """Queue the counter insertions for one loop; returns False if it must be skipped."""
+        children = list(cursor.get_children())
+        if not children:
+            return False
+
+        body = children[0] if cursor.kind == CursorKind.DO_STMT else children[-1]
+        loop_start = cursor.extent.start.offset
+        loop_end = cursor.extent.end.offset
+        body_start = body.extent.start.offset
+        body_end = body.extent.end.offset
+
+        # Loops produced by macro expansion do not have editable extents
+        keyword = self.LOOP_KINDS[cursor.kind].encode('ascii')
+        if not source[loop_start:].startswith(keyword) or not (loop_start <= body_start <= body_end <= loop_end):
+            self.logger.debug(f"Skipping loop at line {cursor.location.line}: extent is not plain source")
+            return False
+
+        # Insertions are (offset, is_close, level, text); levels order nested braces
+        enter = f'{{ LOOPX_ENTER({table}, {site_index}); '.encode('utf-8')
+        iteration = f' LOOPX_ITER({table}, {site_index});'.encode('utf-8')
+        wrapper_level = depth * 2
+        body_level = depth * 2 + 1
+
+        insertions.append((loop_start, 0, wrapper_level, enter))
+        insertions.append((self._statement_end(source, loop_end), 1, wrapper_level, b' }'))
+
+        if body.kind == CursorKind.COMPOUND_STMT and source[body_start:body_start + 1] == b'{':
+            insertions.append((body_start + 1, 0, body_level, iteration))
+        else:
+            # Single statement body: brace it so the counter runs with it
+            insertions.append((body_start, 0, body_level, b'{' + iteration + b' '))
+            insertions.append((self._statement_end(source, body_end), 1, body_level, b' }'))
+
+        return True
+
+    def _statement_end(self, source: bytes, offset: int) -> int:
+        """Extend an extent end past the terminating semicolon, if any."""
+        position = offset
+        while position < len(source) and source[position:position + 1] in (b' ', b'\t'):
+            position += 1
+        if source[position:position + 1] == b';':
+            return position + 1
+        return offset
+
+    def _apply_insertions(self, source: bytes, insertions: List[Tuple[int, int, int, bytes]]) -> bytes:
+        """Apply insertions; at one offset closings go inner-first, then openings outer-first."""
+        def order(insertion: Tuple[int, int, int, bytes]) -> Tuple[int, int, int]:
+            offset, is_close, level, _ = insertion
+            return (offset, 0 if is_close else 1, -level if is_close else level)
+
+        result = []
+        position = 0
+        for offset, _, _, text in sorted(insertions, key=order):
+            result.append(source[position:offset])
+            result.append(text)
+            position = offset
+        result.append(source[position:])
+        return b''.join(result)
+
+    def _is_constexpr(self, cursor: Cursor, source: bytes) -> bool:
+        """Counters cannot run in constant evaluation, so skip constexpr functions."""
+        start = cursor.extent.start.offset
+        for child in cursor.get_children():
+            if child.kind == CursorKind.COMPOUND_STMT:
+                return b'constexpr' in source[start:child.extent.start.offset]
+        return False
+
+    def _c_string(self, value: str) -> str:
+        """Escape a value for a C string literal."""
+        return value.replace('\\', '\\\\').replace('"', '\\"')
+
+
+class LoopCountsIngest:
+    """Reads loopx runtime dumps and annotates loops with measured counts."""
+
+    def __init__(self):
+        self.logger = logging.getLogger(__name__)
+        # (file, loop_id) -> [entries, iterations, cycles], summed across dumps
+        self.counts: Dict[Tuple[str, str], List[int]] = {}
+
+    def load(self, dump_path: Path) -> None:
+        """Load one counter dump."""
+        with open(dump_path, 'r', encoding='utf-8', errors='ignore') as f:
+            for line in f:
+                if line.startswith('#') or not line.strip():
+                    continue
+                fields = line.rstrip('\n').split('\t')
+                if len(fields) < 5:
+                    continue
+                totals = self.counts.setdefault((fields[0], fields[1]), [0, 0, 0])
+                for i, value in enumerate(fields[2:5]):
+                    totals[i] += int(value)
+
+    def annotate(self, analysis_results: Dict[str, Any]) -> Dict[str, Any]:
+        """Attach measured entries, iterations and cycles to loop records."""
+        index = LoopIndex(analysis_results)
+        by_loop: Dict[Tuple[str, str], List[int]] = {}
+        unmatched = 0
+        for (file_name, loop_id), totals in self.counts.items():
+            file_key = index.resolve_file(file_name)
+            if file_key is None:
+                unmatched += 1
+                continue
+            by_loop[(file_key, loop_id)] = totals
+
+        measured = 0
+        for file_path, _, loop in index.iter_loops():
+            totals = by_loop.get((file_path, loop.get('loop_id', '')))
+            if totals is None:
+                continue
+
+            entries, iterations, cycles = totals
+            average = round(iterations / entries, 2) if entries else 0
+            measurement = {
+                'entries': entries,
+                'iterations': iterations,
+                'average_trip_count': average,
+            }
+            if cycles:
+                measurement['cycles'] = cycles
+                measurement['cycles_per_iteration'] = round(cycles / iterations, 2) if iterations else 0
+
+            loop.setdefault('extensions', {})['instrumentation'] = measurement
+            if entries:
+                loop['loop_bounds']['estimated_iterations'] = average
+            measured += 1
+
+        self.logger.info(f"Applied instrumentation counts to {measured} loop records")
+        return {
+            'sites_loaded': len(self.counts),
+            'sites_unmatched': unmatched,
+            'loops_measured': measured,
+        }
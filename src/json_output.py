@@ -9,6 +9,7 @@ from typing import Dict, List, Any
 from datetime import datetime
 
 from .config import Config
+from .analysis_passes import resolve_passes, describe_passes
 from . import __version__
 
 
@@ -35,8 +36,18 @@ class JSONOutput:
             'total_files_scanned': len(source_files),
             'total_loops_found': total_loops,
             'analysis_duration_seconds': (end_time - start_time).total_seconds(),
+            'passes': describe_passes(resolve_passes(self.config.passes)),
         }
         
+        # Files whose analysis was killed for exceeding the per-file budget
+        failed_files = [
+            {'file': file_path, **file_data['file_info']}
+            for file_path, file_data in analysis_results.items()
+            if 'analysis_status' in file_data.get('file_info', {})
+        ]
+        if failed_files:
+            metadata['failed_files'] = failed_files
+        
         # Generate analysis summary
         analysis_summary = self._generate_analysis_summary(analysis_results)
         
@@ -80,7 +91,7 @@ class JSONOutput:
             
             # Count global loops
             for loop in file_data.get('global_loops', []):
-                loop_type = loop.get('type', 'unknown')
+                loop_type = f"{loop.get('type', 'unknown')}s"
                 if loop_type in loop_types:
                     loop_types[loop_type] += 1
                 nesting_levels.append(loop.get('nesting_level', 1))
@@ -119,7 +130,7 @@ class JSONOutput:
                               nesting_levels: List[int]) -> None:
         """Recursively count loops and collect nesting levels."""
         for loop in loops:
-            loop_type = loop.get('type', 'unknown')
+            loop_type = f"{loop.get('type', 'unknown')}s"
             if loop_type in loop_types:
                 loop_types[loop_type] += 1
             
@@ -162,12 +173,36 @@ class JSONOutput:
                         
                         # Extract function calls from loops
                         self._extract_calls_from_loops(method_data.get('loops', []), call_graph[qualified_name])
+            
+            self._resolve_callers(call_graph)
         
         except Exception as e:
             self.logger.warning(f"Error generating call graph: {e}")
         
         return call_graph
     
+    def _resolve_callers(self, call_graph: Dict[str, Any]) -> None:
+        """Fill called_by from the calls of every node.
+
+        Calls are recorded by the name written at the call site, so a call to
+        `method` matches `Class::method` when no node has the exact name. The
+        graph is built from all files at once, so calls across files (or
+        across shards, after a merge) resolve the same way.
+        """
+        by_name: Dict[str, List[str]] = {}
+        for node_name in call_graph:
+            by_name.setdefault(node_name.split('::')[-1], []).append(node_name)
+        
+        for caller, call_info in call_graph.items():
+            for callee in call_info['calls']:
+                targets = [callee] if callee in call_graph else by_name.get(callee.split('::')[-1], [])
+                for target in targets:
+                    if caller not in call_graph[target]['called_by']:
+                        call_graph[target]['called_by'].append(caller)
+        
+        for call_info in call_graph.values():
+            call_info['called_by'].sort()
+    
     def _extract_calls_from_loops(self, loops: List[Dict], call_info: Dict[str, List]) -> None:
         """Extract function calls from loops for call graph."""
         for loop in loops:
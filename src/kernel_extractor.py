@@ -0,0 +1,398 @@
+"""
+Loop kernel extraction module for standalone micro-benchmarks.
+
+Outlines a selected loop nest into a self-contained C++ file: the variables
+the loop reads and writes become synthesized inputs, user classes are
+reduced to the fields the loop touches, and a timing harness runs the
+kernel with configurable problem sizes.
+"""
+
+import logging
+import re
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+try:
+    from clang.cindex import CursorKind, Cursor, TypeKind, Diagnostic
+except ImportError as e:
+    raise ImportError("libclang not found. Please install with: pip install libclang") from e
+
+from .config import Config
+from .ast_parser import ASTParser
+from .loop_index import LoopIndex
+
+
+class KernelExtractor:
+    """Outlines one loop nest into a compilable benchmark."""
+
+    LOOP_KINDS = {
+        CursorKind.FOR_STMT, CursorKind.WHILE_STMT,
+        CursorKind.DO_STMT, CursorKind.CXX_FOR_RANGE_STMT,
+    }
+
+    INTEGER_KINDS = {
+        TypeKind.INT, TypeKind.UINT, TypeKind.LONG, TypeKind.ULONG, TypeKind.LONGLONG,
+        TypeKind.ULONGLONG, TypeKind.SHORT, TypeKind.USHORT, TypeKind.CHAR_S, TypeKind.UCHAR,
+    }
+
+    FLOAT_KINDS = {TypeKind.FLOAT, TypeKind.DOUBLE, TypeKind.LONGDOUBLE}
+
+    def __init__(self, config: Config):
+        """Initialize the extractor with configuration."""
+        self.config = config
+        self.logger = logging.getLogger(__name__)
+        self.ast_parser = ASTParser(config)
+        self.warnings: List[str] = []
+
+    def find_loop(self, analysis_results: Dict[str, Any], loop_id: str,
+                  file_filter: Optional[str] = None) -> Tuple[str, str, Dict[str, Any]]:
+        """Locate a loop record by loop_id, optionally restricted to a file."""
+        index = LoopIndex(analysis_results)
+        matches = {}
+        for file_path, function_name, loop in index.iter_loops():
+            if loop.get('loop_id') != loop_id:
+                continue
+            if file_filter and index.resolve_file(file_filter) != file_path:
+                continue
+            # Nested loops are recorded twice; keep one record per location
+            matches.setdefault(file_path, (file_path, function_name, loop))
+
+        if not matches:
+            raise ValueError(f"Loop not found: {loop_id}")
+        if len(matches) > 1:
+            raise ValueError(f"Loop id {loop_id} exists in several files, use --file: {', '.join(matches)}")
+        return next(iter(matches.values()))
+
+    def extract(self, file_path: str, function_name: str, loop: Dict[str, Any],
+                sizes: Dict[str, int], default_size: int, repetitions: int) -> str:
+        """Generate the benchmark source for one loop record."""
+        self.warnings = []
+        source_file = Path(file_path)
+        translation_unit = self.ast_parser.parse_file(source_file)
+        if translation_unit is None:
+            raise ValueError(f"Failed to parse {file_path}")
+        # Error recovery turns unresolved types into int and drops member accesses,
+        # so a kernel generated from such a unit would not compile
+        errors = [diagnostic for diagnostic in translation_unit.diagnostics
+                  if diagnostic.severity >= Diagnostic.Error]
+        if errors:
+            first = errors[0]
+            where = f"{first.location.file.name}:{first.location.line}" if first.location.file else file_path
+            raise ValueError(f"{file_path} has {len(errors)} parse errors ({where}: {first.spelling}); "
+                             f"fix the include paths or compiler flags of the analysis and re-run it")
+
+        location = loop['location']
+        loop_cursor = self._find_loop_cursor(translation_unit.cursor, source_file,
+                                             location['start_line'], location['start_column'])
+        if loop_cursor is None:
+            raise ValueError(f"Loop {loop['loop_id']} not found in {file_path}; is the analysis stale?")
+
+        loop_text = self.ast_parser.get_source_text(loop_cursor)
+        variables, fields_by_class, functions = self._collect_free_symbols(loop_cursor, source_file)
+        unresolved = [var['name'] for var in variables if self._is_invalid(var['type'])]
+        if unresolved:
+            raise ValueError(f"Types of {', '.join(unresolved)} could not be resolved in {file_path}; "
+                             f"no kernel written")
+        container_size = max([default_size] + list(sizes.values()))
+
+        lines = [
+            f"// Micro-benchmark generated by loop_extractor extract-kernel",
+            f"// Source: {file_path}:{location['start_line']} ({function_name or 'global'}, {loop['loop_id']})",
+            f"// Build: c++ -O2 -std={self.config.cpp_standard} <this file> && ./a.out [repetitions]",
+            '',
+        ]
+
+        includes = {'#include <chrono>', '#include <cstdio>', '#include <cstdlib>', '#include <vector>'}
+        includes.update(self._system_includes(source_file))
+        lines += sorted(includes) + ['']
+
+        lines.append('// Keep results observable so the optimizer cannot drop the kernel')
+        lines.append('template <typename T> static inline void loopx_escape(T &value) {')
+        lines.append('    asm volatile("" : : "g"(&value) : "memory");')
+        lines.append('}')
+        lines.append('')
+
+        for class_name, fields in fields_by_class.items():
+            lines.append(f"// Reduced from {class_name}: only the fields the loop uses")
+            lines.append(f"struct {class_name} {{")
+            for field_name, field_type in fields.items():
+                lines.append(f"    {field_type} {field_name};")
+            lines.append('};')
+            lines.append('')
+
+        for function_text in functions:
+            lines.append(function_text)
+            lines.append('')
+
+        params = ', '.join(self._parameter(var) for var in variables)
+        lines.append(f"__attribute__((noinline)) static void kernel({params}) {{")
+        # Re-indent the body relative to the loop's original column
+        indent = location['start_column'] - 1
+        for i, line in enumerate(loop_text.splitlines()):
+            if i > 0 and line[:indent].strip() == '':
+                line = line[indent:]
+            lines.append('    ' + line)
+        lines.append('}')
+        lines.append('')
+
+        # Harness arguments are prefixed so they cannot clash with loop inputs such as argc
+        lines.append('int main(int loopx_argc, char **loopx_argv) {')
+        lines.append(f"    const int repetitions = loopx_argc > 1 ? std::atoi(loopx_argv[1]) : {repetitions};")
+        for var in variables:
+            lines += ['    ' + line for line in self._declare(var, sizes, default_size, container_size, fields_by_class)]
+        args = ', '.join(var['name'] for var in variables)
+        lines += [
+            '',
+            f"    kernel({args});  // warm-up",
+            '    auto start = std::chrono::steady_clock::now();',
+            '    for (int rep = 0; rep < repetitions; ++rep) {',
+            f"        kernel({args});",
+        ]
+        lines += [f"        loopx_escape({var['name']});" for var in variables]
+        lines += [
+            '    }',
+            '    auto end = std::chrono::steady_clock::now();',
+            '    double total_us = std::chrono::duration<double, std::micro>(end - start).count();',
+            f"    std::printf(\"{loop['loop_id']}: %.3f us per kernel call over %d repetitions\\n\",",
+            '                total_us / (repetitions > 0 ? repetitions : 1), repetitions);',
+            '    return 0;',
+            '}',
+        ]
+
+        if self.warnings:
+            lines = [f"// TODO: {warning}" for warning in self.warnings] + lines
+        return '\n'.join(lines) + '\n'
+
+    def _find_loop_cursor(self, cursor: Cursor, source_file: Path, line: int, column: int) -> Optional[Cursor]:
+        """Find the loop statement starting at line:column."""
+        for child in cursor.get_children():
+            if child.location.file and not self.ast_parser.is_in_file(child, source_file):
+                continue
+            extent = child.extent
+            if not (extent.start.line <= line <= extent.end.line):
+                continue
+            if child.kind in self.LOOP_KINDS and extent.start.line == line and extent.start.column == column:
+                return child
+            found = self._find_loop_cursor(child, source_file, line, column)
+            if found is not None:
+                return found
+        return None
+
+    def _collect_free_symbols(self, loop_cursor: Cursor, source_file: Path):
+        """Find variables, implicit member fields and local functions used but not declared in the loop."""
+        start = loop_cursor.extent.start.offset
+        end = loop_cursor.extent.end.offset
+        variables: Dict[str, Dict[str, Any]] = {}
+        fields_by_class: Dict[str, Dict[str, str]] = {}
+        functions: Dict[str, str] = {}
+
+        def declared_inside(decl: Cursor) -> bool:
+            decl_file = decl.location.file
+            return (decl_file is not None and self.ast_parser.is_in_file(decl, source_file)
+                    and start <= decl.extent.start.offset <= end)
+
+        def visit(cursor: Cursor) -> None:
+            for child in cursor.get_children():
+                referenced = child.referenced
+                if child.kind == CursorKind.DECL_REF_EXPR and referenced is not None:
+                    if (referenced.kind in {CursorKind.VAR_DECL, CursorKind.PARM_DECL}
+                            and not declared_inside(referenced) and not self._is_global(referenced)):
+                        variables.setdefault(referenced.spelling, {
+                            'name': referenced.spelling,
+                            'type': referenced.type,
+                        })
+                    elif referenced.kind == CursorKind.FUNCTION_DECL:
+                        self._collect_function(referenced, source_file, functions)
+                elif child.kind == CursorKind.MEMBER_REF_EXPR and referenced is not None:
+                    if referenced.kind == CursorKind.FIELD_DECL:
+                        owner = referenced.semantic_parent
+                        base = list(child.get_children())
+                        if not base or base[0].kind == CursorKind.CXX_THIS_EXPR:
+                            # Implicit this->field becomes a plain input variable
+                            variables.setdefault(referenced.spelling, {
+                                'name': referenced.spelling,
+                                'type': referenced.type,
+                            })
+                        elif owner is not None and self._is_user_type(owner):
+                            if self._is_invalid(referenced.type):
+                                raise ValueError(f"Type of field {owner.spelling}::{referenced.spelling} "
+                                                 f"could not be resolved; no kernel written")
+                            fields_by_class.setdefault(owner.spelling, {})[referenced.spelling] = \
+                                self._type_spelling(referenced.type)
+                    elif referenced.kind == CursorKind.CXX_METHOD:
+                        self.warnings.append(f"method call {referenced.spelling}() needs a stub")
+                visit(child)
+
+        visit(loop_cursor)
+
+        ordered = sorted(variables.values(), key=lambda var: var['name'])
+        return ordered, fields_by_class, list(functions.values())
+
+    def _collect_function(self, decl: Cursor, source_file: Path, functions: Dict[str, str]) -> None:
+        """Copy free functions defined in the same file into the benchmark."""
+        if decl.spelling in functions:
+            return
+        definition = decl.get_definition()
+        if definition is not None and self.ast_parser.is_in_file(definition, source_file):
+            functions[decl.spelling] = 'static ' + self.ast_parser.get_source_text(definition)
+        elif definition is None or self._is_user_type(definition):
+            self.warnings.append(f"call to {decl.spelling}() needs a definition")
+
+    def _is_global(self, decl: Cursor) -> bool:
+        """Globals from system headers (e.g. std::cout) are used as-is."""
+        parent = decl.semantic_parent
+        return (parent is not None and parent.kind in {CursorKind.TRANSLATION_UNIT, CursorKind.NAMESPACE}
+                and not self._is_user_type(decl))
+
+    def _is_user_type(self, cursor: Cursor) -> bool:
+        """A declaration is user code when it lives under the analyzed source tree."""
+        location_file = cursor.location.file
+        if location_file is None:
+            return False
+        try:
+            Path(location_file.name).resolve().relative_to(self.config.source_path.resolve())
+            return True
+        except ValueError:
+            return False
+
+    def _is_invalid(self, type_obj) -> bool:
+        """Whether clang could not resolve a type (or the type it refers to or contains)."""
+        while type_obj.kind in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE, TypeKind.POINTER}:
+            type_obj = type_obj.get_pointee()
+        while type_obj.kind in {TypeKind.CONSTANTARRAY, TypeKind.INCOMPLETEARRAY}:
+            type_obj = type_obj.element_type
+        return type_obj.kind == TypeKind.INVALID or type_obj.get_canonical().kind == TypeKind.INVALID
+
+    def _type_spelling(self, type_obj) -> str:
+        """Spell a type for a declaration, dropping references and top-level const."""
+        if type_obj.kind in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE}:
+            type_obj = type_obj.get_pointee()
+        spelling = type_obj.spelling
+        spelling = re.sub(r'^const\s+', '', spelling)
+        declaration = type_obj.get_declaration()
+        if declaration is not None and declaration.kind in {CursorKind.CLASS_DECL, CursorKind.STRUCT_DECL} \
+                and self._is_user_type(declaration):
+            # User classes are re-declared at global scope under their plain name
+            return declaration.spelling
+        return spelling
+
+    def _parameter(self, var: Dict[str, Any]) -> str:
+        """Declare a kernel parameter by reference so writes stay visible to the harness."""
+        type_obj = var['type']
+        if type_obj.kind in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE}:
+            type_obj = type_obj.get_pointee()
+        if type_obj.kind == TypeKind.CONSTANTARRAY:
+            dims = []
+            while type_obj.kind == TypeKind.CONSTANTARRAY:
+                dims.append(f"[{type_obj.element_count}]")
+                type_obj = type_obj.element_type
+            return f"{self._type_spelling(type_obj)} (&{var['name']}){''.join(dims)}"
+        if type_obj.kind == TypeKind.INCOMPLETEARRAY:
+            # Unsized array parameters (e.g. argv) decay to pointers
+            return f"{self._type_spelling(type_obj.element_type)} *{var['name']}"
+        return f"{self._type_spelling(type_obj)} &{var['name']}"
+
+    def _declare(self, var: Dict[str, Any], sizes: Dict[str, int], default_size: int,
+                 container_size: int, fields_by_class: Dict[str, Dict[str, str]]) -> List[str]:
+        """Declare and initialize one input variable."""
+        name = var['name']
+        type_obj = var['type']
+        if type_obj.kind in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE}:
+            type_obj = type_obj.get_pointee()
+        canonical = type_obj.get_canonical()
+        type_name = self._type_spelling(type_obj)
+
+        if canonical.kind in self.INTEGER_KINDS:
+            return [f"{type_name} {name} = {sizes.get(name, default_size)};"]
+        if canonical.kind in self.FLOAT_KINDS:
+            return [f"{type_name} {name} = 1.0;"]
+        if canonical.kind == TypeKind.BOOL:
+            return [f"{type_name} {name} = true;"]
+        if canonical.kind in {TypeKind.POINTER, TypeKind.INCOMPLETEARRAY}:
+            if canonical.kind == TypeKind.POINTER:
+                pointee = self._type_spelling(canonical.get_pointee())
+            else:
+                pointee = self._type_spelling(canonical.element_type)
+            size = f"{container_size} * {container_size}"
+            return [
+                f"std::vector<{pointee}> {name}_storage({size});",
+                f"{pointee} *{name} = {name}_storage.data();",
+            ]
+        if canonical.kind == TypeKind.CONSTANTARRAY:
+            self.warnings.append(f"array {name} is declared with its original extent")
+            return [self._array_declarator(type_obj, name)]
+
+        if type_name in fields_by_class:
+            lines = [f"{type_name} {name};"]
+            for field_name, field_type in fields_by_class[type_name].items():
+                lines += self._initialize_member(f"{name}.{field_name}", field_type, sizes, default_size, container_size)
+            return lines
+
+        return [f"{type_name} {name};"] + self._initialize_member(name, type_name, sizes, default_size, container_size)
+
+    def _initialize_member(self, expression: str, type_name: str, sizes: Dict[str, int],
+                           default_size: int, container_size: int) -> List[str]:
+        """Size containers and set scalars for an lvalue of the given spelled type."""
+        name = expression.split('.')[-1]
+        depth, element = self._vector_element(type_name)
+        if depth == 0:
+            if re.fullmatch(r'(unsigned\s+)?(int|long|short|size_t|std::size_t|long long)', type_name):
+                return [f"{expression} = {sizes.get(name, default_size)};"]
+            if type_name in {'double', 'float', 'long double'}:
+                return [f"{expression} = 1.0;"]
+            self.warnings.append(f"{expression} of type {type_name} is default-constructed")
+            return []
+
+        # Nested std::vector: size every dimension to the largest configured size
+        value = f"{element}(1)" if element in {'double', 'float', 'int', 'long'} else f"{element}()"
+        for level in range(1, depth + 1):
+            value = f"{self._vector_type(element, level)}({container_size}, {value})"
+        return [f"{expression} = {value};"]
+
+    def _vector_element(self, type_name: str) -> Tuple[int, str]:
+        """Return the std::vector nesting depth and innermost element type."""
+        depth = 0
+        element = type_name.strip()
+        while element.startswith('std::vector<') or element.startswith('vector<'):
+            inner = element[element.index('<') + 1:element.rindex('>')]
+            # Drop an explicit allocator argument at the top nesting level
+            level = 0
+            for i, char in enumerate(inner):
+                if char == '<':
+                    level += 1
+                elif char == '>':
+                    level -= 1
+                elif char == ',' and level == 0:
+                    inner = inner[:i]
+                    break
+            element = inner.strip()
+            depth += 1
+        return depth, element
+
+    def _vector_type(self, element: str, depth: int) -> str:
+        """Spell a nested std::vector type of the given depth."""
+        spelled = element
+        for _ in range(depth):
+            spelled = f"std::vector<{spelled}>"
+        return spelled
+
+    def _array_declarator(self, type_obj, name: str) -> str:
+        """Spell a C array declaration, e.g. `double name[10][10]`."""
+        dims = []
+        while type_obj.kind == TypeKind.CONSTANTARRAY:
+            dims.append(type_obj.element_count)
+            type_obj = type_obj.element_type
+        return f"{self._type_spelling(type_obj)} {name}{''.join(f'[{dim}]' for dim in dims)} = {{}};"
+
+    def _system_includes(self, source_file: Path) -> List[str]:
+        """Angle-bracket includes of the original file; project headers are not copied."""
+        includes = []
+        try:
+            with open(source_file, 'r', encoding='utf-8', errors='ignore') as f:
+                for line in f:
+                    stripped = line.strip()
+                    if re.match(r'#\s*include\s*<[^>]+>', stripped):
+                        includes.append(re.sub(r'#\s*include\s*', '#include ', stripped))
+        except OSError:
+            pass
+        return includes
@@ -0,0 +1,336 @@
+"""
+Optional LLVM IR backend for compiler-grade loop information.
+
+Each translation unit is compiled to LLVM IR with the local clang using the
+same flags as the AST parser. `opt` analysis passes then provide loop
+structure, ScalarEvolution trip counts and vectorizer legality, which are
+mapped back onto the AST loop records through the `!llvm.loop` debug locations.
+"""
+
+import logging
+import re
+import shutil
+import subprocess
+import tempfile
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+from .config import Config
+from .loop_index import LoopIndex
+from .opt_remarks import OptRemarksIngest
+
+
+class LLVMBackend:
+    """Runs clang/opt on a translation unit and annotates its loops."""
+
+    SOURCE_EXTENSIONS = {'.c', '.cpp', '.cc', '.cxx'}
+
+    # Canonicalize loops so ScalarEvolution can compute trip counts
+    ANALYSIS_PIPELINE = ('function(mem2reg,loop-simplify,lcssa,loop(loop-rotate,indvars),'
+                         'print<loops>,print<scalar-evolution>)')
+    VECTORIZE_PIPELINE = 'function(loop-vectorize)'
+
+    COMMAND_TIMEOUT_SECONDS = 300
+
+    LOOP_INFO_FUNCTION = re.compile(r"^Loop info for function '(.+)':")
+    LOOP_AT_DEPTH = re.compile(r'^\s*Loop at depth (\d+) containing: (.*)$')
+    SCEV_FUNCTION = re.compile(r'^Determining loop execution counts for: @(.+)$')
+    SCEV_LOOP = re.compile(r'^Loop %([^:]+): (.*)$')
+    IR_DEFINE = re.compile(r'^define .*@("?[^"(]+"?)\(')
+    IR_LOOP_BRANCH = re.compile(r'^\s*br .*!llvm\.loop (![0-9]+)')
+    IR_LABEL = re.compile(r'label %([-\w.$"]+)')
+    IR_METADATA = re.compile(r'^(![0-9]+) = (?:distinct )?(.*)$')
+    METADATA_REF = re.compile(r'![0-9]+')
+
+    def __init__(self, config: Config):
+        """Initialize the backend and locate the LLVM tools."""
+        self.config = config
+        self.logger = logging.getLogger(__name__)
+        self.clang = shutil.which(config.clang_path)
+        self.opt = shutil.which(config.opt_path)
+
+    def is_available(self) -> bool:
+        """Check that both clang and opt can be executed."""
+        if not self.clang:
+            self.logger.error(f"clang not found: {self.config.clang_path}")
+        if not self.opt:
+            self.logger.error(f"opt not found: {self.config.opt_path}")
+        return bool(self.clang and self.opt)
+
+    def analyze_file(self, file_path: Path, file_analysis: Dict[str, Any]) -> bool:
+        """Compile one translation unit and annotate its loops with LLVM analysis."""
+        if file_path.suffix not in self.SOURCE_EXTENSIONS:
+            # Headers are covered through the translation units that include them
+            return False
+
+        with tempfile.TemporaryDirectory(prefix='loop_extractor_llvm_') as tmp:
+            tmp_dir = Path(tmp)
+            ir_file = tmp_dir / 'tu.ll'
+            canonical_file = tmp_dir / 'canonical.ll'
+            remarks_file = tmp_dir / 'vectorize.opt.yaml'
+
+            flags = self.config.get_compiler_flags(file_path)
+
+            compile_cmd = [
+                self.clang, '-S', '-emit-llvm', '-g', '-O0',
+                '-Xclang', '-disable-O0-optnone', '-fno-discard-value-names',
+                *flags, str(file_path), '-o', str(ir_file),
+            ]
+            if not self._run(compile_cmd, file_path):
+                return False
+
+            analysis_cmd = [
+                self.opt, '-S', f'-passes={self.ANALYSIS_PIPELINE}',
+                str(ir_file), '-o', str(canonical_file),
+            ]
+            analysis = self._run(analysis_cmd, file_path)
+            if analysis is None:
+                return False
+
+            vectorize_cmd = [
+                self.opt, '-disable-output', f'-passes={self.VECTORIZE_PIPELINE}',
+                f'-pass-remarks-output={remarks_file}', str(canonical_file),
+            ]
+            vectorize_ok = self._run(vectorize_cmd, file_path) is not None
+
+            loops = self._collect_loops(analysis.stderr, canonical_file.read_text(errors='ignore'))
+
+            vectorizer = OptRemarksIngest()
+            if vectorize_ok and remarks_file.exists():
+                vectorizer.load(remarks_file, 'clang')
+
+        summary = self.annotate(file_path, file_analysis, loops, vectorizer)
+        file_analysis.setdefault('extensions', {})['llvm'] = summary
+        return True
+
+    def _run(self, command: List[str], file_path: Path) -> Optional[subprocess.CompletedProcess]:
+        """Run an LLVM tool, returning None on failure."""
+        self.logger.debug(f"Running: {' '.join(command)}")
+        try:
+            result = subprocess.run(command, capture_output=True, text=True,
+                                    timeout=self.COMMAND_TIMEOUT_SECONDS)
+        except subprocess.TimeoutExpired:
+            self.logger.warning(f"LLVM backend timed out on {file_path}")
+            return None
+        except OSError as e:
+            self.logger.warning(f"LLVM backend could not run {command[0]}: {e}")
+            return None
+
+        if result.returncode != 0:
+            self.logger.warning(f"LLVM backend failed on {file_path}: {result.stderr.strip()[:500]}")
+            return None
+        return result
+
+    def _collect_loops(self, analysis_output: str, ir_text: str) -> List[Dict[str, Any]]:
+        """Combine loop structure, trip counts and debug locations into loop records."""
+        depths, counts = self._parse_analysis(analysis_output)
+        latch_metadata, metadata = self._parse_ir(ir_text)
+
+        loops = []
+        for (function, header), depth in depths.items():
+            loop_md = None
+            for targets, md_id in latch_metadata.get(function, []):
+                if header in targets:
+                    loop_md = md_id
+                    break
+
+            location = self._loop_location(loop_md, metadata) if loop_md else None
+            scev = counts.get((function, header), {})
+            loops.append({
+                'function': function,
+                'header': header,
+                'depth': depth,
+                'location': location,
+                **scev,
+            })
+
+        return loops
+
+    def _parse_analysis(self, output: str) -> Tuple[Dict, Dict]:
+        """Parse print<loops> and print<scalar-evolution> output."""
+        depths: Dict[Tuple[str, str], int] = {}
+        counts: Dict[Tuple[str, str], Dict[str, Any]] = {}
+        loop_function = ''
+        scev_function = ''
+
+        for line in output.splitlines():
+            match = self.LOOP_INFO_FUNCTION.match(line)
+            if match:
+                loop_function = match.group(1)
+                continue
+
+            match = self.LOOP_AT_DEPTH.match(line)
+            if match:
+                for block in match.group(2).split(','):
+                    if '<header>' in block:
+                        header = block.strip().split('<')[0].lstrip('%')
+                        depths[(loop_function, header)] = int(match.group(1))
+                        break
+                continue
+
+            match = self.SCEV_FUNCTION.match(line)
+            if match:
+                scev_function = match.group(1)
+                continue
+
+            match = self.SCEV_LOOP.match(line)
+            if match and scev_function:
+                entry = counts.setdefault((scev_function, match.group(1)), {})
+                self._parse_scev_line(match.group(2), entry)
+
+        return depths, counts
+
+    def _parse_scev_line(self, text: str, entry: Dict[str, Any]) -> None:
+        """Record one ScalarEvolution loop fact."""
+        # Newer LLVM releases prefix counts with their type, e.g. "i32 9"
+        def strip_type(value: str) -> str:
+            return re.sub(r'^i\d+\s+', '', value.strip().rstrip('.'))
+
+        if text.startswith('Unpredictable backedge-taken count'):
+            entry['backedge_taken_count'] = 'unpredictable'
+        elif text.startswith('backedge-taken count is '):
+            entry['backedge_taken_count'] = strip_type(text[len('backedge-taken count is '):])
+        elif 'constant max backedge-taken count is ' in text:
+            entry['max_backedge_taken_count'] = strip_type(text.split(' is ', 1)[1])
+        elif text.startswith('Trip multiple is '):
+            entry['trip_multiple'] = strip_type(text[len('Trip multiple is '):])
+
+        backedges = entry.get('backedge_taken_count', '')
+        if backedges.lstrip('-').isdigit():
+            entry['trip_count'] = int(backedges) + 1
+
+    def _parse_ir(self, ir_text: str) -> Tuple[Dict[str, List], Dict[str, str]]:
+        """Find latch branches carrying !llvm.loop and collect metadata nodes."""
+        latches: Dict[str, List[Tuple[List[str], str]]] = {}
+        metadata: Dict[str, str] = {}
+        function = ''
+
+        for line in ir_text.splitlines():
+            match = self.IR_DEFINE.match(line)
+            if match:
+                function = match.group(1).strip('"')
+                continue
+
+            match = self.IR_LOOP_BRANCH.match(line)
+            if match and function:
+                targets = [label.strip('"') for label in self.IR_LABEL.findall(line)]
+                latches.setdefault(function, []).append((targets, match.group(1)))
+                continue
+
+            match = self.IR_METADATA.match(line)
+            if match:
+                metadata[match.group(1)] = match.group(2)
+
+        return latches, metadata
+
+    def _loop_location(self, loop_md: str, metadata: Dict[str, str]) -> Optional[Dict[str, Any]]:
+        """Resolve the start location of a loop from its !llvm.loop node."""
+        node = metadata.get(loop_md, '')
+        for ref in self.METADATA_REF.findall(node):
+            if ref == loop_md:
+                continue
+            location = metadata.get(ref, '')
+            if not location.startswith('!DILocation('):
+                continue
+
+            line = re.search(r'line: (\d+)', location)
+            column = re.search(r'column: (\d+)', location)
+            scope = re.search(r'scope: (![0-9]+)', location)
+            return {
+                'file': self._scope_file(scope.group(1) if scope else '', metadata),
+                'line': int(line.group(1)) if line else 0,
+                'column': int(column.group(1)) if column else 0,
+            }
+        return None
+
+    def _scope_file(self, scope: str, metadata: Dict[str, str]) -> str:
+        """Follow a debug scope to its DIFile and return the full path."""
+        for _ in range(64):
+            node = metadata.get(scope, '')
+            file_ref = re.search(r'file: (![0-9]+)', node)
+            if file_ref:
+                file_node = metadata.get(file_ref.group(1), '')
+                filename = re.search(r'filename: "([^"]*)"', file_node)
+                directory = re.search(r'directory: "([^"]*)"', file_node)
+                if filename:
+                    if directory and not Path(filename.group(1)).is_absolute():
+                        return str(Path(directory.group(1)) / filename.group(1))
+                    return filename.group(1)
+            parent = re.search(r'scope: (![0-9]+)', node)
+            if not parent:
+                break
+            scope = parent.group(1)
+        return ''
+
+    def annotate(self, file_path: Path, file_analysis: Dict[str, Any],
+                 llvm_loops: List[Dict[str, Any]], vectorizer: OptRemarksIngest) -> Dict[str, Any]:
+        """Attach LLVM loop facts to AST loop records and cross-check nesting."""
+        index = LoopIndex({str(file_path): file_analysis})
+
+        # Vectorizer remarks point at the loop start location
+        remarks_by_line: Dict[Tuple[str, int], List[Dict[str, Any]]] = {}
+        for remark in vectorizer.remarks:
+            remarks_by_line.setdefault((Path(remark['file']).name, remark['line']), []).append(remark)
+
+        matched_ids = set()
+        llvm_only = 0
+        depth_mismatches = 0
+
+        for llvm_loop in llvm_loops:
+            location = llvm_loop['location']
+            if not location:
+                llvm_only += 1
+                continue
+
+            candidates = [
+                loop for loop in index.loops_at(location['file'] or str(file_path), location['line'])
+                if loop.get('location', {}).get('start_line') == location['line']
+            ]
+            if not candidates:
+                llvm_only += 1
+                continue
+
+            for loop in candidates:
+                facts = {
+                    key: llvm_loop[key]
+                    for key in ('depth', 'backedge_taken_count', 'max_backedge_taken_count',
+                                'trip_multiple', 'trip_count')
+                    if key in llvm_loop
+                }
+                facts['found'] = True
+                facts['nesting_agrees'] = facts['depth'] == loop.get('nesting_level')
+                if not facts['nesting_agrees']:
+                    depth_mismatches += 1
+
+                remarks = remarks_by_line.get((Path(location['file'] or str(file_path)).name, location['line']), [])
+                categories = {vectorizer.classify(remark) for remark in remarks}
+                if 'vectorized' in categories:
+                    facts['vectorizer_verdict'] = 'vectorized'
+                elif 'missed_vectorization' in categories:
+                    facts['vectorizer_verdict'] = 'not_vectorized'
+                else:
+                    facts['vectorizer_verdict'] = 'no_vectorization_remarks'
+                facts['vectorizer_reasons'] = sorted({
+                    remark['message'] for remark in remarks
+                    if remark['status'] == 'missed' and remark['message']
+                })
+
+                if 'trip_count' in facts and loop['loop_bounds'].get('estimated_iterations') == 'unknown':
+                    loop['loop_bounds']['estimated_iterations'] = facts['trip_count']
+
+                loop.setdefault('extensions', {})['llvm'] = facts
+                matched_ids.add(id(loop))
+
+        ast_only = 0
+        for _, _, loop in index.iter_loops():
+            if id(loop) not in matched_ids:
+                loop.setdefault('extensions', {})['llvm'] = {'found': False}
+                ast_only += 1
+
+        return {
+            'llvm_loops': len(llvm_loops),
+            'matched_records': len(matched_ids),
+            'ast_only_records': ast_only,
+            'llvm_only_loops': llvm_only,
+            'nesting_mismatches': depth_mismatches,
+        }
@@ -1,10 +1,20 @@
 """
 Loop analysis module for extracting loop information from AST.
+
+Loop ids are content based: a hash of the file path relative to the scan
+root with the enclosing function's USR (taken from the traversal, since
+statement cursors have no semantic parent), the loop's path in that
+function's loop nest (outermost index, then nested indices) and the loop
+header's tokens. They survive edits elsewhere in the
+file and are the same for a loop's top-level and nested records.
 """
 
+import hashlib
 import logging
+import os
+import time
 from pathlib import Path
-from typing import Dict, List, Optional, Any
+from typing import Dict, List, Optional, Any, Tuple
 from datetime import datetime
 
 try:
@@ -14,16 +24,24 @@ except ImportError as e:
 
 from .config import Config
 from .ast_parser import ASTParser
+from .analysis_passes import AnalysisPass, PASS_REGISTRY, resolve_passes
+from . import perf_findings  # noqa: F401 - registers the findings pass
 
 
 class LoopAnalyzer:
     """Analyzes AST to extract comprehensive loop information."""
     
-    def __init__(self, config: Config):
-        """Initialize loop analyzer with configuration."""
+    # Declarations whose loops are identified relative to them
+    FUNCTION_KINDS = {
+        CursorKind.FUNCTION_DECL, CursorKind.CXX_METHOD, CursorKind.CONSTRUCTOR,
+        CursorKind.DESTRUCTOR, CursorKind.FUNCTION_TEMPLATE,
+    }
+    
+    def __init__(self, config: Config, ast_parser: Optional[ASTParser] = None):
+        """Initialize loop analyzer; pass the run's ASTParser to share its clang index."""
         self.config = config
         self.logger = logging.getLogger(__name__)
-        self.ast_parser = ASTParser(config)
+        self.ast_parser = ast_parser or ASTParser(config)
         
         # Loop types mapping
         self.LOOP_TYPES = {
@@ -33,22 +51,37 @@ class LoopAnalyzer:
             CursorKind.CXX_FOR_RANGE_STMT: 'range_for_loop',
         }
         
-        # Operation types for classification
-        self.ARITHMETIC_OPS = {
-            '+', '-', '*', '/', '%', '++', '--', '+=', '-=', '*=', '/=', '%='
-        }
-        
-        self.LOGICAL_OPS = {
-            '&&', '||', '!', '==', '!=', '<', '>', '<=', '>='
-        }
-        
-        self.BITWISE_OPS = {
-            '&', '|', '^', '~', '<<', '>>', '&=', '|=', '^=', '<<=', '>>='
-        }
+        # Analysis passes; the loop body walk only stops at cursor kinds a pass subscribed to
+        self.pass_names = resolve_passes(config.passes)
+        self.passes: List[AnalysisPass] = [PASS_REGISTRY[name](config, self.ast_parser) for name in self.pass_names]
+        self.subscribers: Dict[CursorKind, List[AnalysisPass]] = {}
+        for analysis_pass in self.passes:
+            for kind in analysis_pass.cursor_kinds:
+                self.subscribers.setdefault(kind, []).append(analysis_pass)
+        
+        # Per-file cost of the last analyze_file call (see run_metrics.py)
+        self.pass_seconds: Dict[str, float] = {}
+        self.cursors_visited = 0
+        self.last_file_stats: Dict[str, Any] = {}
+        
+        # Per-file loop identity state: id per loop cursor, (function key, nest path) per id,
+        # and the number of outermost loops seen per function
+        self._loop_ids: Dict[Cursor, str] = {}
+        self._loop_paths: Dict[str, Tuple[str, str]] = {}
+        self._outermost_loops: Dict[str, int] = {}
+        # Key of the function the traversal is in: the file relative to the scan root plus its USR
+        self._function_key = ''
     
     def analyze_file(self, translation_unit: TranslationUnit, file_path: Path) -> Dict[str, Any]:
         """Analyze a translation unit for loop information."""
         self.logger.debug(f"Analyzing loops in {file_path}")
+        started = time.perf_counter()
+        self.pass_seconds = {name: 0.0 for name in self.pass_names}
+        self.cursors_visited = 0
+        self._loop_ids = {}
+        self._loop_paths = {}
+        self._outermost_loops = {}
+        self._function_key = self._file_key(file_path)
         
         file_analysis = {
             'file_info': self._get_file_info(file_path),
@@ -61,14 +94,31 @@ class LoopAnalyzer:
             # Get the root cursor
             root_cursor = translation_unit.cursor
             
+            self._run_hook('begin_file', translation_unit, file_path, file_analysis)
+            
             # Analyze the file structure
             self._analyze_cursor(root_cursor, file_analysis, file_path)
             
+            self._run_hook('end_file', translation_unit, file_path, file_analysis)
+            
         except Exception as e:
             self.logger.error(f"Error analyzing {file_path}: {e}")
         
+        elapsed = time.perf_counter() - started
+        self.last_file_stats = {
+            'traversal': max(0.0, elapsed - sum(self.pass_seconds.values())),
+            'passes': dict(self.pass_seconds),
+            'cursors': self.cursors_visited,
+        }
         return file_analysis
     
+    def _run_hook(self, hook: str, *args) -> None:
+        """Call a file, function or loop hook on every pass, timing each pass."""
+        for analysis_pass in self.passes:
+            started = time.perf_counter()
+            getattr(analysis_pass, hook)(*args)
+            self.pass_seconds[analysis_pass.name] += time.perf_counter() - started
+    
     def _get_file_info(self, file_path: Path) -> Dict[str, Any]:
         """Get basic file information."""
         try:
@@ -105,6 +155,7 @@ class LoopAnalyzer:
     def _analyze_cursor(self, cursor: Cursor, file_analysis: Dict[str, Any], 
                        target_file: Path, parent_context: Optional[Dict] = None) -> None:
         """Recursively analyze cursor and its children."""
+        self.cursors_visited += 1
         try:
             # Only analyze cursors in the target file
             if not self.ast_parser.is_in_file(cursor, target_file):
@@ -116,26 +167,41 @@ class LoopAnalyzer:
             self.logger.debug(f"Analyzing cursor: {cursor_kind} - {cursor.spelling}")
             
             # Handle different cursor types
+            function_info = None
             if cursor_kind == CursorKind.CLASS_DECL:
                 self._analyze_class(cursor, file_analysis, target_file)
             elif cursor_kind == CursorKind.FUNCTION_DECL:
-                self._analyze_function(cursor, file_analysis, target_file)
+                function_info = self._analyze_function(cursor, file_analysis, target_file)
             elif cursor_kind == CursorKind.CXX_METHOD:
                 # Method will be handled by class analysis
                 if parent_context and parent_context.get('type') == 'class':
-                    self._analyze_method(cursor, parent_context, target_file)
+                    function_info = self._analyze_method(cursor, parent_context, target_file)
             elif cursor_kind in self.LOOP_TYPES:
                 self._analyze_loop(cursor, file_analysis, target_file, parent_context)
             
+            # Loops are identified relative to the function that encloses them
+            enclosing_function = self._function_key
+            if cursor_kind in self.FUNCTION_KINDS:
+                self._function_key = f"{self._file_key(target_file)}\0{cursor.get_usr() or cursor.spelling}"
+            
             # Recursively analyze children
-            for child in cursor.get_children():
-                child_context = parent_context
-                if cursor_kind == CursorKind.CLASS_DECL:
-                    child_context = {'type': 'class', 'name': cursor.spelling, 'data': file_analysis['classes'].get(cursor.spelling, {})}
-                elif cursor_kind in {CursorKind.FUNCTION_DECL, CursorKind.CXX_METHOD}:
-                    child_context = {'type': 'function', 'name': cursor.spelling}
-                
-                self._analyze_cursor(child, file_analysis, target_file, child_context)
+            try:
+                for child in cursor.get_children():
+                    child_context = parent_context
+                    if cursor_kind == CursorKind.CLASS_DECL:
+                        child_context = {'type': 'class', 'name': cursor.spelling, 'data': file_analysis['classes'].get(cursor.spelling, {})}
+                    elif cursor_kind == CursorKind.CXX_METHOD and parent_context and parent_context.get('type') == 'class':
+                        # Keep the class context so method loops are attached to the method
+                        child_context = parent_context
+                    elif cursor_kind in {CursorKind.FUNCTION_DECL, CursorKind.CXX_METHOD}:
+                        child_context = {'type': 'function', 'name': cursor.spelling}
+                    
+                    self._analyze_cursor(child, file_analysis, target_file, child_context)
+            finally:
+                self._function_key = enclosing_function
+            
+            if function_info is not None:
+                self._run_hook('end_function', cursor, function_info)
                 
         except Exception as e:
             self.logger.debug(f"Error analyzing cursor {cursor.kind}: {e}")
@@ -156,7 +222,7 @@ class LoopAnalyzer:
         
         self.logger.debug(f"Found class: {class_name}")
     
-    def _analyze_function(self, cursor: Cursor, file_analysis: Dict[str, Any], target_file: Path) -> None:
+    def _analyze_function(self, cursor: Cursor, file_analysis: Dict[str, Any], target_file: Path) -> Dict[str, Any]:
         """Analyze a function declaration."""
         function_name = cursor.spelling or f"anonymous_function_{cursor.location.line}"
         
@@ -172,7 +238,7 @@ class LoopAnalyzer:
                 param_name = child.spelling or ""
                 parameters.append(f"{param_type} {param_name}".strip())
         
-        file_analysis['functions'][function_name] = {
+        function_info = {
             'location': {
                 'start_line': location['start_line'],
                 'end_line': location['end_line'],
@@ -181,10 +247,14 @@ class LoopAnalyzer:
             'return_type': return_type,
             'loops': [],
         }
+        file_analysis['functions'][function_name] = function_info
+        
+        self._run_hook('begin_function', cursor, function_info)
         
         self.logger.debug(f"Found function: {function_name}")
+        return function_info
     
-    def _analyze_method(self, cursor: Cursor, class_context: Dict, target_file: Path) -> None:
+    def _analyze_method(self, cursor: Cursor, class_context: Dict, target_file: Path) -> Dict[str, Any]:
         """Analyze a method within a class."""
         method_name = cursor.spelling or f"anonymous_method_{cursor.location.line}"
         
@@ -203,7 +273,7 @@ class LoopAnalyzer:
         if 'methods' not in class_context['data']:
             class_context['data']['methods'] = {}
         
-        class_context['data']['methods'][method_name] = {
+        method_info = {
             'location': {
                 'start_line': location['start_line'],
                 'end_line': location['end_line'],
@@ -212,13 +282,24 @@ class LoopAnalyzer:
             'return_type': return_type,
             'loops': [],
         }
+        class_context['data']['methods'][method_name] = method_info
+        
+        self._run_hook('begin_function', cursor, method_info)
         
         self.logger.debug(f"Found method: {method_name} in class {class_context['name']}")
+        return method_info
     
     def _analyze_loop(self, cursor: Cursor, file_analysis: Dict[str, Any], 
                      target_file: Path, parent_context: Optional[Dict] = None) -> None:
         """Analyze a loop statement."""
-        loop_id = f"loop_{cursor.location.line}_{cursor.location.column}"
+        # Nested loops were already identified while walking their parent's body
+        if cursor in self._loop_ids:
+            loop_id = self._loop_ids[cursor]
+        else:
+            function_key = self._function_key
+            index = self._outermost_loops.get(function_key, 0)
+            self._outermost_loops[function_key] = index + 1
+            loop_id = self._identify_loop(cursor, function_key, str(index))
         loop_type = self.LOOP_TYPES.get(cursor.kind, 'unknown_loop')
         
         location = self.ast_parser.get_cursor_location(cursor)
@@ -250,7 +331,7 @@ class LoopAnalyzer:
         }
         
         # Analyze loop body
-        self._analyze_loop_body(cursor, loop_info, target_file)
+        self._run_loop_passes(cursor, loop_info, target_file)
         
         # Add to appropriate container
         if parent_context:
@@ -279,6 +360,25 @@ class LoopAnalyzer:
         
         self.logger.debug(f"Found {loop_type}: {loop_id}")
     
+    def _file_key(self, file_path: Path) -> str:
+        """File path relative to the scan root, so ids do not depend on where the tree is checked out."""
+        try:
+            return Path(os.path.relpath(file_path, self.config.source_path)).as_posix()
+        except ValueError:
+            return str(file_path)
+    
+    def _identify_loop(self, cursor: Cursor, function_key: str, path: str) -> str:
+        """Hash the function key, nest path and header tokens into the loop id and remember it."""
+        children = list(cursor.get_children())
+        # The header is every child but the body, which comes first in a do-while
+        header = children[1:] if cursor.kind == CursorKind.DO_STMT else children[:-1]
+        tokens = ' '.join(token.spelling for child in header for token in child.get_tokens())
+        text = '\0'.join((function_key, path, self.LOOP_TYPES.get(cursor.kind, ''), tokens))
+        loop_id = f"loop_{hashlib.sha1(text.encode('utf-8')).hexdigest()[:16]}"
+        self._loop_ids[cursor] = loop_id
+        self._loop_paths[loop_id] = (function_key, path)
+        return loop_id
+    
     def _extract_loop_bounds(self, cursor: Cursor) -> Dict[str, str]:
         """Extract loop bounds information."""
         bounds = {
@@ -336,6 +436,14 @@ class LoopAnalyzer:
         
         return level
     
+    def _run_loop_passes(self, cursor: Cursor, loop_info: Dict[str, Any], target_file: Path) -> None:
+        """Walk a loop body once, with the passes' loop hooks around the walk."""
+        self._run_hook('begin_loop', cursor, loop_info)
+        
+        self._analyze_loop_body(cursor, loop_info, target_file)
+        
+        self._run_hook('end_loop', cursor, loop_info)
+    
     def _analyze_loop_body(self, cursor: Cursor, loop_info: Dict[str, Any], target_file: Path) -> None:
         """Analyze the body of a loop for operations and memory access."""
         try:
@@ -355,18 +463,27 @@ class LoopAnalyzer:
     
     def _analyze_loop_body_recursive(self, cursor: Cursor, loop_info: Dict[str, Any], target_file: Path) -> None:
         """Recursively analyze loop body for operations."""
+        self.cursors_visited += 1
         try:
             # Skip if not in target file
             if not self.ast_parser.is_in_file(cursor, target_file):
                 return
             
             cursor_kind = cursor.kind
-            location = self.ast_parser.get_cursor_location(cursor)
+            if cursor_kind not in self.LOOP_TYPES and cursor_kind not in self.subscribers:
+                for child in cursor.get_children():
+                    self._analyze_loop_body_recursive(child, loop_info, target_file)
+                return
+            
+            # Passes mostly read only the line; fields are fetched when first used
+            location = self.ast_parser.lazy_location(cursor)
             
             # Check for nested loops
             if cursor_kind in self.LOOP_TYPES:
+                parent_key, parent_path = self._loop_paths[loop_info['loop_id']]
                 nested_loop = {
-                    'loop_id': f"loop_{location['start_line']}_{location['start_column']}",
+                    'loop_id': self._identify_loop(cursor, parent_key,
+                                                   f"{parent_path}.{len(loop_info['nested_loops'])}"),
                     'type': self.LOOP_TYPES[cursor_kind],
                     'location': {
                         'start_line': location['start_line'],
@@ -383,19 +500,15 @@ class LoopAnalyzer:
                 }
                 
                 # Recursively analyze nested loop
-                self._analyze_loop_body(cursor, nested_loop, target_file)
+                self._run_loop_passes(cursor, nested_loop, target_file)
                 loop_info['nested_loops'].append(nested_loop)
                 return
             
-            # Analyze operations
-            if cursor_kind == CursorKind.BINARY_OPERATOR:
-                self._analyze_binary_operation(cursor, loop_info, location)
-            elif cursor_kind == CursorKind.UNARY_OPERATOR:
-                self._analyze_unary_operation(cursor, loop_info, location)
-            elif cursor_kind == CursorKind.CALL_EXPR:
-                self._analyze_function_call(cursor, loop_info, location)
-            elif cursor_kind in {CursorKind.DECL_REF_EXPR, CursorKind.ARRAY_SUBSCRIPT_EXPR}:
-                self._analyze_memory_access(cursor, loop_info, location)
+            # Dispatch to the passes subscribed to this cursor kind
+            for analysis_pass in self.subscribers.get(cursor_kind, ()):
+                started = time.perf_counter()
+                analysis_pass.visit(cursor, loop_info, location)
+                self.pass_seconds[analysis_pass.name] += time.perf_counter() - started
             
             # Recursively analyze children
             for child in cursor.get_children():
@@ -404,217 +517,26 @@ class LoopAnalyzer:
         except Exception as e:
             self.logger.debug(f"Error in recursive loop body analysis: {e}")
     
-    def _analyze_binary_operation(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict) -> None:
-        """Analyze binary operations."""
-        try:
-            # Get the operator (this is tricky with libclang, approximate from source)
-            source_text = self.ast_parser.get_source_text(cursor)
-            
-            # Simple heuristic to detect operation type
-            if any(op in source_text for op in self.ARITHMETIC_OPS):
-                op_type = 'arithmetic'
-            elif any(op in source_text for op in self.LOGICAL_OPS):
-                op_type = 'logical'
-            elif any(op in source_text for op in self.BITWISE_OPS):
-                op_type = 'bitwise'
-            else:
-                op_type = 'unknown'
-            
-            operation = {
-                'type': op_type,
-                'expression': source_text.strip(),
-                'line': location['line'],
-            }
-            
-            if op_type in loop_info['operations']:
-                loop_info['operations'][op_type].append(operation)
-            else:
-                loop_info['operations'].setdefault('other', []).append(operation)
-                
-        except Exception as e:
-            self.logger.debug(f"Error analyzing binary operation: {e}")
-    
-    def _analyze_unary_operation(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict) -> None:
-        """Analyze unary operations."""
-        try:
-            source_text = self.ast_parser.get_source_text(cursor)
-            
-            operation = {
-                'type': 'unary',
-                'expression': source_text.strip(),
-                'line': location['line'],
-            }
-            
-            loop_info['operations'].setdefault('unary', []).append(operation)
-            
-        except Exception as e:
-            self.logger.debug(f"Error analyzing unary operation: {e}")
-    
-    def _analyze_function_call(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict) -> None:
-        """Analyze function calls."""
-        try:
-            function_name = self._extract_function_name(cursor)
-            
-            # Extract arguments
-            arguments = []
-            for child in cursor.get_children():
-                if child.kind != CursorKind.UNEXPOSED_EXPR:
-                    arg_text = self.ast_parser.get_source_text(child).strip()
-                    if arg_text:
-                        arguments.append(arg_text)
-            
-            function_call = {
-                'function': function_name,
-                'arguments': arguments,
-                'line': location['line'],
-            }
-            
-            loop_info['operations']['function_calls'].append(function_call)
-            
-            # Also add to detailed function calls
-            detailed_call = {
-                'function': function_name,
-                'location': {
-                    'line': location['line'],
-                    'column': location['column'],
-                },
-                'resolved': bool(cursor.referenced),
-                'definition_file': str(cursor.referenced.location.file) if cursor.referenced and cursor.referenced.location.file else '',
-            }
-            
-            loop_info['function_calls'].append(detailed_call)
-            
-        except Exception as e:
-            self.logger.debug(f"Error analyzing function call: {e}")
-    
-    def _extract_function_name(self, cursor: Cursor) -> str:
-        """Extract function name from call expression, handling C++ method calls."""
-        try:
-            # Try to get the full qualified name from source text first
-            # This is most reliable for qualified names like Class::method
-            full_source = self.ast_parser.get_source_text(cursor).strip()
-            if full_source and '(' in full_source:
-                # Extract everything before the first '('
-                func_part = full_source.split('(')[0].strip()
-                if func_part:
-                    # Return the full qualified name if it contains ::
-                    if '::' in func_part:
-                        return func_part
-                    # For simple function calls, continue to child analysis
-                    # to get more accurate names from AST
-            
-            # For C++ method calls, examine the children
-            children = list(cursor.get_children())
-            if not children:
-                # Fallback to spelling if no children
-                return cursor.spelling or "unknown_function"
-            
-            first_child = children[0]
-            
-            # Handle different types of function calls
-            if first_child.kind == CursorKind.MEMBER_REF_EXPR:
-                # Method call: object.method() or object->method()
-                method_name = first_child.spelling
-                if method_name:
-                    return method_name
-                    
-            elif first_child.kind == CursorKind.DECL_REF_EXPR:
-                # Simple function call: function()
-                func_name = first_child.spelling
-                if func_name:
-                    return func_name
-                    
-            elif first_child.kind in [CursorKind.UNEXPOSED_EXPR, CursorKind.CALL_EXPR]:
-                # Nested or complex expression, try to get source text
-                source_text = self.ast_parser.get_source_text(first_child).strip()
-                if source_text:
-                    # Extract function name from source text
-                    if '(' in source_text:
-                        source_text = source_text.split('(')[0].strip()
-                    return source_text
-                    
-            elif first_child.kind == CursorKind.OVERLOADED_DECL_REF:
-                # Overloaded function reference
-                return first_child.spelling or "overloaded_function"
-            
-            # Final fallback: use the source text we extracted earlier
-            if full_source and '(' in full_source:
-                func_part = full_source.split('(')[0].strip()
-                if func_part:
-                    # For method calls with . or ->, extract just the method name
-                    if '.' in func_part and '::' not in func_part:
-                        return func_part.split('.')[-1]
-                    elif '->' in func_part and '::' not in func_part:
-                        return func_part.split('->')[-1]
-                    else:
-                        return func_part
-            
-            # Final fallback
-            return cursor.spelling or "unknown_function"
-            
-        except Exception as e:
-            self.logger.debug(f"Error extracting function name: {e}")
-            return "unknown_function"
-    
-    def _analyze_memory_access(self, cursor: Cursor, loop_info: Dict[str, Any], location: Dict) -> None:
-        """Analyze memory access patterns."""
-        try:
-            source_text = self.ast_parser.get_source_text(cursor).strip()
-            if not source_text:
-                return
-            
-            # Determine access type
-            access_type = 'unknown'
-            if '[' in source_text and ']' in source_text:
-                # Array access
-                if source_text.count('[') == 1:
-                    access_type = '1d_array'
-                elif source_text.count('[') == 2:
-                    access_type = '2d_array'
-                else:
-                    access_type = 'multi_array'
-            elif '*' in source_text:
-                access_type = 'pointer'
-            elif '.' in source_text or '->' in source_text:
-                access_type = 'struct_member'
-            else:
-                access_type = 'variable'
-            
-            # Extract variable name (simple heuristic)
-            variable_name = source_text.split('[')[0].split('.')[0].split('->')[0].strip()
-            
-            memory_access = {
-                'variable': variable_name,
-                'access_pattern': source_text,
-                'access_type': access_type,
-                'stride_pattern': 'unknown',  # Would need more sophisticated analysis
-                'line': location['line'],
-            }
-            
-            # For now, assume all accesses are reads (write detection would need more context)
-            loop_info['memory_access']['reads'].append(memory_access)
-            
-        except Exception as e:
-            self.logger.debug(f"Error analyzing memory access: {e}")
-    
-    def count_loops(self, file_analysis: Dict[str, Any]) -> int:
+    @staticmethod
+    def count_loops(file_analysis: Dict[str, Any]) -> int:
         """Count total loops in a file analysis."""
         total = len(file_analysis.get('global_loops', []))
         
         # Count loops in functions
         for func_data in file_analysis.get('functions', {}).values():
-            total += self._count_loops_recursive(func_data.get('loops', []))
+            total += LoopAnalyzer._count_loops_recursive(func_data.get('loops', []))
         
         # Count loops in class methods
         for class_data in file_analysis.get('classes', {}).values():
             for method_data in class_data.get('methods', {}).values():
-                total += self._count_loops_recursive(method_data.get('loops', []))
+                total += LoopAnalyzer._count_loops_recursive(method_data.get('loops', []))
         
         return total
     
-    def _count_loops_recursive(self, loops: List[Dict]) -> int:
+    @staticmethod
+    def _count_loops_recursive(loops: List[Dict]) -> int:
         """Recursively count loops including nested ones."""
         total = len(loops)
         for loop in loops:
-            total += self._count_loops_recursive(loop.get('nested_loops', []))
+            total += LoopAnalyzer._count_loops_recursive(loop.get('nested_loops', []))
         return total
\ No newline at end of file
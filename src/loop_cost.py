@@ -0,0 +1,72 @@
+"""
+Loop cost model shared by the exporters.
+
+A loop's cost is the number of times its body runs times the operations and
+memory accesses recorded for its own body (nested loops are costed
+separately). Body executions come from measured iterations when the analysis
+has been annotated, otherwise from trip-count estimates multiplied down the nest.
+"""
+
+import re
+from typing import Dict, Any, Optional
+
+
+class LoopCostModel:
+    """Static and measured cost estimates for loop records."""
+
+    def __init__(self, default_iterations: int = 100):
+        """Initialize the model; default_iterations is assumed when no trip count is known."""
+        self.default_iterations = default_iterations
+
+    def executions(self, loop: Dict[str, Any], parent_executions: float, measured: bool = True) -> float:
+        """How often the loop body runs, given how often the enclosing body runs."""
+        if measured:
+            iterations = self.measured_iterations(loop)
+            if iterations is not None:
+                return iterations
+        return parent_executions * self.trip_count(loop)
+
+    def measured_iterations(self, loop: Dict[str, Any]) -> Optional[float]:
+        """Total iterations from instrumentation or coverage annotations, if any."""
+        extensions = loop.get('extensions', {})
+        for source in ('instrumentation', 'coverage'):
+            if 'iterations' in extensions.get(source, {}):
+                return float(extensions[source]['iterations'])
+        return None
+
+    def trip_count(self, loop: Dict[str, Any]) -> float:
+        """Estimated iterations per entry, falling back to the configured default."""
+        bounds = loop.get('loop_bounds', {})
+        estimate = bounds.get('estimated_iterations', 'unknown')
+        if isinstance(estimate, (int, float)) and not isinstance(estimate, bool):
+            return float(estimate)
+        try:
+            return float(estimate)
+        except (TypeError, ValueError):
+            pass
+
+        literal = self.literal_trip_count(bounds)
+        return float(literal if literal is not None else self.default_iterations)
+
+    def literal_trip_count(self, bounds: Dict[str, Any]) -> Optional[int]:
+        """Trip count of `for (int i = 0; i < 10; ++i)`-style headers with literal bounds."""
+        init = re.search(r'(\w+)\s*=\s*(-?\d+)\s*;?$', bounds.get('initialization', ''))
+        condition = re.fullmatch(r'(\w+)\s*(<=|<|>=|>)\s*(-?\d+)', bounds.get('condition', ''))
+        increment = bounds.get('increment', '').replace(' ', '')
+        if not init or not condition or init.group(1) != condition.group(1):
+            return None
+
+        start, relation, end = int(init.group(2)), condition.group(2), int(condition.group(3))
+        variable = init.group(1)
+        if increment in {f'{variable}++', f'++{variable}'} and relation in {'<', '<='}:
+            return max(0, end - start + (relation == '<='))
+        if increment in {f'{variable}--', f'--{variable}'} and relation in {'>', '>='}:
+            return max(0, start - end + (relation == '>='))
+        return None
+
+    def body_cost(self, loop: Dict[str, Any]) -> int:
+        """Per-iteration cost: operations and memory accesses recorded for the loop's own body."""
+        cost = sum(len(entries) for entries in loop.get('operations', {}).values() if isinstance(entries, list))
+        memory = loop.get('memory_access', {})
+        cost += len(memory.get('reads', [])) + len(memory.get('writes', []))
+        return max(1, cost)
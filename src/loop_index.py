@@ -0,0 +1,186 @@
+"""
+Loop index module for joining external measurements onto analysis results.
+"""
+
+import logging
+from pathlib import Path
+from typing import Dict, List, Any, Iterator, Tuple, Optional
+
+
+class LoopIndex:
+    """Maps source file lines onto the loop records that enclose them."""
+
+    def __init__(self, analysis_results: Dict[str, Any]):
+        """Build the index from the `source_files` section of an analysis."""
+        self.analysis_results = analysis_results
+        self.logger = logging.getLogger(__name__)
+
+        # file key -> list of (function name, loop record)
+        self._loops_by_file: Dict[str, List[Tuple[str, Dict[str, Any]]]] = {}
+        # resolved path -> file key, and basename -> file keys for fallback matching
+        self._resolved_paths: Dict[str, str] = {}
+        self._basenames: Dict[str, List[str]] = {}
+        # memoized lookups of external file names
+        self._file_cache: Dict[str, Optional[str]] = {}
+        # function name (full and unqualified) -> (file key, function name), built on demand
+        self._functions_by_name: Optional[Dict[str, List[Tuple[str, str]]]] = None
+
+        for file_path in analysis_results:
+            self._loops_by_file[file_path] = list(self._iter_file_loops(analysis_results[file_path]))
+            try:
+                self._resolved_paths[str(Path(file_path).resolve())] = file_path
+            except OSError:
+                pass
+            self._basenames.setdefault(Path(file_path).name, []).append(file_path)
+
+    def refresh_file(self, file_path: str) -> None:
+        """Re-index one file after its entry in analysis_results was replaced or removed."""
+        if file_path in self.analysis_results:
+            self._loops_by_file[file_path] = list(self._iter_file_loops(self.analysis_results[file_path]))
+            if file_path not in self._basenames.get(Path(file_path).name, []):
+                self._basenames.setdefault(Path(file_path).name, []).append(file_path)
+        else:
+            self._loops_by_file.pop(file_path, None)
+            self._resolved_paths = {resolved: key for resolved, key in self._resolved_paths.items() if key != file_path}
+            if file_path in self._basenames.get(Path(file_path).name, []):
+                self._basenames[Path(file_path).name].remove(file_path)
+        self._file_cache.clear()
+        self._functions_by_name = None
+
+    def iter_loops(self) -> Iterator[Tuple[str, str, Dict[str, Any]]]:
+        """Yield (file path, function name, loop record) for every loop, including nested ones."""
+        for file_path, loops in self._loops_by_file.items():
+            for function_name, loop in loops:
+                yield file_path, function_name, loop
+
+    def iter_functions(self) -> Iterator[Tuple[str, str, List[Dict[str, Any]]]]:
+        """Yield (file path, function name, outermost loop records) for every function.
+
+        Nested loops that are also reported at function level are dropped, so
+        walking the returned records and their `nested_loops` visits each loop once.
+        """
+        for file_path, file_data in self.analysis_results.items():
+            for function_name, loops in self._iter_file_functions(file_data):
+                nested_ids = set()
+                for loop in loops:
+                    for _, nested in self._iter_nested(function_name, loop.get('nested_loops', [])):
+                        nested_ids.add(nested.get('loop_id'))
+                outermost = [loop for loop in loops if loop.get('loop_id') not in nested_ids]
+                yield file_path, function_name, outermost
+
+    def _iter_file_functions(self, file_data: Dict[str, Any]) -> Iterator[Tuple[str, List[Dict]]]:
+        """Yield (function name, function-level loop records); methods are Class::method."""
+        for func_name, func_data in file_data.get('functions', {}).items():
+            yield func_name, func_data.get('loops', [])
+
+        for class_name, class_data in file_data.get('classes', {}).items():
+            for method_name, method_data in class_data.get('methods', {}).items():
+                yield f"{class_name}::{method_name}", method_data.get('loops', [])
+
+        yield '', file_data.get('global_loops', [])
+
+    def _iter_file_loops(self, file_data: Dict[str, Any]) -> Iterator[Tuple[str, Dict[str, Any]]]:
+        """Yield (function name, loop record) for every loop in a file."""
+        for function_name, loops in self._iter_file_functions(file_data):
+            yield from self._iter_nested(function_name, loops)
+
+    def _iter_nested(self, function_name: str, loops: List[Dict]) -> Iterator[Tuple[str, Dict[str, Any]]]:
+        """Recursively yield loops and their nested loops."""
+        for loop in loops:
+            yield function_name, loop
+            yield from self._iter_nested(function_name, loop.get('nested_loops', []))
+
+    def resolve_file(self, file_name: str) -> Optional[str]:
+        """Map a file name reported by an external tool onto an analyzed file key."""
+        if file_name in self._file_cache:
+            return self._file_cache[file_name]
+
+        match = None
+        if file_name in self._loops_by_file:
+            match = file_name
+        else:
+            try:
+                match = self._resolved_paths.get(str(Path(file_name).resolve()))
+            except OSError:
+                match = None
+
+            if match is None:
+                # Build trees and profilers often report different prefixes for the
+                # same file; pick the candidate sharing the longest path suffix.
+                candidates = self._basenames.get(Path(file_name).name, [])
+                best_score = 0
+                target_parts = Path(file_name).parts[::-1]
+                for candidate in candidates:
+                    score = 0
+                    for a, b in zip(Path(candidate).parts[::-1], target_parts):
+                        if a != b:
+                            break
+                        score += 1
+                    if score > best_score:
+                        best_score = score
+                        match = candidate
+
+        self._file_cache[file_name] = match
+        return match
+
+    def resolve_function(self, name: str, definition_file: str = '') -> Optional[Tuple[str, str]]:
+        """Map a called name (possibly qualified) onto an analyzed (file key, function name)."""
+        if self._functions_by_name is None:
+            self._functions_by_name = {}
+            for file_path, file_data in self.analysis_results.items():
+                for function_name, _ in self._iter_file_functions(file_data):
+                    if function_name:
+                        for key in {function_name, function_name.split('::')[-1]}:
+                            self._functions_by_name.setdefault(key, []).append((file_path, function_name))
+
+        candidates = self._functions_by_name.get(name) or self._functions_by_name.get(name.split('::')[-1], [])
+        if definition_file:
+            file_key = self.resolve_file(definition_file)
+            in_file = [candidate for candidate in candidates if candidate[0] == file_key]
+            candidates = in_file or candidates
+
+        unique = list(dict.fromkeys(candidates))
+        return unique[0] if len(unique) == 1 else None
+
+    def loops_at(self, file_name: str, line: int) -> List[Dict[str, Any]]:
+        """Return every loop record whose line range encloses the given line."""
+        file_key = self.resolve_file(file_name)
+        if file_key is None:
+            return []
+
+        result = []
+        for _, loop in self._loops_by_file[file_key]:
+            location = loop.get('location', {})
+            if location.get('start_line', 0) <= line <= location.get('end_line', -1):
+                result.append(loop)
+        return result
+
+    def loops_in_range(self, file_name: str, start_line: int, end_line: int) -> List[Tuple[str, Dict[str, Any]]]:
+        """Return (function name, loop record) for every loop overlapping the line range."""
+        file_key = self.resolve_file(file_name)
+        if file_key is None:
+            return []
+
+        result = []
+        for function_name, loop in self._loops_by_file[file_key]:
+            location = loop.get('location', {})
+            if location.get('start_line', 0) <= end_line and start_line <= location.get('end_line', -1):
+                result.append((function_name, loop))
+        return result
+
+    def innermost_at(self, file_name: str, line: int) -> List[Dict[str, Any]]:
+        """Return the innermost loop records enclosing the given line.
+
+        Nested loops may be reported both at function level and inside their
+        parent's `nested_loops`, so every record with the tightest range is returned.
+        """
+        loops = self.loops_at(file_name, line)
+        if not loops:
+            return []
+
+        def span(loop: Dict[str, Any]) -> int:
+            location = loop['location']
+            return location['end_line'] - location['start_line']
+
+        tightest = min(span(loop) for loop in loops)
+        return [loop for loop in loops if span(loop) == tightest]
@@ -0,0 +1,875 @@
+"""
+OpenMP pragma rewriter module.
+
+Runs a conservative dependence check over canonical `for` loops and, for
+loops that pass, proposes `#pragma omp parallel for` or `#pragma omp simd`
+with private, lastprivate, reduction and collapse clauses. Proposals are
+written as a unified diff for review, optionally also as rewritten copies.
+"""
+
+import difflib
+import logging
+import os
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+try:
+    from clang.cindex import CursorKind, Cursor, TypeKind, StorageClass, Diagnostic
+except ImportError as e:
+    raise ImportError("libclang not found. Please install with: pip install libclang") from e
+
+from .config import Config
+from .ast_parser import ASTParser
+from .loop_index import LoopIndex
+
+
+class ParallelLoopAnalyzer:
+    """Decides whether the iterations of a canonical for loop nest are independent.
+
+    The check only accepts what it can prove from the AST: array writes must be
+    indexed by the induction variables, shared scalars must be reductions or
+    written before they are read, pointers must not be derived from another
+    array the loop accesses, and calls are limited to pure math functions of
+    the system headers and const container queries. Everything else keeps the
+    loop sequential.
+    """
+
+    RELATIONAL_OPS = {'<', '<=', '>', '>='}
+
+    # Compound assignment -> OpenMP reduction identifier (x -= e combines with +)
+    REDUCTION_OPS = {'+=': '+', '-=': '+', '*=': '*', '&=': '&', '|=': '|', '^=': '^'}
+    BINARY_REDUCTION_OPS = {'+', '*', '&', '|', '^'}
+
+    PURE_FUNCTIONS = {
+        'abs', 'fabs', 'fabsf', 'sqrt', 'sqrtf', 'cbrt', 'exp', 'expf', 'exp2', 'log', 'logf',
+        'log2', 'log10', 'pow', 'powf', 'sin', 'sinf', 'cos', 'cosf', 'tan', 'tanf', 'atan',
+        'atan2', 'tanh', 'floor', 'ceil', 'round', 'trunc', 'fmin', 'fmax', 'fma', 'min', 'max',
+    }
+
+    CONST_METHODS = {'size', 'length', 'empty'}
+
+    INTEGER_KINDS = {
+        TypeKind.INT, TypeKind.UINT, TypeKind.LONG, TypeKind.ULONG, TypeKind.LONGLONG,
+        TypeKind.ULONGLONG, TypeKind.SHORT, TypeKind.USHORT, TypeKind.CHAR_S, TypeKind.UCHAR,
+    }
+
+    ARITHMETIC_KINDS = INTEGER_KINDS | {TypeKind.FLOAT, TypeKind.DOUBLE, TypeKind.LONGDOUBLE, TypeKind.BOOL}
+
+    WRAPPER_KINDS = {
+        CursorKind.UNEXPOSED_EXPR, CursorKind.PAREN_EXPR, CursorKind.CSTYLE_CAST_EXPR,
+        CursorKind.CXX_STATIC_CAST_EXPR, CursorKind.CXX_FUNCTIONAL_CAST_EXPR,
+    }
+
+    LOOP_KINDS = {
+        CursorKind.FOR_STMT, CursorKind.WHILE_STMT,
+        CursorKind.DO_STMT, CursorKind.CXX_FOR_RANGE_STMT,
+    }
+
+    FUNCTION_KINDS = {
+        CursorKind.FUNCTION_DECL, CursorKind.CXX_METHOD, CursorKind.CONSTRUCTOR,
+        CursorKind.DESTRUCTOR, CursorKind.FUNCTION_TEMPLATE,
+    }
+
+    def __init__(self, ast_parser: ASTParser):
+        """Initialize the analyzer with the parser that produced the cursors."""
+        self.ast_parser = ast_parser
+        self.logger = logging.getLogger(__name__)
+
+    def perfect_nest(self, loop: Cursor) -> List[Cursor]:
+        """Return the loop followed by every for loop that is its body's only statement."""
+        chain = [loop]
+        while True:
+            children = list(chain[-1].get_children())
+            if chain[-1].kind != CursorKind.FOR_STMT or len(children) != 4:
+                return chain
+            statements = self._statements(children[-1])
+            if len(statements) != 1 or statements[0].kind != CursorKind.FOR_STMT:
+                return chain
+            chain.append(statements[0])
+
+    def classify(self, chain: List[Cursor], function: Optional[Cursor], source_file: Path) -> Dict[str, Any]:
+        """Check whether the iterations of a loop chain (collapsed nest) are independent."""
+        verdict = {
+            'parallel': False,
+            'reasons': [],
+            'induction_variables': [],
+            'private': [],
+            'lastprivate': [],
+            'reduction': {},
+            'assumptions': [],
+            'trip_count': None,
+        }
+        reasons = verdict['reasons']
+
+        headers = []
+        for loop in chain:
+            header = self._canonical_header(loop)
+            if isinstance(header, str):
+                reasons.append(header)
+                return verdict
+            headers.append(header)
+
+        ivs = [header['iv'] for header in headers]
+        verdict['induction_variables'] = [iv.spelling for iv in ivs]
+        verdict['trip_count'] = headers[0]['trip_count']
+        outer = chain[0]
+        loop_start = outer.extent.start.offset
+        loop_end = outer.extent.end.offset
+
+        def is_local(decl: Cursor) -> bool:
+            if decl.location.file is None or not self.ast_parser.is_in_file(decl, source_file):
+                return False
+            if decl.kind == CursorKind.VAR_DECL and decl.storage_class == StorageClass.STATIC:
+                return False
+            return loop_start <= decl.extent.start.offset <= loop_end
+
+        # Inner bounds may not depend on outer induction variables (rectangular nest)
+        bound_accesses = []
+        for depth, header in enumerate(headers):
+            accesses = []
+            for expression in header['invariants']:
+                self._collect(expression, accesses, reasons, top_level=False)
+            for access in accesses:
+                if depth > 0 and any(access['root'] == iv for iv in ivs[:depth]):
+                    reasons.append(f"bounds of the loop over {ivs[depth].spelling} depend on {access['root'].spelling}")
+            bound_accesses += accesses
+
+        body = list(chain[-1].get_children())[-1]
+        first_jump = self._first_jump(body)
+        accesses: List[Dict[str, Any]] = []
+        for statement in self._statements(body):
+            self._collect(statement, accesses, reasons, top_level=True)
+
+        shared: Dict[str, List[Dict[str, Any]]] = {}
+        for access in accesses:
+            root = access['root']
+            if any(root == iv for iv in ivs):
+                if access['write']:
+                    reasons.append(f"induction variable {root.spelling} is modified in the body")
+                continue
+            if is_local(root):
+                continue
+            shared.setdefault(access['base'], []).append(access)
+
+        written_bases = {base for base, group in shared.items() if any(access['write'] for access in group)}
+        for access in bound_accesses:
+            if access['base'] in written_bases:
+                reasons.append(f"loop bound reads {access['base']}, which the body modifies")
+
+        # Pointers and arrays; a written one may overlap any other, except two distinct arrays
+        memory_bases = []
+        for base, group in shared.items():
+            root = group[0]['root']
+            if self._is_pointer(root) or self._is_array(root):
+                memory_bases.append(base)
+            writes = [access for access in group if access['write']]
+            if not writes:
+                continue
+
+            if any(access['indices'] for access in group):
+                self._check_array(base, group, ivs, reasons)
+                continue
+
+            self._check_scalar(base, group, function, outer, first_jump, verdict)
+
+        roots = {base: shared[base][0]['root'] for base in memory_bases}
+        for base in memory_bases:
+            if not self._is_pointer(roots[base]):
+                continue
+            # A pointer set from another accessed base (b = a + 1) visibly overlaps it
+            sources = self._pointer_sources(roots[base], function)
+            for other in memory_bases:
+                if other != base and roots[other] in sources and \
+                        (base in written_bases or other in written_bases):
+                    reasons.append(f"{base} is derived from {other}, which the loop also accesses")
+
+        # Other bases are assumed not to overlap; the reviewer must confirm
+        for written in [base for base in memory_bases if base in written_bases]:
+            for other in memory_bases:
+                if other == written or not (self._is_pointer(roots[written]) or self._is_pointer(roots[other])):
+                    continue
+                assumption = f"{written} does not overlap {other}"
+                if f"{other} does not overlap {written}" not in verdict['assumptions']:
+                    verdict['assumptions'].append(assumption)
+
+        # An induction variable declared outside the loop must keep its final value
+        for iv in ivs:
+            if not is_local(iv) and self._used_after(iv, function, outer):
+                verdict['lastprivate'].append(iv.spelling)
+
+        verdict['parallel'] = not reasons
+        return verdict
+
+    def _check_array(self, base: str, group: List[Dict[str, Any]], ivs: List[Cursor], reasons: List[str]) -> None:
+        """Every access to a written array must use the induction variables as leading subscripts."""
+        for access in group:
+            indices = access['indices']
+            if len(indices) < len(ivs) or not all(self._is_variable(indices[k], ivs[k]) for k in range(len(ivs))):
+                kind = 'written' if access['write'] else 'read'
+                reasons.append(f"{base} is {kind} at {access['text']}, not indexed by "
+                               f"{', '.join(iv.spelling for iv in ivs)}")
+                return
+
+    def _check_scalar(self, base: str, group: List[Dict[str, Any]], function: Optional[Cursor],
+                      loop: Cursor, first_jump: Optional[int], verdict: Dict[str, Any]) -> None:
+        """A written shared scalar must be a reduction or be written before any read, in every iteration."""
+        root = group[0]['root']
+        reasons = verdict['reasons']
+        if '.' in base or root.kind == CursorKind.FIELD_DECL:
+            reasons.append(f"shared member {base} is written in the loop")
+            return
+        if root.type.get_canonical().kind not in self.ARITHMETIC_KINDS:
+            reasons.append(f"{base} of type {root.type.spelling} is written in the loop")
+            return
+
+        writes = [access for access in group if access['write']]
+        reads = [access for access in group if not access['write']]
+        operators = {access['reduction'] for access in writes}
+        if not reads and len(operators) == 1 and None not in operators:
+            verdict['reduction'].setdefault(operators.pop(), []).append(base)
+            return
+
+        first = min(group, key=lambda access: access['offset'])
+        if first['write'] == 'assign' and first['top_level'] and first_jump is not None \
+                and first_jump < first['offset']:
+            # Iterations leaving the body early skip the write, e.g. the last one for lastprivate
+            reasons.append(f"{base} is not assigned in iterations that continue or break before it")
+            return
+        if first['write'] == 'assign' and first['top_level']:
+            if self._used_after(root, function, loop):
+                verdict['lastprivate'].append(base)
+            else:
+                verdict['private'].append(base)
+            return
+
+        reasons.append(f"loop-carried dependence on {base}")
+
+    def _canonical_header(self, loop: Cursor):
+        """Parse `for (init; iv <op> bound; step)`; returns a dict or a rejection reason."""
+        children = list(loop.get_children())
+        if loop.kind != CursorKind.FOR_STMT or len(children) != 4:
+            return "not a canonical for loop"
+        init, condition, increment, _ = children
+
+        start = None
+        if init.kind == CursorKind.DECL_STMT:
+            decls = [child for child in init.get_children() if child.kind == CursorKind.VAR_DECL]
+            if len(decls) != 1:
+                return "loop initializes several variables"
+            iv = decls[0]
+            values = [child for child in iv.get_children() if child.kind not in {CursorKind.TYPE_REF, CursorKind.NAMESPACE_REF}]
+            start = values[-1] if values else None
+        else:
+            init = self._strip(init)
+            operands = list(init.get_children())
+            if init.kind != CursorKind.BINARY_OPERATOR or self.operator(init) != '=' or \
+                    self._strip(operands[0]).kind != CursorKind.DECL_REF_EXPR:
+                return "loop initialization is not a single assignment"
+            iv = self._strip(operands[0]).referenced
+            start = operands[1]
+
+        if iv is None or iv.type.get_canonical().kind not in self.INTEGER_KINDS:
+            return "induction variable is not an integer"
+
+        condition = self._strip(condition)
+        operands = list(condition.get_children())
+        relation = self.operator(condition) if condition.kind == CursorKind.BINARY_OPERATOR else ''
+        if relation not in self.RELATIONAL_OPS or len(operands) != 2:
+            return "loop condition is not a relational test of the induction variable"
+        if self._is_variable(operands[0], iv):
+            bound = operands[1]
+        elif self._is_variable(operands[1], iv):
+            bound = operands[0]
+        else:
+            return "loop condition does not test the induction variable"
+
+        increment = self._strip(increment)
+        step_operator = self.operator(increment)
+        step_operands = list(increment.get_children())
+        invariants = [bound]
+        if increment.kind == CursorKind.UNARY_OPERATOR and step_operator in {'++', '--'} \
+                and self._is_variable(step_operands[0], iv):
+            step = 1 if step_operator == '++' else -1
+        elif increment.kind == CursorKind.COMPOUND_ASSIGNMENT_OPERATOR and step_operator in {'+=', '-='} \
+                and self._is_variable(step_operands[0], iv):
+            step = None
+            invariants.append(step_operands[1])
+        else:
+            return "loop increment is not a constant-stride update of the induction variable"
+
+        return {
+            'iv': iv,
+            'invariants': invariants + ([start] if start is not None else []),
+            'trip_count': self._trip_count(start, bound, relation, step),
+        }
+
+    def _trip_count(self, start: Optional[Cursor], bound: Cursor, relation: str, step: Optional[int]) -> Optional[int]:
+        """Trip count for literal bounds and unit steps, e.g. `for (i = 0; i < 10; ++i)`."""
+        first = self._literal(start)
+        last = self._literal(bound)
+        if first is None or last is None or step is None:
+            return None
+        if step > 0 and relation in {'<', '<='}:
+            return max(0, last - first + (1 if relation == '<=' else 0))
+        if step < 0 and relation in {'>', '>='}:
+            return max(0, first - last + (1 if relation == '>=' else 0))
+        return None
+
+    def _literal(self, cursor: Optional[Cursor]) -> Optional[int]:
+        """Value of an integer literal, or None."""
+        if cursor is None:
+            return None
+        cursor = self._strip(cursor)
+        if cursor.kind != CursorKind.INTEGER_LITERAL:
+            return None
+        tokens = list(cursor.get_tokens())
+        if not tokens:
+            return None
+        try:
+            return int(tokens[0].spelling.rstrip('uUlL'), 0)
+        except ValueError:
+            return None
+
+    def _collect(self, cursor: Cursor, accesses: List[Dict[str, Any]], reasons: List[str],
+                 top_level: bool, write: Optional[str] = None, reduction: Optional[str] = None,
+                 breakable: bool = False) -> None:
+        """Record the variable accesses of an expression or statement in source order."""
+        node = self._strip(cursor)
+        kind = node.kind
+
+        access = self._access(node) if kind in {
+            CursorKind.DECL_REF_EXPR, CursorKind.MEMBER_REF_EXPR,
+            CursorKind.ARRAY_SUBSCRIPT_EXPR, CursorKind.CALL_EXPR,
+        } else None
+        if access is not None:
+            access.update(write=write, reduction=reduction, top_level=top_level)
+            accesses.append(access)
+            for index in access['indices']:
+                self._collect(index, accesses, reasons, top_level=False)
+            return
+        if write is not None:
+            reasons.append(f"writes through {self.ast_parser.get_source_text(node).strip()}")
+            return
+
+        if kind in {CursorKind.BINARY_OPERATOR, CursorKind.COMPOUND_ASSIGNMENT_OPERATOR}:
+            operator = self.operator(node)
+            operands = list(node.get_children())
+            if operator == '=' and len(operands) == 2:
+                target, value = operands
+                pattern = self._reduction_pattern(target, value)
+                if pattern is not None:
+                    operator_symbol, other = pattern
+                    self._collect(target, accesses, reasons, top_level, write='update', reduction=operator_symbol)
+                    self._collect(other, accesses, reasons, top_level=False)
+                else:
+                    position = len(accesses)
+                    self._collect(target, accesses, reasons, top_level, write='assign')
+                    self._collect(value, accesses, reasons, top_level=False)
+                    # The store happens after the right-hand side is read (s = s * 0.5 + a[i])
+                    if position < len(accesses):
+                        accesses[position]['offset'] = node.extent.end.offset
+                return
+            if kind == CursorKind.COMPOUND_ASSIGNMENT_OPERATOR and len(operands) == 2:
+                self._collect(operands[0], accesses, reasons, top_level, write='update',
+                              reduction=self.REDUCTION_OPS.get(operator))
+                self._collect(operands[1], accesses, reasons, top_level=False)
+                return
+
+        if kind == CursorKind.UNARY_OPERATOR and self.operator(node) in {'++', '--'}:
+            operands = list(node.get_children())
+            self._collect(operands[0], accesses, reasons, top_level, write='update', reduction='+')
+            return
+
+        if kind == CursorKind.CALL_EXPR:
+            self._collect_call(node, accesses, reasons)
+            return
+
+        if kind in {CursorKind.RETURN_STMT, CursorKind.GOTO_STMT, CursorKind.INDIRECT_GOTO_STMT}:
+            reasons.append(f"{kind.name.lower().replace('_stmt', '')} leaves the loop early")
+            return
+        if kind == CursorKind.BREAK_STMT and not breakable:
+            reasons.append("break leaves the loop early")
+            return
+        if kind in {CursorKind.CXX_THROW_EXPR, CursorKind.CXX_TRY_STMT}:
+            reasons.append("exception handling in the loop body")
+            return
+        if kind in {CursorKind.ASM_STMT, CursorKind.LAMBDA_EXPR}:
+            reasons.append(f"{kind.name.lower().replace('_', ' ')} in the loop body")
+            return
+        if kind == CursorKind.VAR_DECL and node.storage_class == StorageClass.STATIC:
+            reasons.append(f"static local {node.spelling} is shared between iterations")
+            return
+
+        # Nested loops and switches own their break statements
+        inner_breakable = breakable or kind in self.LOOP_KINDS or kind == CursorKind.SWITCH_STMT
+        for position, child in enumerate(node.get_children()):
+            # Only the init of a top-level for statement runs unconditionally
+            child_top_level = top_level and kind == CursorKind.FOR_STMT and position == 0
+            self._collect(child, accesses, reasons, top_level=child_top_level, breakable=inner_breakable)
+
+    def _collect_call(self, node: Cursor, accesses: List[Dict[str, Any]], reasons: List[str]) -> None:
+        """Allow pure math functions and const container queries; reject other calls."""
+        callee = node.referenced
+        name = node.spelling
+        children = list(node.get_children())
+
+        if callee is not None and callee.kind == CursorKind.CXX_METHOD and name in self.CONST_METHODS:
+            # v.size(): the container is only queried, its elements are not read
+            for child in children[1:]:
+                self._collect(child, accesses, reasons, top_level=False)
+            return
+
+        if callee is not None and callee.kind == CursorKind.FUNCTION_DECL and name in self.PURE_FUNCTIONS \
+                and self._is_library(callee):
+            for child in children:
+                stripped = self._strip(child)
+                if stripped.kind == CursorKind.DECL_REF_EXPR and stripped.referenced == callee:
+                    continue
+                self._collect(child, accesses, reasons, top_level=False)
+            return
+
+        if callee is not None and callee.kind == CursorKind.CONSTRUCTOR:
+            reasons.append(f"constructs {node.type.spelling} in the loop body")
+        else:
+            reasons.append(f"calls {name or 'a function'}()")
+
+    def _is_library(self, decl: Cursor) -> bool:
+        """Declared in a system header or in namespace std, so not a user function of the same name."""
+        for declaration in (decl, decl.canonical):
+            if declaration.location.file is not None and declaration.location.is_in_system_header:
+                return True
+        parent = decl.semantic_parent
+        while parent is not None and parent.kind != CursorKind.TRANSLATION_UNIT:
+            if parent.kind == CursorKind.NAMESPACE and parent.spelling == 'std':
+                return True
+            parent = parent.semantic_parent
+        return False
+
+    def _first_jump(self, cursor: Cursor, nested: bool = False, in_switch: bool = False) -> Optional[int]:
+        """Offset of the first statement that leaves the body of this loop's iteration, or None."""
+        offsets = []
+        for child in cursor.get_children():
+            kind = child.kind
+            if (kind == CursorKind.CONTINUE_STMT and not nested) or \
+                    (kind == CursorKind.BREAK_STMT and not nested and not in_switch) or \
+                    kind in {CursorKind.RETURN_STMT, CursorKind.GOTO_STMT, CursorKind.INDIRECT_GOTO_STMT}:
+                offsets.append(child.extent.start.offset)
+                continue
+            # Nested loops own their continue and break, switches their break
+            offset = self._first_jump(child, nested or kind in self.LOOP_KINDS,
+                                      in_switch or kind == CursorKind.SWITCH_STMT)
+            if offset is not None:
+                offsets.append(offset)
+        return min(offsets, default=None)
+
+    def _reduction_pattern(self, target: Cursor, value: Cursor) -> Optional[Tuple[str, Cursor]]:
+        """Match `x = x op e` / `x = e op x`; returns (op, e)."""
+        target_access = self._access(self._strip(target))
+        value = self._strip(value)
+        if target_access is None or target_access['indices'] or value.kind != CursorKind.BINARY_OPERATOR:
+            return None
+        operator = self.operator(value)
+        if operator not in self.BINARY_REDUCTION_OPS and operator != '-':
+            return None
+        left, right = list(value.get_children())
+        left_access = self._access(self._strip(left))
+        if left_access is not None and left_access['key'] == target_access['key']:
+            return ('+' if operator == '-' else operator), right
+        right_access = self._access(self._strip(right))
+        if operator != '-' and right_access is not None and right_access['key'] == target_access['key']:
+            return operator, left
+        return None
+
+    def _access(self, node: Cursor) -> Optional[Dict[str, Any]]:
+        """Decompose `a.b[i][j]`-style lvalues into root declaration, base name and subscripts."""
+        start = node
+        path: List[str] = []
+        indices: List[Cursor] = []
+        while True:
+            subscript = self._subscript(node)
+            if subscript is not None:
+                node, index = subscript
+                indices.insert(0, index)
+                path.insert(0, '[]')
+                node = self._strip(node)
+                continue
+
+            if node.kind == CursorKind.MEMBER_REF_EXPR:
+                referenced = node.referenced
+                if referenced is None or referenced.kind != CursorKind.FIELD_DECL:
+                    return None
+                children = list(node.get_children())
+                if not children or self._strip(children[0]).kind == CursorKind.CXX_THIS_EXPR:
+                    # Implicit this: the field itself is the root
+                    root, name = referenced, referenced.spelling
+                    break
+                path.insert(0, '.' + node.spelling)
+                node = self._strip(children[0])
+                continue
+
+            if node.kind == CursorKind.DECL_REF_EXPR:
+                root = node.referenced
+                if root is None or root.kind not in {CursorKind.VAR_DECL, CursorKind.PARM_DECL}:
+                    return None
+                name = node.spelling
+                break
+
+            return None
+
+        key = name + ''.join(path)
+        return {
+            'root': root,
+            'key': key,
+            'base': key.split('[')[0],
+            'indices': indices,
+            'offset': start.extent.start.offset,
+            'text': self.ast_parser.get_source_text(start).strip(),
+        }
+
+    def _subscript(self, node: Cursor) -> Optional[Tuple[Cursor, Cursor]]:
+        """Return (base, index) for built-in or overloaded `operator[]` subscripts."""
+        if node.kind == CursorKind.ARRAY_SUBSCRIPT_EXPR:
+            children = list(node.get_children())
+            return (children[0], children[1]) if len(children) == 2 else None
+        if node.kind == CursorKind.CALL_EXPR and node.spelling == 'operator[]':
+            operands = []
+            for child in node.get_children():
+                stripped = self._strip(child)
+                referenced = stripped.referenced
+                if stripped.kind == CursorKind.DECL_REF_EXPR and referenced is not None \
+                        and referenced.kind == CursorKind.CXX_METHOD:
+                    continue
+                operands.append(child)
+            return (operands[0], operands[1]) if len(operands) == 2 else None
+        return None
+
+    def operator(self, cursor: Cursor) -> str:
+        """Spell the operator of a unary, binary or compound assignment expression."""
+        tokens = list(cursor.get_tokens())
+        children = list(cursor.get_children())
+        if not tokens or not children:
+            return ''
+        if cursor.kind == CursorKind.UNARY_OPERATOR:
+            if tokens[0].extent.start.offset < children[0].extent.start.offset:
+                return tokens[0].spelling
+            return tokens[-1].spelling
+        left_end = children[0].extent.end.offset
+        for token in tokens:
+            if token.extent.start.offset >= left_end:
+                return token.spelling
+        return ''
+
+    def _statements(self, body: Cursor) -> List[Cursor]:
+        """Top-level statements of a loop body."""
+        if body.kind == CursorKind.COMPOUND_STMT:
+            return list(body.get_children())
+        return [body]
+
+    def _strip(self, cursor: Cursor) -> Cursor:
+        """Look through implicit conversions, parentheses and casts."""
+        while cursor.kind in self.WRAPPER_KINDS:
+            children = [child for child in cursor.get_children()
+                        if child.kind not in {CursorKind.TYPE_REF, CursorKind.NAMESPACE_REF, CursorKind.TEMPLATE_REF}]
+            if len(children) != 1:
+                break
+            cursor = children[0]
+        return cursor
+
+    def _is_variable(self, cursor: Cursor, decl: Cursor) -> bool:
+        """True when the expression is exactly a reference to decl."""
+        cursor = self._strip(cursor)
+        return cursor.kind == CursorKind.DECL_REF_EXPR and cursor.referenced == decl
+
+    def _is_pointer(self, decl: Cursor) -> bool:
+        """Pointer (or reference-to-pointer) declarations may alias each other."""
+        type_obj = decl.type.get_canonical()
+        if type_obj.kind in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE}:
+            type_obj = type_obj.get_pointee().get_canonical()
+        return type_obj.kind == TypeKind.POINTER
+
+    def _is_array(self, decl: Cursor) -> bool:
+        """Array variables; two distinct arrays never overlap, but a pointer may point into one."""
+        return decl.type.get_canonical().kind in {TypeKind.CONSTANTARRAY, TypeKind.INCOMPLETEARRAY}
+
+    def _pointer_sources(self, decl: Cursor, function: Optional[Cursor]) -> List[Cursor]:
+        """Declarations a pointer is initialized or assigned from (a in b = a + 1)."""
+        expressions = [child for child in decl.get_children()
+                       if child.kind not in {CursorKind.TYPE_REF, CursorKind.NAMESPACE_REF}]
+        if function is not None:
+            for cursor in function.walk_preorder():
+                if cursor.kind != CursorKind.BINARY_OPERATOR:
+                    continue
+                operands = list(cursor.get_children())
+                if len(operands) == 2 and self._is_variable(operands[0], decl) and self.operator(cursor) == '=':
+                    expressions.append(operands[1])
+        return [cursor.referenced for expression in expressions for cursor in expression.walk_preorder()
+                if cursor.kind == CursorKind.DECL_REF_EXPR and cursor.referenced is not None]
+
+    def _used_after(self, decl: Cursor, function: Optional[Cursor], loop: Cursor) -> bool:
+        """Whether decl may be read once the loop is done: later in the enclosing function, earlier in
+        an enclosing loop (on its next iteration), or anywhere unless it is a local."""
+        if function is None or not self._is_automatic(decl):
+            return True
+        loop_start, loop_end = loop.extent.start.offset, loop.extent.end.offset
+        enclosing = [cursor.extent.start.offset for cursor in function.walk_preorder()
+                     if cursor.kind in self.LOOP_KINDS and cursor.extent.start.offset < loop_start
+                     and cursor.extent.end.offset >= loop_end]
+        live_from = min(enclosing, default=loop_start)
+        for cursor in function.walk_preorder():
+            if cursor.kind != CursorKind.DECL_REF_EXPR or cursor.referenced != decl:
+                continue
+            offset = cursor.extent.start.offset
+            if offset > loop_end or live_from <= offset < loop_start:
+                return True
+        return False
+
+    def _is_automatic(self, decl: Cursor) -> bool:
+        """Local non-static variables and parameters, not references; other storage outlives the function."""
+        if decl.type.kind in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE}:
+            return False
+        if decl.kind == CursorKind.PARM_DECL:
+            return True
+        if decl.kind != CursorKind.VAR_DECL or decl.storage_class in {StorageClass.STATIC, StorageClass.EXTERN}:
+            return False
+        parent = decl.semantic_parent
+        return parent is not None and parent.kind in self.FUNCTION_KINDS
+
+
+class OpenMPRewriter:
+    """Proposes OpenMP pragmas for independent loops as a reviewable patch."""
+
+    FUNCTION_KINDS = ParallelLoopAnalyzer.FUNCTION_KINDS
+
+    def __init__(self, config: Config, simd: bool = True, min_parallel_iterations: int = 1000,
+                 loop_ids: Optional[List[str]] = None):
+        """Initialize the rewriter with configuration."""
+        self.config = config
+        self.simd = simd
+        self.min_parallel_iterations = min_parallel_iterations
+        self.loop_ids = set(loop_ids or [])
+        # loop_id by (line, column) of the file being rewritten, from the analysis
+        self._file_loop_ids: Dict[Tuple[int, int], str] = {}
+        self.logger = logging.getLogger(__name__)
+        self.ast_parser = ASTParser(config)
+        self.analyzer = ParallelLoopAnalyzer(self.ast_parser)
+
+    def rewrite_tree(self, analysis_results: Dict[str, Any], patch_path: Path,
+                     output_dir: Optional[Path] = None) -> Dict[str, Any]:
+        """Classify every analyzed file, write the patch and annotate loop records."""
+        index = LoopIndex(analysis_results)
+        diffs: List[str] = []
+        notes: List[str] = []
+        verdicts: Dict[Tuple[str, int, int], Dict[str, Any]] = {}
+        counts = {'parallel_for': 0, 'simd': 0, 'sequential': 0}
+        loop_ids: Dict[str, Dict[Tuple[int, int], str]] = {}
+        for file_path, _, loop in index.iter_loops():
+            location = loop.get('location', {})
+            loop_ids.setdefault(file_path, {}).setdefault(
+                (location.get('start_line', 0), location.get('start_column', 0)), loop.get('loop_id', ''))
+
+        for file_path in analysis_results:
+            source_file = Path(file_path)
+            decisions = self.rewrite_file(source_file, loop_ids.get(file_path))
+            if decisions is None:
+                continue
+            original, rewritten, file_verdicts = decisions
+
+            for (line, column), verdict in file_verdicts.items():
+                verdicts[(file_path, line, column)] = verdict
+                pragma = verdict.get('pragma')
+                if pragma:
+                    counts['simd' if ' simd' in pragma else 'parallel_for'] += 1
+                    notes.append(f"{file_path}:{line} {pragma}")
+                    notes += [f"    assumes {assumption}" for assumption in verdict['assumptions']]
+                elif pragma is None and not verdict['parallel']:
+                    counts['sequential'] += 1
+
+            if rewritten == original:
+                continue
+            display = self._display_path(source_file)
+            diffs.append(''.join(difflib.unified_diff(
+                self._lines(original), self._lines(rewritten),
+                fromfile=f"a/{display}", tofile=f"b/{display}",
+            )))
+            if output_dir is not None:
+                destination = output_dir / display
+                destination.parent.mkdir(parents=True, exist_ok=True)
+                destination.write_text(rewritten, encoding='utf-8', errors='surrogateescape')
+
+        for file_path, _, loop in index.iter_loops():
+            location = loop.get('location', {})
+            verdict = verdicts.get((file_path, location.get('start_line', 0), location.get('start_column', 0)))
+            if verdict is not None:
+                loop.setdefault('extensions', {})['parallelism'] = self._extension(verdict)
+
+        # Text before the first --- header is ignored by patch and git apply
+        header = [
+            'OpenMP pragmas proposed by loop_extractor openmp.',
+            'Review each hunk before applying (patch -p1 or git apply) and build with -fopenmp.',
+            'Reductions reorder floating-point additions; results may differ in the last bits.',
+            '',
+        ] + notes + ['']
+        patch_path.parent.mkdir(parents=True, exist_ok=True)
+        patch_path.write_text('\n'.join(header) + '\n' + ''.join(diffs), encoding='utf-8', errors='surrogateescape')
+
+        self.logger.info(f"Proposed {counts['parallel_for']} parallel for and {counts['simd']} simd pragmas "
+                         f"in {len(diffs)} files; patch written to {patch_path}")
+        return {
+            'patch': str(patch_path),
+            'files_changed': len(diffs),
+            'pragmas': counts,
+        }
+
+    def rewrite_file(self, source_file: Path, loop_ids: Optional[Dict[Tuple[int, int], str]] = None):
+        """Classify the loops of one file; returns (original, rewritten, verdicts by (line, column))."""
+        self._file_loop_ids = loop_ids or {}
+        translation_unit = self.ast_parser.parse_file(source_file)
+        if translation_unit is None:
+            self.logger.warning(f"Failed to parse {source_file}; no pragmas proposed")
+            return None
+        if any(diagnostic.severity >= Diagnostic.Error for diagnostic in translation_unit.diagnostics):
+            # Unresolved expressions would hide writes and calls from the dependence check
+            self.logger.warning(f"Parse errors in {source_file}; no pragmas proposed")
+            return None
+
+        original = source_file.read_text(encoding='utf-8', errors='surrogateescape')
+        source = original.encode('utf-8', errors='surrogateescape')
+        lines = original.splitlines(keepends=True)
+        pragmas: Dict[int, str] = {}
+        verdicts: Dict[Tuple[int, int], Dict[str, Any]] = {}
+
+        def visit(cursor: Cursor, function: Optional[Cursor], in_parallel: bool) -> None:
+            for child in cursor.get_children():
+                if not self.ast_parser.is_in_file(child, source_file):
+                    continue
+                child_function = function
+                child_parallel = in_parallel
+                if child.kind in self.FUNCTION_KINDS:
+                    child_function = child
+                    # Existing parallel regions are left alone; only simd is added inside them
+                    child_parallel = b'#pragma omp' in source[child.extent.start.offset:child.extent.end.offset]
+                if child.kind in ParallelLoopAnalyzer.LOOP_KINDS:
+                    self._visit_loop(child, child_function, child_parallel, source_file, source, lines,
+                                     pragmas, verdicts, visit)
+                else:
+                    visit(child, child_function, child_parallel)
+
+        visit(translation_unit.cursor, None, False)
+
+        rewritten_lines = list(lines)
+        for line in sorted(pragmas, reverse=True):
+            text = lines[line - 1]
+            indent = text[:len(text) - len(text.lstrip())]
+            rewritten_lines.insert(line - 1, f"{indent}{pragmas[line]}\n")
+        return original, ''.join(rewritten_lines), verdicts
+
+    def _visit_loop(self, loop: Cursor, function: Optional[Cursor], in_parallel: bool, source_file: Path,
+                    source: bytes, lines: List[str], pragmas: Dict[int, str],
+                    verdicts: Dict[Tuple[int, int], Dict[str, Any]], visit) -> None:
+        """Classify one loop, choose its pragma and continue into its body."""
+        line = loop.extent.start.line
+        column = loop.extent.start.column
+        verdict = self.analyzer.classify([loop], function, source_file)
+        verdict['pragma'] = None
+        verdicts[(line, column)] = verdict
+
+        previous = next((text.strip() for text in reversed(lines[:line - 1]) if text.strip()), '')
+        if previous.startswith('#pragma omp'):
+            verdict['skipped'] = 'loop already has an OpenMP pragma'
+            visit(loop, function, True)
+            return
+        if verdict['parallel']:
+            # Pragmas go on their own line, so the loop must start one in plain source
+            if not source[loop.extent.start.offset:].startswith(b'for'):
+                verdict['skipped'] = 'loop comes from a macro expansion'
+            elif lines[line - 1][:column - 1].strip():
+                verdict['skipped'] = 'loop shares its line with other code'
+            if 'skipped' in verdict:
+                visit(loop, function, in_parallel)
+                return
+
+        selected = not self.loop_ids or self._loop_id(line, column) in self.loop_ids
+        trip_count = verdict['trip_count']
+        worth_threads = trip_count is None or trip_count >= self.min_parallel_iterations
+
+        if selected and not in_parallel and verdict['parallel'] and worth_threads:
+            chain = self.analyzer.perfect_nest(loop)
+            while len(chain) > 1:
+                collapsed = self.analyzer.classify(chain, function, source_file)
+                if collapsed['parallel']:
+                    verdict.update({key: collapsed[key] for key in
+                                    ('private', 'lastprivate', 'reduction', 'assumptions', 'induction_variables')})
+                    break
+                chain = chain[:-1]
+            verdict['collapse'] = len(chain)
+            verdict['pragma'] = self._pragma('parallel for', verdict)
+            pragmas[line] = verdict['pragma']
+            # Collapsed loops are associated with the pragma; only their body is visited
+            for inner in chain[1:]:
+                verdicts[(inner.extent.start.line, inner.extent.start.column)] = dict(
+                    self.analyzer.classify([inner], function, source_file),
+                    pragma='', collapsed_into=self._loop_id(line, column))
+            visit(list(chain[-1].get_children())[-1], function, True)
+            return
+
+        innermost = not any(child.kind in ParallelLoopAnalyzer.LOOP_KINDS for child in loop.walk_preorder()
+                            if child != loop)
+        if selected and self.simd and verdict['parallel'] and innermost:
+            verdict['pragma'] = self._pragma('simd', verdict)
+            pragmas[line] = verdict['pragma']
+
+        visit(loop, function, in_parallel)
+
+    def _loop_id(self, line: int, column: int) -> str:
+        """loop_id of the loop starting at line and column; the position for loops not in the analysis."""
+        return self._file_loop_ids.get((line, column), f"loop_{line}_{column}")
+
+    def _pragma(self, directive: str, verdict: Dict[str, Any]) -> str:
+        """Spell the pragma with its data-sharing clauses."""
+        clauses = [f"#pragma omp {directive}"]
+        if verdict.get('collapse', 1) > 1:
+            clauses.append(f"collapse({verdict['collapse']})")
+        if verdict['private']:
+            clauses.append(f"private({', '.join(verdict['private'])})")
+        if verdict['lastprivate']:
+            clauses.append(f"lastprivate({', '.join(verdict['lastprivate'])})")
+        for operator, names in sorted(verdict['reduction'].items()):
+            clauses.append(f"reduction({operator}:{', '.join(names)})")
+        return ' '.join(clauses)
+
+    def _extension(self, verdict: Dict[str, Any]) -> Dict[str, Any]:
+        """JSON form of a verdict for loop['extensions']['parallelism']."""
+        if not verdict['parallel']:
+            classification = 'sequential'
+        elif verdict['reduction']:
+            classification = 'reduction'
+        else:
+            classification = 'parallel'
+        extension = {
+            'verdict': classification,
+            'pragma': verdict.get('pragma') or None,
+            'reasons': verdict['reasons'],
+            'private': verdict['private'],
+            'lastprivate': verdict['lastprivate'],
+            'reduction': verdict['reduction'],
+            'collapse': verdict.get('collapse', 1),
+            'assumptions': verdict['assumptions'],
+        }
+        for key in ('skipped', 'collapsed_into'):
+            if key in verdict:
+                extension[key] = verdict[key]
+        return extension
+
+    def _display_path(self, source_file: Path) -> str:
+        """Path used in the diff headers, relative to the working directory when possible."""
+        if not source_file.is_absolute():
+            return source_file.as_posix()
+        relative = os.path.relpath(source_file, Path.cwd())
+        return Path(relative).as_posix() if not relative.startswith('..') else source_file.as_posix().lstrip('/')
+
+    def _lines(self, text: str) -> List[str]:
+        """Split for difflib, making sure the last line is newline-terminated."""
+        lines = text.splitlines(keepends=True)
+        if lines and not lines[-1].endswith('\n'):
+            lines[-1] += '\n'
+        return lines
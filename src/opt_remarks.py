@@ -0,0 +1,278 @@
+"""
+Compiler optimization-remark ingestion module.
+
+Supported inputs are local build artifacts:
+  - Clang `-fsave-optimization-record` YAML files
+  - GCC `-fopt-info-vec-all` / `-fopt-info-loop-all` text output
+"""
+
+import logging
+import re
+from pathlib import Path
+from typing import Dict, List, Any
+
+from .loop_index import LoopIndex
+
+
+class OptRemarksIngest:
+    """Parses compiler optimization remarks and joins them onto loop records."""
+
+    FORMATS = ('clang', 'gcc')
+
+    GCC_REMARK = re.compile(r'^(.+?):(\d+):(\d+):\s+(optimized|missed|note):\s+(.*)$')
+
+    def __init__(self):
+        self.logger = logging.getLogger(__name__)
+        self.remarks: List[Dict[str, Any]] = []
+
+    def detect_format(self, remarks_path: Path) -> str:
+        """Guess the remark format from the file name and its first line."""
+        if remarks_path.suffix in {'.yaml', '.yml'}:
+            return 'clang'
+        with open(remarks_path, 'r', encoding='utf-8', errors='ignore') as f:
+            first_line = f.readline()
+        return 'clang' if first_line.startswith('--- !') else 'gcc'
+
+    def load(self, remarks_path: Path, remarks_format: str = 'auto') -> None:
+        """Load remarks from one file."""
+        if remarks_format == 'auto':
+            remarks_format = self.detect_format(remarks_path)
+
+        if remarks_format == 'clang':
+            loaded = self._load_clang(remarks_path)
+        elif remarks_format == 'gcc':
+            loaded = self._load_gcc(remarks_path)
+        else:
+            raise ValueError(f"Unsupported remarks format: {remarks_format}")
+
+        self.remarks.extend(loaded)
+        self.logger.info(f"Loaded {len(loaded)} loop remarks from {remarks_path}")
+
+    def _load_clang(self, remarks_path: Path) -> List[Dict[str, Any]]:
+        """Parse a Clang optimization record YAML stream."""
+        try:
+            import yaml
+        except ImportError as e:
+            raise ImportError("PyYAML is required for Clang remarks. Please install with: pip install PyYAML") from e
+
+        class RemarkLoader(yaml.SafeLoader):
+            pass
+
+        def construct_remark(loader, tag_suffix, node):
+            remark = loader.construct_mapping(node, deep=True)
+            remark['_kind'] = tag_suffix
+            return remark
+
+        # Every document is tagged with its remark kind (!Passed, !Missed, !Analysis...)
+        RemarkLoader.add_multi_constructor('!', construct_remark)
+
+        remarks = []
+        with open(remarks_path, 'r', encoding='utf-8', errors='ignore') as f:
+            for document in yaml.load_all(f, Loader=RemarkLoader):
+                if not isinstance(document, dict):
+                    continue
+
+                pass_name = str(document.get('Pass', ''))
+                if not (pass_name.startswith('loop-') or 'vectoriz' in pass_name):
+                    continue
+
+                debug_loc = document.get('DebugLoc') or {}
+                if not debug_loc.get('File'):
+                    continue
+
+                message_parts = []
+                for arg in document.get('Args', []) or []:
+                    for key, value in arg.items():
+                        if key != 'DebugLoc':
+                            message_parts.append(str(value))
+
+                kind = document['_kind']
+                remarks.append({
+                    'compiler': 'clang',
+                    'file': debug_loc['File'],
+                    'line': int(debug_loc.get('Line', 0)),
+                    'column': int(debug_loc.get('Column', 0)),
+                    'status': 'optimized' if kind == 'Passed' else 'missed',
+                    'pass': pass_name,
+                    'name': str(document.get('Name', '')),
+                    'message': ''.join(message_parts).strip(),
+                })
+
+        return remarks
+
+    def _load_gcc(self, remarks_path: Path) -> List[Dict[str, Any]]:
+        """Parse GCC -fopt-info text output."""
+        remarks = []
+        with open(remarks_path, 'r', encoding='utf-8', errors='ignore') as f:
+            for line in f:
+                match = self.GCC_REMARK.match(line.rstrip('\n'))
+                if not match or match.group(4) == 'note':
+                    continue
+
+                message = match.group(5).strip()
+                if 'vectoriz' in message:
+                    pass_name = 'vect'
+                elif 'unroll' in message:
+                    pass_name = 'unroll'
+                else:
+                    pass_name = 'loop'
+
+                remarks.append({
+                    'compiler': 'gcc',
+                    'file': match.group(1),
+                    'line': int(match.group(2)),
+                    'column': int(match.group(3)),
+                    'status': match.group(4),
+                    'pass': pass_name,
+                    'name': '',
+                    'message': message,
+                })
+
+        return remarks
+
+    def classify(self, remark: Dict[str, Any]) -> str:
+        """Classify a remark as vectorized, unrolled, missed_vectorization or other."""
+        text = f"{remark['name']} {remark['message']}".lower()
+        is_vector_pass = remark['pass'] in {'loop-vectorize', 'vect'}
+
+        if remark['status'] == 'optimized':
+            if is_vector_pass and 'vectorized' in text:
+                return 'vectorized'
+            if 'unroll' in remark['pass'] or 'unrolled' in text:
+                return 'unrolled'
+            return 'other'
+
+        if is_vector_pass:
+            return 'missed_vectorization'
+        return 'missed_other'
+
+    def annotate(self, analysis_results: Dict[str, Any]) -> Dict[str, Any]:
+        """Attach a compiler verdict and missed-optimization reasons to each loop."""
+        index = LoopIndex(analysis_results)
+        per_loop: Dict[int, Dict[str, Any]] = {}
+        categories: Dict[int, set] = {}
+        unmatched = 0
+
+        for remark in self.remarks:
+            loops = index.innermost_at(remark['file'], remark['line'])
+            if not loops:
+                unmatched += 1
+                continue
+
+            category = self.classify(remark)
+            for loop in loops:
+                entry = per_loop.setdefault(id(loop), {
+                    'vectorized': False,
+                    'unrolled': False,
+                    'missed_reasons': [],
+                    'optimizations': [],
+                    'compilers': [],
+                })
+                if remark['compiler'] not in entry['compilers']:
+                    entry['compilers'].append(remark['compiler'])
+
+                if category == 'vectorized':
+                    entry['vectorized'] = True
+                    entry['optimizations'].append(remark['message'])
+                elif category == 'unrolled':
+                    entry['unrolled'] = True
+                    entry['optimizations'].append(remark['message'])
+                elif category == 'other':
+                    entry['optimizations'].append(remark['message'])
+                elif remark['message'] and remark['message'] not in entry['missed_reasons']:
+                    entry['missed_reasons'].append(remark['message'])
+                categories.setdefault(id(loop), set()).add(category)
+
+        counts = {'vectorized': 0, 'not_vectorized': 0, 'no_vectorization_remarks': 0}
+        for _, _, loop in index.iter_loops():
+            entry = per_loop.get(id(loop))
+            if entry is None:
+                verdict = 'no_vectorization_remarks'
+                entry = {'vectorized': False, 'unrolled': False, 'missed_reasons': [],
+                         'optimizations': [], 'compilers': []}
+            else:
+                if entry['vectorized']:
+                    verdict = 'vectorized'
+                elif 'missed_vectorization' in categories[id(loop)]:
+                    verdict = 'not_vectorized'
+                else:
+                    verdict = 'no_vectorization_remarks'
+
+            counts[verdict] += 1
+            loop.setdefault('extensions', {})['compiler'] = dict(entry, verdict=verdict)
+
+        summary = {
+            'remarks_loaded': len(self.remarks),
+            'remarks_unmatched': unmatched,
+            'verdicts': counts,
+        }
+        self.logger.info(f"Compiler verdicts: {counts['vectorized']} vectorized, "
+                         f"{counts['not_vectorized']} not vectorized")
+        return summary
+
+    def missed_hot_loops(self, analysis_results: Dict[str, Any], top_n: int = 50) -> List[Dict[str, Any]]:
+        """List loops the compiler failed to vectorize, hottest first.
+
+        Hotness uses measured profile fractions or coverage iterations when the
+        analysis has been annotated with them, falling back to nesting level.
+        One basis, the best any loop has, ranks every loop: a loop without
+        samples in a profiled analysis is cold, whatever its nesting level.
+        """
+        index = LoopIndex(analysis_results)
+        missed = []
+
+        annotated = {key for _, _, loop in index.iter_loops() for key in loop.get('extensions', {})}
+        basis = 'profile' if 'profile' in annotated else 'coverage' if 'coverage' in annotated else 'nesting_level'
+
+        for file_path, function_name, loop in index.iter_loops():
+            extensions = loop.get('extensions', {})
+            compiler = extensions.get('compiler', {})
+            if compiler.get('verdict') != 'not_vectorized':
+                continue
+
+            if basis == 'profile':
+                hotness = extensions.get('profile', {}).get('inclusive_fraction', 0)
+            elif basis == 'coverage':
+                hotness = extensions.get('coverage', {}).get('iterations', 0)
+            else:
+                hotness = loop.get('nesting_level', 1)
+
+            missed.append({
+                'file': file_path,
+                'function': function_name,
+                'loop_id': loop.get('loop_id', ''),
+                'start_line': loop.get('location', {}).get('start_line', 0),
+                'hotness': hotness,
+                'hotness_basis': basis,
+                'missed_reasons': compiler.get('missed_reasons', []),
+            })
+
+        # Duplicate records of the same loop (function-level and nested) collapse
+        unique = {}
+        for entry in missed:
+            unique.setdefault((entry['file'], entry['loop_id']), entry)
+
+        ranked = sorted(unique.values(), key=lambda entry: entry['hotness'], reverse=True)
+        return ranked[:top_n]
+
+    def write_report(self, missed_loops: List[Dict[str, Any]], report_path: str) -> None:
+        """Write a markdown report of hot loops that were not vectorized."""
+        lines = [
+            '# Hot Loops Not Vectorized',
+            '',
+            f'{len(missed_loops)} loops listed, hottest first.',
+            '',
+            '| Hotness | Basis | File | Function | Loop | Reasons |',
+            '|---------|-------|------|----------|------|---------|',
+        ]
+        for entry in missed_loops:
+            reasons = '; '.join(entry['missed_reasons']).replace('|', '\\|') or '-'
+            lines.append(
+                f"| {entry['hotness']} | {entry['hotness_basis']} | {Path(entry['file']).name}:{entry['start_line']} "
+                f"| {entry['function']} | {entry['loop_id']} | {reasons} |"
+            )
+
+        Path(report_path).parent.mkdir(parents=True, exist_ok=True)
+        with open(report_path, 'w', encoding='utf-8') as f:
+            f.write('\n'.join(lines) + '\n')
+        self.logger.info(f"Missed-vectorization report written to: {report_path}")
@@ -0,0 +1,142 @@
+"""
+Parallel file analysis.
+
+Forks worker processes that each inherit the run's parser and analyzer.
+Workers pull the next file from a shared index into the largest-first
+list, so an idle worker always takes the most expensive remaining file
+and no worker is left with a static share of big files. Results stream
+back to the parent in completion order. A worker that dies (for example
+a libclang crash without a per-file budget) is replaced, and the file it
+was working on is reported as `crashed`; so is a file whose position was
+claimed by a worker that died before announcing it.
+"""
+
+import logging
+import multiprocessing
+import multiprocessing.connection
+from pathlib import Path
+from typing import Dict, List, Any, Iterator, Tuple, Optional
+
+from .file_supervisor import SupervisedFileAnalyzer
+
+
+class ParallelFileAnalyzer:
+    """Runs SupervisedFileAnalyzer.analyze on many files in forked workers."""
+
+    def __init__(self, file_analyzer: SupervisedFileAnalyzer, jobs: int):
+        """Initialize the runner; jobs is the number of worker processes."""
+        if 'fork' not in multiprocessing.get_all_start_methods():
+            raise RuntimeError("Parallel analysis needs fork(); run with --jobs 1 on this platform")
+        self.file_analyzer = file_analyzer
+        self.jobs = jobs
+        self.logger = logging.getLogger(__name__)
+        self._context = multiprocessing.get_context('fork')
+        self._workers: Dict[int, Tuple[multiprocessing.Process, multiprocessing.connection.Connection]] = {}
+
+    def imap(self, files: List[Path]) -> Iterator[Tuple[Path, Dict[str, Any]]]:
+        """Yield (file, outcome) as files complete; outcomes are as from SupervisedFileAnalyzer.analyze.
+
+        Errors raised by the analysis come back as outcomes with status 'failed'.
+        """
+        # Workers claim list positions under the lock; files are inherited through fork
+        self._files = list(files)
+        self._next_file = self._context.Value('i', 0)
+        in_flight: Dict[int, Optional[int]] = {}
+        # Positions a worker announced; a claimed position missing here belongs to a worker that died
+        announced = set()
+        remaining = len(self._files)
+        next_worker_id = 0
+
+        try:
+            for _ in range(min(self.jobs, remaining)):
+                self._start_worker(next_worker_id)
+                in_flight[next_worker_id] = None
+                next_worker_id += 1
+
+            while remaining and self._workers:
+                connections = {connection: worker_id for worker_id, (_, connection) in self._workers.items()}
+                for connection in multiprocessing.connection.wait(list(connections)):
+                    worker_id = connections[connection]
+                    try:
+                        message = connection.recv()
+                    except EOFError:
+                        # Worker exited: normally when the list is exhausted, otherwise it died
+                        process, _ = self._workers.pop(worker_id)
+                        process.join()
+                        connection.close()
+                        crashed_position = in_flight.pop(worker_id)
+                        if crashed_position is not None:
+                            remaining -= 1
+                            crashed_file = self._files[crashed_position]
+                            self.logger.warning(f"Worker {worker_id} died (exit code {process.exitcode}) "
+                                                f"while analyzing {crashed_file}")
+                            yield crashed_file, {
+                                'status': 'crashed',
+                                'error': f"worker exited with code {process.exitcode}",
+                                'seconds': 0.0,
+                            }
+                        # Also after a death between claiming and announcing a file
+                        if self._next_file.value < len(self._files):
+                            self._start_worker(next_worker_id)
+                            in_flight[next_worker_id] = None
+                            next_worker_id += 1
+                        continue
+
+                    kind, position, outcome = message
+                    if kind == 'start':
+                        announced.add(position)
+                        in_flight[worker_id] = position
+                    else:
+                        in_flight[worker_id] = None
+                        remaining -= 1
+                        yield self._files[position], outcome
+
+            claimed = min(self._next_file.value, len(self._files))
+            for position in range(claimed):
+                if position not in announced:
+                    self.logger.warning(f"A worker died after claiming {self._files[position]}")
+                    yield self._files[position], {
+                        'status': 'crashed',
+                        'error': "worker exited before reporting the file",
+                        'seconds': 0.0,
+                    }
+        finally:
+            self.close()
+
+    def close(self) -> None:
+        """Stop all workers; unfinished files are left for a resumed run."""
+        for process, connection in self._workers.values():
+            if process.is_alive():
+                process.terminate()
+            process.join()
+            connection.close()
+        self._workers.clear()
+
+    def _start_worker(self, worker_id: int) -> None:
+        """Fork one worker with its own result pipe."""
+        receiver, sender = self._context.Pipe(duplex=False)
+        process = self._context.Process(target=self._worker_main, args=(sender,), name=f'loop-worker-{worker_id}')
+        process.start()
+        sender.close()
+        self._workers[worker_id] = (process, receiver)
+
+    def _worker_main(self, sender) -> None:
+        """Worker loop: claim the next file, analyze it, send the outcome."""
+        try:
+            while True:
+                with self._next_file.get_lock():
+                    position = self._next_file.value
+                    self._next_file.value += 1
+                if position >= len(self._files):
+                    return
+                sender.send(('start', position, None))
+                try:
+                    outcome = self.file_analyzer.analyze(self._files[position])
+                except Exception as e:
+                    outcome = {'status': 'failed', 'error': str(e), 'seconds': 0.0}
+                sender.send(('done', position, outcome))
+        except KeyboardInterrupt:
+            # The parent handles Ctrl+C and saves a checkpoint
+            pass
+        finally:
+            sender.close()
@@ -0,0 +1,103 @@
+"""
+Compiled include/exclude filters for file discovery.
+
+Patterns come in three forms:
+
+- plain text (no `*`, `?` or `[`): substring of the full path, as before;
+- globs: matched against the path relative to the scan root. `*` and `?`
+  stay within one path component, `**` spans directories. A glob without
+  `/` matches any file or directory name; a glob with `/` is anchored at
+  the scan root. A glob matching a directory covers everything below it,
+  so `--exclude 'third_party/*'` prunes the whole tree;
+- `re:` followed by a regular expression searched in the relative path.
+
+All globs and regexes of a list are combined into one compiled regex, so a
+path is tested once per list however many patterns there are.
+"""
+
+import re
+from typing import List, Optional, Pattern
+
+
+class PathFilter:
+    """Include/exclude test for relative paths, compiled once per run."""
+
+    GLOB_CHARACTERS = set('*?[')
+    REGEX_PREFIX = 're:'
+
+    def __init__(self, include_patterns: List[str], exclude_patterns: List[str]):
+        """Compile the pattern lists; an empty include list includes everything."""
+        self.include_substrings, self.include_regex = self._compile(include_patterns)
+        self.exclude_substrings, self.exclude_regex = self._compile(exclude_patterns)
+        self.has_includes = bool(include_patterns)
+
+    def includes_file(self, path: str, relative: str) -> bool:
+        """Whether a file (full and scan-root-relative path) passes both lists."""
+        if self._matches(path, relative, self.exclude_substrings, self.exclude_regex):
+            return False
+        if self.has_includes:
+            return self._matches(path, relative, self.include_substrings, self.include_regex)
+        return True
+
+    def excludes_directory(self, path: str, relative: str) -> bool:
+        """Whether an exclude pattern covers a whole directory, so it need not be walked."""
+        return self._matches(path, relative + '/', self.exclude_substrings, self.exclude_regex)
+
+    def _matches(self, path: str, relative: str, substrings: List[str], regex: Optional[Pattern]) -> bool:
+        """Test one list: substrings against the full path, the regex against the relative path."""
+        for substring in substrings:
+            if substring in path:
+                return True
+        return regex is not None and regex.search(relative) is not None
+
+    def _compile(self, patterns: List[str]):
+        """Split a list into substrings and one combined regex (None if there is no glob or regex)."""
+        substrings = []
+        expressions = []
+        for pattern in patterns:
+            if pattern.startswith(self.REGEX_PREFIX):
+                expressions.append(f'(?:{pattern[len(self.REGEX_PREFIX):]})')
+            elif self.GLOB_CHARACTERS & set(pattern):
+                expressions.append(self.glob_to_regex(pattern))
+            else:
+                substrings.append(pattern)
+        regex = re.compile('|'.join(expressions)) if expressions else None
+        return substrings, regex
+
+    @staticmethod
+    def glob_to_regex(pattern: str) -> str:
+        """Regex (for re.search) matching a relative path covered by a glob."""
+        anchored = '/' in pattern.rstrip('/')
+        pattern = pattern.strip('/')
+        parts = []
+        index = 0
+        while index < len(pattern):
+            char = pattern[index]
+            if pattern.startswith('**/', index):
+                parts.append('(?:.*/)?')
+                index += 3
+                continue
+            if pattern.startswith('**', index):
+                parts.append('.*')
+                index += 2
+                continue
+            if char == '*':
+                parts.append('[^/]*')
+            elif char == '?':
+                parts.append('[^/]')
+            elif char == '[':
+                end = pattern.find(']', index + 2)
+                if end == -1:
+                    parts.append(re.escape(char))
+                else:
+                    body = pattern[index + 1:end]
+                    if body.startswith('!'):
+                        body = '^' + body[1:]
+                    parts.append('[' + body + ']')
+                    index = end
+            else:
+                parts.append(re.escape(char))
+            index += 1
+        prefix = '^' if anchored else '(?:^|/)'
+        # Matching a leading directory covers the files below it
+        return f"{prefix}{''.join(parts)}(?:/|$)"
@@ -0,0 +1,495 @@
+"""
+Performance findings module.
+
+Scans each analyzed loop for constructs that are usually worth fixing:
+heap allocation, loop-invariant branches, strided innermost accesses and
+I/O. Findings are attached to the loop records (`extensions.findings`) with
+the same location fields the analyzer uses, ready for SARIF export.
+"""
+
+import logging
+import re
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Set, Tuple
+
+try:
+    from clang.cindex import TranslationUnit, CursorKind, Cursor, TypeKind, StorageClass, Diagnostic
+except ImportError as e:
+    raise ImportError("libclang not found. Please install with: pip install libclang") from e
+
+from .config import Config
+from .ast_parser import ASTParser
+from .loop_index import LoopIndex
+from .analysis_passes import AnalysisPass, register_pass
+from .openmp_rewriter import ParallelLoopAnalyzer
+
+
+class LoopFindingDetector(ParallelLoopAnalyzer):
+    """Detects per-loop performance findings; reuses the dependence checker's AST helpers.
+
+    Each finding belongs to the innermost loop whose own body contains it, so a
+    malloc inside a nest is reported once, not once per enclosing loop.
+    """
+
+    RULES = {
+        'LOOP001': {
+            'name': 'HeapAllocationInLoop',
+            'level': 'warning',
+            'short': 'Heap allocation inside a loop',
+            'full': 'The loop body allocates or frees heap memory on every iteration. '
+                    'Hoist the buffer or container out of the loop and reuse it.',
+        },
+        'LOOP002': {
+            'name': 'LoopInvariantBranch',
+            'level': 'note',
+            'short': 'Loop-invariant branch',
+            'full': 'The branch condition does not change while the loop runs. Unswitch the loop '
+                    '(test once, one loop per case) to keep the body branch-free and vectorizable.',
+        },
+        'LOOP003': {
+            'name': 'StridedInnerAccess',
+            'level': 'warning',
+            'short': 'Strided access in an innermost loop',
+            'full': 'The innermost loop steps through an array by more than one element per iteration, '
+                    'touching a new cache line each time. Interchange the loops or change the data layout '
+                    'so the induction variable indexes the contiguous dimension.',
+        },
+        'LOOP004': {
+            'name': 'IOInLoop',
+            'level': 'warning',
+            'short': 'I/O inside a loop',
+            'full': 'The loop performs I/O on every iteration. Buffer the data and write it after the loop, '
+                    'or read it in bulk before the loop.',
+        },
+    }
+
+    ALLOCATION_FUNCTIONS = {
+        'malloc', 'calloc', 'realloc', 'free', 'aligned_alloc', 'posix_memalign',
+        'strdup', 'strndup', 'make_unique', 'make_shared',
+    }
+
+    IO_FUNCTIONS = {
+        'printf', 'fprintf', 'vprintf', 'vfprintf', 'puts', 'fputs', 'putchar', 'fputc', 'putc',
+        'fwrite', 'fread', 'fgets', 'fgetc', 'getc', 'getchar', 'scanf', 'fscanf', 'fopen',
+        'fclose', 'fflush', 'perror', 'getline', 'read', 'write', 'open', 'close',
+    }
+
+    # Local objects of these types allocate when constructed and free when destroyed
+    CONTAINER_TYPE = re.compile(
+        r'^(const )?std::(__\w+::)?(vector|basic_string|deque|list|forward_list|map|multimap|set|multiset|'
+        r'unordered_map|unordered_multimap|unordered_set|unordered_multiset)<')
+
+    STREAM_TYPE = re.compile(r'std::(__\w+::)?basic_(i|o|io|if|of|f|istring|ostring|string)?stream<')
+
+    # Literal strides below this many elements still reuse most of each cache line
+    MIN_LITERAL_STRIDE = 4
+
+    def __init__(self, ast_parser: ASTParser, rules: Optional[List[str]] = None):
+        """Initialize the detector; rules limits the checks to the given rule IDs."""
+        super().__init__(ast_parser)
+        self.rules = set(rules or self.RULES)
+
+    def find(self, loop: Cursor, invariance: bool = True) -> List[Dict[str, Any]]:
+        """Return the findings whose construct sits in the loop's own body."""
+        findings: List[Dict[str, Any]] = []
+        body = self._body(loop)
+        if body is None:
+            return findings
+
+        own = list(self._own_nodes(body))
+        if 'LOOP001' in self.rules:
+            if loop.kind == CursorKind.CXX_FOR_RANGE_STMT:
+                # `for (std::string s : names)` copies each element into the loop variable
+                own += [child for child in loop.get_children() if child.kind == CursorKind.VAR_DECL]
+            self._find_allocations(own, findings)
+        if 'LOOP002' in self.rules and invariance:
+            self._find_invariant_branches(loop, own, findings)
+        if 'LOOP003' in self.rules:
+            self._find_strided_accesses(loop, own, findings)
+        if 'LOOP004' in self.rules:
+            self._find_io(own, findings)
+
+        findings.sort(key=lambda finding: (finding['location']['start_line'], finding['location']['start_column'],
+                                           finding['rule_id']))
+        return findings
+
+    def _find_allocations(self, nodes: List[Cursor], findings: List[Dict[str, Any]]) -> None:
+        """new/delete, malloc-family calls and containers constructed per iteration."""
+        for node in nodes:
+            if node.kind == CursorKind.CXX_NEW_EXPR:
+                self._add(findings, 'LOOP001', node, f"new {node.type.get_pointee().spelling} on every iteration")
+            elif node.kind == CursorKind.CXX_DELETE_EXPR:
+                self._add(findings, 'LOOP001', node, "delete on every iteration")
+            elif node.kind == CursorKind.CALL_EXPR and node.spelling in self.ALLOCATION_FUNCTIONS \
+                    and self._is_library_function(node):
+                self._add(findings, 'LOOP001', node, f"{node.spelling}() on every iteration")
+            elif node.kind == CursorKind.VAR_DECL and node.storage_class != StorageClass.STATIC \
+                    and node.type.get_canonical().kind not in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE} \
+                    and self.CONTAINER_TYPE.match(node.type.get_canonical().spelling):
+                self._add(findings, 'LOOP001', node,
+                          f"{node.type.spelling} {node.spelling} is constructed and destroyed on every iteration")
+
+    def _find_io(self, nodes: List[Cursor], findings: List[Dict[str, Any]]) -> None:
+        """C stdio/POSIX calls and stream operations; one finding per statement."""
+        reported: List[Tuple[int, int]] = []
+        for node in nodes:
+            if node.kind != CursorKind.CALL_EXPR:
+                continue
+            start, end = node.extent.start.offset, node.extent.end.offset
+            if any(outer_start <= start and end <= outer_end for outer_start, outer_end in reported):
+                continue
+
+            if self._is_stream_call(node) or (node.spelling in self.IO_FUNCTIONS and self._is_library_function(node)):
+                reported.append((start, end))
+                name = 'stream I/O' if node.spelling.startswith('operator') else f"{node.spelling}()"
+                self._add(findings, 'LOOP004', node, f"{name} on every iteration")
+
+    def _find_invariant_branches(self, loop: Cursor, nodes: List[Cursor], findings: List[Dict[str, Any]]) -> None:
+        """if statements whose condition reads only variables the loop never modifies."""
+        branches = [node for node in nodes if node.kind == CursorKind.IF_STMT]
+        if not branches:
+            return
+
+        effects = self._loop_effects(loop)
+        for branch in branches:
+            children = list(branch.get_children())
+            if not children or children[0].kind in {CursorKind.DECL_STMT, CursorKind.VAR_DECL}:
+                continue
+            condition = children[0]
+            variables = self._invariant_reads(condition, effects)
+            if variables:
+                text = ' '.join(self.ast_parser.get_source_text(condition).split())
+                self._add(findings, 'LOOP002', condition,
+                          f"condition ({text}) only reads {', '.join(variables)}, which the loop does not modify")
+
+    def _find_strided_accesses(self, loop: Cursor, nodes: List[Cursor], findings: List[Dict[str, Any]]) -> None:
+        """Innermost subscripts that move by a row or a large step per iteration."""
+        if any(node.kind in self.LOOP_KINDS for node in self._body(loop).walk_preorder()):
+            return
+        header = self._canonical_header(loop)
+        if isinstance(header, str):
+            return
+        iv = header['iv']
+        step = self._step(loop)
+
+        seen: Set[str] = set()
+        subscripts: Set[int] = set()
+        for node in nodes:
+            # Only the outermost subscript of a[i][j] is decomposed; a[idx[i]] still visits idx[i]
+            if node.kind not in {CursorKind.ARRAY_SUBSCRIPT_EXPR, CursorKind.CALL_EXPR} or \
+                    node.extent.start.offset in subscripts:
+                continue
+            access = self._access(node)
+            if access is None or not access['indices']:
+                continue
+            base = self._strip(node)
+            while self._subscript(base) is not None:
+                subscripts.add(base.extent.start.offset)
+                base = self._strip(self._subscript(base)[0])
+
+            indices = access['indices']
+            reason = None
+            if not self._uses(indices[-1], iv) and any(self._uses(index, iv) for index in indices[:-1]):
+                reason = f"{iv.spelling} indexes a leading dimension"
+            elif self._uses(indices[-1], iv):
+                stride = self._coefficient(indices[-1], iv)
+                if stride is None and step is not None:
+                    stride = step
+                if stride is not None:
+                    reason = f"{iv.spelling} moves the index by {stride}"
+
+            if reason and access['text'] not in seen:
+                seen.add(access['text'])
+                self._add(findings, 'LOOP003', node, f"{access['text']}: {reason} per iteration")
+
+    def _loop_effects(self, loop: Cursor) -> Dict[str, Any]:
+        """Declarations the whole loop (header, body and nested loops) may modify."""
+        effects = {'written': set(), 'declared': set(), 'memory_writes': False, 'calls': False}
+        for node in loop.walk_preorder():
+            kind = node.kind
+            if kind == CursorKind.VAR_DECL:
+                effects['declared'].add(node.hash)
+            elif kind in {CursorKind.BINARY_OPERATOR, CursorKind.COMPOUND_ASSIGNMENT_OPERATOR} and \
+                    (kind == CursorKind.COMPOUND_ASSIGNMENT_OPERATOR or self.operator(node) == '='):
+                self._record_write(list(node.get_children())[0], effects)
+            elif kind == CursorKind.UNARY_OPERATOR and self.operator(node) in {'++', '--', '&'}:
+                self._record_write(list(node.get_children())[0], effects)
+            elif kind == CursorKind.CALL_EXPR and not self._is_pure_call(node):
+                # Arguments and the object may be taken by reference
+                effects['calls'] = True
+                for child in node.walk_preorder():
+                    if child.kind == CursorKind.DECL_REF_EXPR and child.referenced is not None:
+                        effects['written'].add(child.referenced.hash)
+            elif kind in {CursorKind.CXX_DELETE_EXPR, CursorKind.ASM_STMT}:
+                effects['calls'] = True
+        return effects
+
+    def _record_write(self, target: Cursor, effects: Dict[str, Any]) -> None:
+        """Mark the root variable of an assignment target; writes through memory are tracked separately."""
+        target = self._strip(target)
+        access = self._access(target)
+        if access is None:
+            effects['memory_writes'] = True
+            for child in target.walk_preorder():
+                if child.kind == CursorKind.DECL_REF_EXPR and child.referenced is not None:
+                    effects['written'].add(child.referenced.hash)
+            return
+        effects['written'].add(access['root'].hash)
+        if access['indices'] or '.' in access['key'] or access['root'].kind == CursorKind.FIELD_DECL:
+            effects['memory_writes'] = True
+
+    def _invariant_reads(self, condition: Cursor, effects: Dict[str, Any]) -> List[str]:
+        """Names read by an invariant condition, or an empty list if it may change."""
+        names: List[str] = []
+        reads_memory = False
+        for node in condition.walk_preorder():
+            kind = node.kind
+            if kind == CursorKind.CALL_EXPR:
+                if not self._is_pure_call(node):
+                    return []
+                if node.spelling in self.CONST_METHODS:
+                    reads_memory = True
+            elif kind in {CursorKind.ARRAY_SUBSCRIPT_EXPR, CursorKind.CXX_THIS_EXPR}:
+                reads_memory = True
+            elif kind == CursorKind.UNARY_OPERATOR and self.operator(node) == '*':
+                reads_memory = True
+            elif kind == CursorKind.MEMBER_REF_EXPR:
+                if node.referenced is not None and node.referenced.hash in effects['written']:
+                    return []
+                children = list(node.get_children())
+                if not children or self._is_pointer_expression(children[0]):
+                    # this->field or p->field: another alias may change it
+                    reads_memory = True
+                implicit = not children or self._strip(children[0]).kind == CursorKind.CXX_THIS_EXPR
+                if implicit and node.spelling not in names:
+                    names.append(node.spelling)
+            elif kind == CursorKind.DECL_REF_EXPR:
+                decl = node.referenced
+                if decl is None or decl.kind not in {CursorKind.VAR_DECL, CursorKind.PARM_DECL}:
+                    continue
+                if decl.hash in effects['written'] or decl.hash in effects['declared']:
+                    return []
+                if not self._is_function_local(decl) and effects['calls']:
+                    return []
+                if self._is_mutable_reference(decl) and effects['calls']:
+                    return []
+                if decl.spelling not in names:
+                    names.append(decl.spelling)
+            elif kind in {CursorKind.CXX_NEW_EXPR, CursorKind.LAMBDA_EXPR}:
+                return []
+
+        if reads_memory and (effects['memory_writes'] or effects['calls']):
+            return []
+        return names
+
+    def _is_pure_call(self, node: Cursor) -> bool:
+        """Math functions and const container queries cannot modify their arguments."""
+        callee = node.referenced
+        if callee is None:
+            return False
+        if callee.kind == CursorKind.CXX_METHOD and node.spelling in self.CONST_METHODS:
+            return True
+        return callee.kind == CursorKind.FUNCTION_DECL and node.spelling in self.PURE_FUNCTIONS
+
+    def _is_library_function(self, node: Cursor) -> bool:
+        """The callee is a free function declared outside the analyzed file, or unresolved."""
+        callee = node.referenced
+        if callee is None:
+            return True
+        if callee.kind not in {CursorKind.FUNCTION_DECL, CursorKind.FUNCTION_TEMPLATE}:
+            return False
+        if callee.location.file is None or node.location.file is None:
+            return True
+        return callee.location.file.name != node.location.file.name
+
+    def _is_stream_call(self, node: Cursor) -> bool:
+        """`os << x`, `is >> x` and stream methods such as write/read/getline/flush."""
+        callee = node.referenced
+        if callee is None:
+            return False
+        if node.spelling in {'operator<<', 'operator>>'}:
+            return bool(self.STREAM_TYPE.search(node.type.get_canonical().spelling))
+        if callee.kind == CursorKind.CXX_METHOD:
+            parent = callee.semantic_parent
+            return parent is not None and bool(self.STREAM_TYPE.search(parent.type.get_canonical().spelling))
+        return False
+
+    def _is_function_local(self, decl: Cursor) -> bool:
+        """Parameters and non-static locals; globals and statics may change inside calls."""
+        if decl.kind == CursorKind.PARM_DECL:
+            return True
+        if decl.storage_class == StorageClass.STATIC:
+            return False
+        parent = decl.semantic_parent
+        return parent is not None and parent.kind not in {
+            CursorKind.TRANSLATION_UNIT, CursorKind.NAMESPACE, CursorKind.CLASS_DECL, CursorKind.STRUCT_DECL,
+        }
+
+    def _is_mutable_reference(self, decl: Cursor) -> bool:
+        """Non-const references may alias objects that called functions modify."""
+        type_obj = decl.type.get_canonical()
+        if type_obj.kind not in {TypeKind.LVALUEREFERENCE, TypeKind.RVALUEREFERENCE}:
+            return False
+        return not type_obj.get_pointee().is_const_qualified()
+
+    def _is_pointer_expression(self, cursor: Cursor) -> bool:
+        """Member access through a pointer (`p->field`)."""
+        return self._strip(cursor).type.get_canonical().kind == TypeKind.POINTER
+
+    def _uses(self, expression: Cursor, decl: Cursor) -> bool:
+        """Whether an expression references decl."""
+        return any(node.kind == CursorKind.DECL_REF_EXPR and node.referenced == decl
+                   for node in expression.walk_preorder())
+
+    def _coefficient(self, index: Cursor, iv: Cursor) -> Optional[str]:
+        """Spelling of a stride multiplying iv in a flattened index (`i * n + j` -> `n`), if large."""
+        for node in index.walk_preorder():
+            if node.kind != CursorKind.BINARY_OPERATOR or self.operator(node) != '*':
+                continue
+            operands = list(node.get_children())
+            if len(operands) != 2:
+                continue
+            for own, other in (operands, operands[::-1]):
+                if self._uses(own, iv) and not self._uses(other, iv):
+                    value = self._literal(other)
+                    if value is None:
+                        return ' '.join(self.ast_parser.get_source_text(other).split())
+                    if abs(value) >= self.MIN_LITERAL_STRIDE:
+                        return str(value)
+        return None
+
+    def _step(self, loop: Cursor) -> Optional[str]:
+        """Spelling of a non-unit `iv += step` increment, if large."""
+        children = list(loop.get_children())
+        increment = self._strip(children[2])
+        if increment.kind != CursorKind.COMPOUND_ASSIGNMENT_OPERATOR:
+            return None
+        step = list(increment.get_children())[1]
+        value = self._literal(step)
+        if value is None:
+            return ' '.join(self.ast_parser.get_source_text(step).split())
+        return str(value) if abs(value) >= self.MIN_LITERAL_STRIDE else None
+
+    def _body(self, loop: Cursor) -> Optional[Cursor]:
+        """Loop body; do-while loops put it first."""
+        children = list(loop.get_children())
+        if not children:
+            return None
+        return children[0] if loop.kind == CursorKind.DO_STMT else children[-1]
+
+    def _own_nodes(self, cursor: Cursor):
+        """Preorder walk that stops at nested loops and lambdas."""
+        yield cursor
+        for child in cursor.get_children():
+            if child.kind in self.LOOP_KINDS or child.kind == CursorKind.LAMBDA_EXPR:
+                continue
+            yield from self._own_nodes(child)
+
+    def _add(self, findings: List[Dict[str, Any]], rule_id: str, node: Cursor, message: str) -> None:
+        """Record a finding at the node's extent, in the analyzer's location format."""
+        extent = node.extent
+        findings.append({
+            'rule_id': rule_id,
+            'message': message,
+            'location': {
+                'start_line': extent.start.line,
+                'end_line': extent.end.line,
+                'start_column': extent.start.column,
+                'end_column': extent.end.column,
+            },
+        })
+
+
+class PerformanceLinter:
+    """Runs the finding detector over every analyzed file and annotates the loop records."""
+
+    def __init__(self, config: Config, rules: Optional[List[str]] = None):
+        """Initialize the linter with configuration."""
+        unknown = set(rules or []) - set(LoopFindingDetector.RULES)
+        if unknown:
+            raise ValueError(f"Unknown rules: {', '.join(sorted(unknown))}")
+        self.config = config
+        self.logger = logging.getLogger(__name__)
+        self.ast_parser = ASTParser(config)
+        self.detector = LoopFindingDetector(self.ast_parser, rules)
+
+    def lint_tree(self, analysis_results: Dict[str, Any]) -> Dict[str, Any]:
+        """Attach `extensions.findings` to every loop record; returns a run summary."""
+        findings: Dict[Tuple[str, int, int], List[Dict[str, Any]]] = {}
+        files_skipped = 0
+        for file_path in analysis_results:
+            file_findings = self.lint_file(Path(file_path))
+            if file_findings is None:
+                files_skipped += 1
+                continue
+            for (line, column), loop_findings in file_findings.items():
+                findings[(file_path, line, column)] = loop_findings
+
+        counts = {rule_id: 0 for rule_id in sorted(self.detector.rules)}
+        seen = set()
+        for file_path, _, loop in LoopIndex(analysis_results).iter_loops():
+            location = loop.get('location', {})
+            key = (file_path, location.get('start_line', 0), location.get('start_column', 0))
+            if key not in findings:
+                continue
+            loop.setdefault('extensions', {})['findings'] = findings[key]
+            if key not in seen:
+                # Nested loops may be reported twice; count them once
+                seen.add(key)
+                for finding in findings[key]:
+                    counts[finding['rule_id']] += 1
+
+        total = sum(counts.values())
+        self.logger.info(f"Found {total} performance findings in {len(analysis_results) - files_skipped} files")
+        return {
+            'rules': sorted(self.detector.rules),
+            'files_skipped': files_skipped,
+            'findings': total,
+            'by_rule': counts,
+        }
+
+    def lint_file(self, source_file: Path) -> Optional[Dict[Tuple[int, int], List[Dict[str, Any]]]]:
+        """Findings of one file by loop (line, column), or None if it cannot be parsed."""
+        translation_unit = self.ast_parser.parse_file(source_file)
+        if translation_unit is None:
+            self.logger.warning(f"Failed to parse {source_file}; no findings reported")
+            return None
+
+        # Unresolved calls would hide writes from the invariance check; the other rules are syntactic
+        invariance = not any(diagnostic.severity >= Diagnostic.Error for diagnostic in translation_unit.diagnostics)
+        if not invariance:
+            self.logger.warning(f"Parse errors in {source_file}; skipping loop-invariant branch checks")
+
+        findings: Dict[Tuple[int, int], List[Dict[str, Any]]] = {}
+        for declaration in translation_unit.cursor.get_children():
+            if not self.ast_parser.is_in_file(declaration, source_file):
+                continue
+            for cursor in declaration.walk_preorder():
+                if cursor.kind in ParallelLoopAnalyzer.LOOP_KINDS:
+                    findings[(cursor.extent.start.line, cursor.extent.start.column)] = \
+                        self.detector.find(cursor, invariance)
+        return findings
+
+
+@register_pass
+class FindingsPass(AnalysisPass):
+    """Runs the finding detector on every loop during the analysis (`--passes ...,findings`)."""
+
+    name = 'findings'
+    description = 'Performance findings (heap allocation, invariant branches, strided accesses, I/O)'
+    extension_keys = ('findings',)
+
+    def __init__(self, config: Config, ast_parser: ASTParser):
+        """Initialize the pass with its detector."""
+        super().__init__(config, ast_parser)
+        self.detector = LoopFindingDetector(ast_parser)
+        self.invariance = True
+
+    def begin_file(self, translation_unit: TranslationUnit, file_path: Path, file_analysis: Dict[str, Any]) -> None:
+        """Unresolved calls would hide writes from the invariance check, as in PerformanceLinter."""
+        self.invariance = not any(diagnostic.severity >= Diagnostic.Error
+                                  for diagnostic in translation_unit.diagnostics)
+
+    def end_loop(self, cursor: Cursor, loop_info: Dict[str, Any]) -> None:
+        """Attach the loop's findings."""
+        self.extensions(loop_info)['findings'] = self.detector.find(cursor, self.invariance)
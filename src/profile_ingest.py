@@ -0,0 +1,263 @@
+"""
+Profile ingestion module for joining profiler samples onto extracted loops.
+
+Supported inputs are local profiler outputs:
+  - `perf script` text (source lines require `perf script -F +srcline`)
+  - gprof line-level flat profiles (`gprof -l`)
+  - callgrind `.out` files
+"""
+
+import logging
+import re
+from collections import Counter
+from pathlib import Path
+from typing import Dict, Any, Tuple
+
+from .loop_index import LoopIndex
+
+
+# (file, line) pair as reported by a profiler
+SourceLine = Tuple[str, int]
+
+
+class ProfileData:
+    """Line-level costs parsed from a profiler output."""
+
+    def __init__(self, source: str, metric: str):
+        self.source = source
+        self.metric = metric
+        # Cost spent directly on a line
+        self.self_cost: Counter = Counter()
+        # Cost attributed to a set of active lines (one call stack or call site)
+        self.inclusive_cost: Counter = Counter()
+
+    @property
+    def total(self) -> float:
+        return sum(self.self_cost.values())
+
+
+class ProfileIngest:
+    """Parses profiler outputs and annotates loop records with measured hotness."""
+
+    FORMATS = ('perf', 'gprof', 'callgrind')
+
+    # `perf script -F +srcline` emits "  /path/file.cc:123" after each frame
+    PERF_SRCLINE = re.compile(r'^\s+(\S*[./]\S*):(\d+)\s*$')
+    # `gprof -l` names look like "main (simple.cpp:7 @ 401136)"
+    GPROF_LINE = re.compile(
+        r'^\s*[\d.]+\s+[\d.]+\s+([\d.]+)\s+.*\(([^()]+):(\d+) @ [0-9a-fA-Fx]+\)\s*$'
+    )
+    CALLGRIND_NAME = re.compile(r'^\((\d+)\)(?:\s+(.*))?$')
+
+    def __init__(self):
+        self.logger = logging.getLogger(__name__)
+
+    def detect_format(self, profile_path: Path) -> str:
+        """Guess the profiler format from the file name and its first lines."""
+        if profile_path.name.startswith('callgrind.out'):
+            return 'callgrind'
+
+        with open(profile_path, 'r', encoding='utf-8', errors='ignore') as f:
+            head = [f.readline() for _ in range(50)]
+
+        for line in head:
+            if line.startswith('events:') or line.startswith('# callgrind format'):
+                return 'callgrind'
+            if 'Flat profile' in line or 'Call graph (explanation follows)' in line:
+                return 'gprof'
+        return 'perf'
+
+    def parse(self, profile_path: Path, profile_format: str = 'auto') -> ProfileData:
+        """Parse a profiler output file into line-level costs."""
+        if profile_format == 'auto':
+            profile_format = self.detect_format(profile_path)
+            self.logger.info(f"Detected {profile_format} profile format for {profile_path}")
+
+        parsers = {
+            'perf': self._parse_perf,
+            'gprof': self._parse_gprof,
+            'callgrind': self._parse_callgrind,
+        }
+        if profile_format not in parsers:
+            raise ValueError(f"Unsupported profile format: {profile_format}")
+
+        with open(profile_path, 'r', encoding='utf-8', errors='ignore') as f:
+            profile = parsers[profile_format](f)
+
+        if not profile.self_cost:
+            self.logger.warning(f"No source line information found in {profile_path}")
+        return profile
+
+    def _parse_perf(self, lines) -> ProfileData:
+        """Parse `perf script` text; each sample block is one sample."""
+        profile = ProfileData('perf', 'samples')
+        stack = []
+
+        def flush():
+            if stack:
+                profile.self_cost[stack[0]] += 1
+                profile.inclusive_cost[tuple(dict.fromkeys(stack))] += 1
+                stack.clear()
+
+        for line in lines:
+            if not line.strip() or not line[0].isspace():
+                # Blank line or a new sample header ends the previous sample
+                flush()
+                continue
+
+            match = self.PERF_SRCLINE.match(line)
+            if match and match.group(1) != '??':
+                stack.append((match.group(1), int(match.group(2))))
+        flush()
+
+        return profile
+
+    def _parse_gprof(self, lines) -> ProfileData:
+        """Parse the flat section of a line-level gprof report."""
+        profile = ProfileData('gprof', 'seconds')
+        saw_function_rows = False
+
+        for line in lines:
+            if 'Call graph' in line:
+                # Only the flat profile carries self time per line
+                break
+
+            match = self.GPROF_LINE.match(line)
+            if match:
+                key = (match.group(2), int(match.group(3)))
+                seconds = float(match.group(1))
+                profile.self_cost[key] += seconds
+                profile.inclusive_cost[(key,)] += seconds
+            elif re.match(r'^\s*[\d.]+\s+[\d.]+\s+[\d.]+\s+\S', line):
+                saw_function_rows = True
+
+        if saw_function_rows and not profile.self_cost:
+            self.logger.warning("gprof output has no line information; rerun gprof with -l")
+        return profile
+
+    def _parse_callgrind(self, lines) -> ProfileData:
+        """Parse a callgrind output file using the first recorded event."""
+        profile = ProfileData('callgrind', 'events')
+        file_names: Dict[str, str] = {}
+        positions = ['line']
+        last_position = [0]
+        current_file = ''
+        function_file = ''
+        pending_call = False
+
+        def resolve_name(value: str) -> str:
+            # Name compression: "(id) name" defines an id, "(id)" reuses it
+            match = self.CALLGRIND_NAME.match(value.strip())
+            if not match:
+                return value.strip()
+            if match.group(2):
+                file_names[match.group(1)] = match.group(2).strip()
+            return file_names.get(match.group(1), '')
+
+        for raw_line in lines:
+            line = raw_line.strip()
+            if not line or line.startswith('#'):
+                continue
+
+            if line.startswith('events:'):
+                events = line.split(':', 1)[1].split()
+                profile.metric = events[0] if events else 'events'
+                continue
+            if line.startswith('positions:'):
+                positions = line.split(':', 1)[1].split()
+                last_position = [0] * len(positions)
+                continue
+
+            if '=' in line and not line[0].isdigit() and line[0] not in '+-*':
+                key, value = line.split('=', 1)
+                if key == 'fl':
+                    function_file = current_file = resolve_name(value)
+                elif key in ('fi', 'fe'):
+                    current_file = resolve_name(value)
+                elif key == 'fn':
+                    current_file = function_file
+                elif key in ('cfi', 'cfl'):
+                    resolve_name(value)
+                elif key == 'calls':
+                    pending_call = True
+                continue
+
+            if ':' in line.split()[0]:
+                # Header lines such as "summary:" or "totals:"
+                continue
+
+            fields = line.split()
+            if len(fields) < len(positions):
+                continue
+
+            for i, token in enumerate(fields[:len(positions)]):
+                if token == '*':
+                    continue
+                if token[0] in '+-':
+                    last_position[i] += int(token, 0)
+                else:
+                    last_position[i] = int(token, 0)
+
+            costs = fields[len(positions):]
+            cost = int(costs[0]) if costs else 0
+            line_number = last_position[positions.index('line')] if 'line' in positions else 0
+            key = (current_file, line_number)
+
+            if pending_call:
+                # Cost line after calls= is the inclusive cost of the callee
+                profile.inclusive_cost[(key,)] += cost
+                pending_call = False
+            else:
+                profile.self_cost[key] += cost
+                profile.inclusive_cost[(key,)] += cost
+
+        return profile
+
+    def annotate(self, analysis_results: Dict[str, Any], profile: ProfileData) -> Dict[str, Any]:
+        """Attach measured hotness to every loop record; returns a run summary."""
+        index = LoopIndex(analysis_results)
+        inclusive: Dict[int, float] = Counter()
+        self_cost: Dict[int, float] = Counter()
+        matched = 0.0
+
+        for (file_name, line), cost in profile.self_cost.items():
+            loops = index.innermost_at(file_name, line)
+            for loop in loops:
+                self_cost[id(loop)] += cost
+            if loops:
+                matched += cost
+
+        for stack, cost in profile.inclusive_cost.items():
+            # A loop is charged once per stack even if several frames fall inside it
+            seen = {}
+            for file_name, line in stack:
+                for loop in index.loops_at(file_name, line):
+                    seen[id(loop)] = loop
+            for loop_key in seen:
+                inclusive[loop_key] += cost
+
+        total = profile.total
+        annotated = 0
+        for _, _, loop in index.iter_loops():
+            loop_inclusive = inclusive.get(id(loop), 0)
+            loop.setdefault('extensions', {})['profile'] = {
+                'source': profile.source,
+                'metric': profile.metric,
+                'inclusive': loop_inclusive,
+                'self': self_cost.get(id(loop), 0),
+                'inclusive_fraction': round(loop_inclusive / total, 6) if total else 0.0,
+                'sampled': loop_inclusive > 0,
+            }
+            annotated += 1
+
+        summary = {
+            'source': profile.source,
+            'metric': profile.metric,
+            'total': total,
+            'matched_to_loops': matched,
+            'loops_annotated': annotated,
+            'loops_sampled': sum(1 for key in inclusive if inclusive[key] > 0),
+        }
+        self.logger.info(f"Annotated {annotated} loops from {profile.source} profile "
+                         f"({summary['loops_sampled']} sampled)")
+        return summary
@@ -0,0 +1,446 @@
+"""
+Resident query server.
+
+Loading a multi-hundred-MB analysis file dominates every short query an
+editor plugin or script makes. The server loads it once, indexes it, keeps
+a clang index warm for re-analysis and answers JSON-RPC 2.0 requests over a
+Unix domain socket: one JSON object per line in each direction. Requests are
+handled one at a time under a lock; connections stay open across requests.
+"""
+
+import inspect
+import json
+import logging
+import os
+import socket
+import socketserver
+import threading
+import time
+import typing
+from datetime import datetime
+from pathlib import Path
+from typing import Dict, List, Any, Optional, Tuple
+
+from .config import Config
+from .analysis_passes import PASS_REGISTRY
+from .ast_parser import ASTParser
+from .loop_analyzer import LoopAnalyzer
+from .loop_index import LoopIndex
+from .loop_cost import LoopCostModel
+from .incremental_output import IncrementalOutput
+from .json_output import JSONOutput
+
+
+class QueryError(Exception):
+    """A request that cannot be answered, reported as a JSON-RPC error."""
+
+    INVALID_PARAMS = -32602
+    NOT_FOUND = -32001
+
+    def __init__(self, code: int, message: str):
+        """Initialize with a JSON-RPC error code."""
+        super().__init__(message)
+        self.code = code
+
+
+class QueryServer:
+    """Answers loop queries about one analysis held in memory."""
+
+    # JSON-RPC 2.0 protocol errors
+    PARSE_ERROR = -32700
+    INVALID_REQUEST = -32600
+    METHOD_NOT_FOUND = -32601
+    INTERNAL_ERROR = -32603
+
+    # Integer params that must be at least 1
+    POSITIVE_PARAMS = {'line', 'start_line', 'end_line', 'limit'}
+
+    def __init__(self, config: Config, analysis_data: Dict[str, Any], analysis_path: Path,
+                 default_iterations: int = 100):
+        """Index an analysis; config (from its metadata) is used to re-analyze files."""
+        self.config = config
+        self.analysis_path = analysis_path
+        self.logger = logging.getLogger(__name__)
+        self.started = time.time()
+        self.requests = 0
+        self.shutdown_requested = False
+        self.lock = threading.Lock()
+        self.cost_model = LoopCostModel(default_iterations)
+
+        # Re-analysis runs the passes that produced the file
+        config.passes = [name for name in analysis_data.get('metadata', {}).get('passes', {})
+                         if name in PASS_REGISTRY] or None
+
+        # Summary and call graph stay consistent when files are re-analyzed
+        self.output = IncrementalOutput(config, analysis_data.get('source_files', {}),
+                                        datetime.fromtimestamp(self.started))
+        for key in ('metadata', 'extensions'):
+            if key in analysis_data:
+                self.output.output_data[key] = analysis_data[key]
+        self.source_files = self.output.source_files
+        self.index = LoopIndex(self.source_files)
+        self._weights: Optional[List[Dict[str, Any]]] = None
+
+        # Created on the first re-analysis, then kept warm
+        self.ast_parser = None
+        self.loop_analyzer = None
+
+        self.methods = {
+            'ping': self.ping,
+            'summary': self.summary,
+            'loops_in_range': self.loops_in_range,
+            'loops_at': self.loops_at,
+            'function': self.function,
+            'call_graph': self.call_graph,
+            'hottest_loops': self.hottest_loops,
+            'reanalyze': self.reanalyze,
+            'save': self.save,
+            'shutdown': self.shutdown,
+        }
+
+    def handle(self, line: str) -> Optional[str]:
+        """Answer one request line; None for notifications, which get no response."""
+        try:
+            request = json.loads(line)
+        except json.JSONDecodeError as e:
+            return self._error(None, self.PARSE_ERROR, f"Parse error: {e}")
+        if not isinstance(request, dict) or not isinstance(request.get('method'), str):
+            return self._error(request.get('id') if isinstance(request, dict) else None,
+                               self.INVALID_REQUEST, "Invalid request")
+
+        request_id = request.get('id')
+        method = self.methods.get(request['method'])
+        params = request.get('params', {})
+        if method is None:
+            response = self._error(request_id, self.METHOD_NOT_FOUND, f"Method not found: {request['method']}")
+        elif not isinstance(params, dict):
+            response = self._error(request_id, QueryError.INVALID_PARAMS, "params must be an object")
+        elif not self._accepts(method, params):
+            response = self._error(request_id, QueryError.INVALID_PARAMS,
+                                   f"Invalid params for {request['method']}{inspect.signature(method)}")
+        else:
+            started = time.perf_counter()
+            try:
+                params = self._coerce(method, params)
+                with self.lock:
+                    self.requests += 1
+                    result = method(**params)
+                response = json.dumps({'jsonrpc': '2.0', 'id': request_id, 'result': result})
+            except QueryError as e:
+                response = self._error(request_id, e.code, str(e))
+            except Exception as e:
+                self.logger.debug("Request failed:", exc_info=True)
+                response = self._error(request_id, self.INTERNAL_ERROR, str(e))
+            self.logger.debug(f"{request['method']} answered in {(time.perf_counter() - started) * 1000:.1f} ms")
+        return None if 'id' not in request else response
+
+    def _accepts(self, method, params: Dict[str, Any]) -> bool:
+        """Whether params name the method's arguments."""
+        try:
+            inspect.signature(method).bind(**params)
+            return True
+        except TypeError:
+            return False
+
+    def _coerce(self, method, params: Dict[str, Any]) -> Dict[str, Any]:
+        """Params converted to the method's annotated types; QueryError (invalid params) if they do not fit."""
+        hints = typing.get_type_hints(method)
+        coerced = {}
+        for name, value in params.items():
+            expected = hints.get(name, Any)
+            optional = type(None) in typing.get_args(expected)
+            if optional:
+                expected = next(arg for arg in typing.get_args(expected) if arg is not type(None))
+            if value is None and optional:
+                coerced[name] = None
+                continue
+            coerced[name] = self._convert(name, value, expected)
+        return coerced
+
+    def _convert(self, name: str, value: Any, expected: Any) -> Any:
+        """One param as expected (int, bool or str); numeric and boolean strings are accepted."""
+        if expected is int:
+            if isinstance(value, str) and value.strip().lstrip('-').isdigit():
+                value = int(value)
+            if not isinstance(value, int) or isinstance(value, bool):
+                raise QueryError(QueryError.INVALID_PARAMS, f"{name} must be an integer, got {json.dumps(value)}")
+            if name in self.POSITIVE_PARAMS and value < 1:
+                raise QueryError(QueryError.INVALID_PARAMS, f"{name} must be at least 1, got {value}")
+        elif expected is bool:
+            if isinstance(value, str) and value.lower() in ('true', 'false'):
+                value = value.lower() == 'true'
+            if not isinstance(value, bool):
+                raise QueryError(QueryError.INVALID_PARAMS, f"{name} must be true or false, got {json.dumps(value)}")
+        elif expected is str and not isinstance(value, str):
+            raise QueryError(QueryError.INVALID_PARAMS, f"{name} must be a string, got {json.dumps(value)}")
+        return value
+
+    def _error(self, request_id: Any, code: int, message: str) -> str:
+        """JSON-RPC error response line."""
+        return json.dumps({'jsonrpc': '2.0', 'id': request_id, 'error': {'code': code, 'message': message}})
+
+    # Methods
+
+    def ping(self) -> Dict[str, Any]:
+        """Server status."""
+        return {
+            'analysis': str(self.analysis_path),
+            'uptime_seconds': round(time.time() - self.started, 3),
+            'requests': self.requests,
+            'files': len(self.source_files),
+            'loops': self.output.total_loops,
+        }
+
+    def summary(self) -> Dict[str, Any]:
+        """Analysis summary and totals."""
+        metadata = self.output.output_data['metadata']
+        return {
+            'scan_path': metadata.get('scan_path'),
+            'total_files_scanned': len(self.source_files),
+            'total_loops_found': self.output.total_loops,
+            'analysis_summary': self.output.output_data['analysis_summary'],
+        }
+
+    def loops_in_range(self, file: str, start_line: int, end_line: Optional[int] = None,
+                       full: bool = False) -> List[Dict[str, Any]]:
+        """Loops overlapping lines start_line..end_line of a file (nested loops listed separately)."""
+        file_key = self._file(file)
+        end_line = start_line if end_line is None else end_line
+        # Nested loops can be recorded at function level as well as under their parent
+        unique = {}
+        for function_name, loop in self.index.loops_in_range(file_key, start_line, end_line):
+            unique.setdefault(loop.get('loop_id'), (function_name, loop))
+        return [self._loop_result(file_key, function_name, loop, full) for function_name, loop in unique.values()]
+
+    def loops_at(self, file: str, line: int, full: bool = False) -> List[Dict[str, Any]]:
+        """Innermost loops enclosing a line."""
+        file_key = self._file(file)
+        functions = {id(loop): name for name, loop in self.index.loops_in_range(file_key, line, line)}
+        unique = {}
+        for loop in self.index.innermost_at(file_key, line):
+            unique.setdefault(loop.get('loop_id'), loop)
+        return [self._loop_result(file_key, functions.get(id(loop), ''), loop, full) for loop in unique.values()]
+
+    def function(self, name: str, full: bool = False) -> List[Dict[str, Any]]:
+        """Every function or method of that name (qualified or not) with its loops."""
+        matches = []
+        for file_path, function_name, loops in self.index.iter_functions():
+            if function_name and name in (function_name, function_name.split('::')[-1]):
+                matches.append({
+                    'file': file_path,
+                    'function': function_name,
+                    'loops': [self._loop_result(file_path, function_name, loop, full) for loop in loops],
+                })
+        if not matches:
+            raise QueryError(QueryError.NOT_FOUND, f"No function named {name}")
+        return matches
+
+    def call_graph(self, name: str) -> Dict[str, Any]:
+        """Call graph node of a function: calls, calls in loops and callers."""
+        node = self.output.call_graph.get(name)
+        if node is None:
+            candidates = [node_name for node_name in self.output.call_graph if node_name.split('::')[-1] == name]
+            if len(candidates) != 1:
+                raise QueryError(QueryError.NOT_FOUND, f"No unique call graph node for {name}: {candidates}")
+            name, node = candidates[0], self.output.call_graph[candidates[0]]
+        return dict(node, name=name)
+
+    def hottest_loops(self, limit: int = 10, calling: Optional[str] = None,
+                      file: Optional[str] = None) -> List[Dict[str, Any]]:
+        """Loops by descending weight, optionally only those calling a function or in one file.
+
+        The weight is the profiled inclusive cost when the analysis was annotated
+        with a profile, else body executions (measured or estimated) times body cost.
+        """
+        file_key = self._file(file) if file else None
+        hottest = []
+        for entry in self._loop_weights():
+            if file_key and entry['file'] != file_key:
+                continue
+            if calling and not any(self._same_function(call.get('function', ''), calling)
+                                   for call in entry['loop'].get('function_calls', [])):
+                continue
+            hottest.append(dict(self._loop_result(entry['file'], entry['function'], entry['loop'], False),
+                                weight=entry['weight'], weight_source=entry['source']))
+            if len(hottest) >= limit:
+                break
+        return hottest
+
+    def reanalyze(self, file: Optional[str] = None, function: Optional[str] = None) -> Dict[str, Any]:
+        """Re-parse a file (or the file defining a function) with the warm index and update the analysis."""
+        if function and not file:
+            files = sorted({match['file'] for match in self.function(function)})
+            if len(files) != 1:
+                raise QueryError(QueryError.INVALID_PARAMS, f"{function} is defined in {len(files)} files; pass file")
+            file = files[0]
+        if not file:
+            raise QueryError(QueryError.INVALID_PARAMS, "reanalyze needs file or function")
+        file_key = self._file(file)
+
+        if self.ast_parser is None:
+            self.ast_parser = ASTParser(self.config)
+            self.loop_analyzer = LoopAnalyzer(self.config, self.ast_parser)
+
+        started = time.perf_counter()
+        loops_before = self.output.total_loops
+        translation_unit = self.ast_parser.parse_file(Path(file_key))
+        if translation_unit is None:
+            raise QueryError(QueryError.NOT_FOUND, f"Failed to parse {file_key}")
+        try:
+            file_data = self.loop_analyzer.analyze_file(translation_unit, Path(file_key))
+        finally:
+            self.ast_parser.dispose(translation_unit)
+
+        self.output.update(file_key, file_data)
+        self.index.refresh_file(file_key)
+        self._weights = None
+        result = {
+            'file': file_key,
+            'seconds': round(time.perf_counter() - started, 3),
+            'loops': LoopAnalyzer.count_loops(file_data),
+            'total_loops_delta': self.output.total_loops - loops_before,
+        }
+        if function:
+            result['functions'] = [match for match in self.function(function) if match['file'] == file_key]
+        return result
+
+    def save(self, path: Optional[str] = None) -> Dict[str, Any]:
+        """Write the current analysis, including re-analyzed files (default: the loaded file)."""
+        output_path = path or str(self.analysis_path)
+        JSONOutput(self.config).write_output(self.output.output_data, output_path)
+        return {'path': output_path, 'files': len(self.source_files), 'loops': self.output.total_loops}
+
+    def shutdown(self) -> str:
+        """Stop the server after answering this request."""
+        self.shutdown_requested = True
+        return 'shutting down'
+
+    # Helpers
+
+    def _file(self, file: str) -> str:
+        """Analyzed file key for a path as an editor or profiler names it."""
+        file_key = self.index.resolve_file(file)
+        if file_key is None or file_key not in self.source_files:
+            raise QueryError(QueryError.NOT_FOUND, f"File not in the analysis: {file}")
+        return file_key
+
+    def _loop_result(self, file_path: str, function_name: str, loop: Dict[str, Any], full: bool) -> Dict[str, Any]:
+        """A loop record with its file and function; nested loops as ids unless full."""
+        if full:
+            record = dict(loop)
+        else:
+            record = {key: value for key, value in loop.items() if key != 'nested_loops'}
+            record['nested_loop_ids'] = [nested.get('loop_id') for nested in loop.get('nested_loops', [])]
+        return dict(record, file=file_path, function=function_name)
+
+    def _loop_weights(self) -> List[Dict[str, Any]]:
+        """Every loop with its weight, heaviest first; cached until a file is re-analyzed."""
+        if self._weights is not None:
+            return self._weights
+
+        profiled = any('profile' in loop.get('extensions', {}) for _, _, loop in self.index.iter_loops())
+        weights = []
+
+        def walk(file_path: str, function_name: str, loops: List[Dict[str, Any]], parent_executions: float) -> None:
+            for loop in loops:
+                executions = self.cost_model.executions(loop, parent_executions)
+                if profiled:
+                    weight, source = loop.get('extensions', {}).get('profile', {}).get('inclusive', 0), 'profile'
+                else:
+                    measured = self.cost_model.measured_iterations(loop) is not None
+                    weight = executions * self.cost_model.body_cost(loop)
+                    source = 'measured' if measured else 'static'
+                weights.append({'file': file_path, 'function': function_name, 'loop': loop,
+                                'weight': weight, 'source': source})
+                walk(file_path, function_name, loop.get('nested_loops', []), executions)
+
+        for file_path, function_name, loops in self.index.iter_functions():
+            walk(file_path, function_name, loops, 1.0)
+        weights.sort(key=lambda entry: -entry['weight'])
+        self._weights = weights
+        return weights
+
+    @staticmethod
+    def _same_function(called: str, name: str) -> bool:
+        """Whether a call-site name refers to a function, ignoring qualification on either side."""
+        return called == name or called.split('::')[-1] == name.split('::')[-1]
+
+
+class _RequestHandler(socketserver.StreamRequestHandler):
+    """One client connection: newline-delimited requests and responses."""
+
+    def handle(self) -> None:
+        """Answer request lines until the client disconnects."""
+        query_server: QueryServer = self.server.query_server
+        for raw in self.rfile:
+            line = raw.decode('utf-8', errors='replace').strip()
+            if not line:
+                continue
+            response = query_server.handle(line)
+            if response is not None:
+                self._send(response)
+            if query_server.shutdown_requested:
+                threading.Thread(target=self.server.shutdown, daemon=True).start()
+                return
+
+    def _send(self, response: str) -> None:
+        """Write one response line."""
+        self.wfile.write(response.encode('utf-8') + b'\n')
+        self.wfile.flush()
+
+
+class UnixQueryServer(socketserver.ThreadingMixIn, socketserver.UnixStreamServer):
+    """Serves a QueryServer on a Unix domain socket."""
+
+    daemon_threads = True
+
+    def __init__(self, socket_path: Path, query_server: QueryServer):
+        """Bind the socket (owner-only permissions), replacing a stale one."""
+        self.logger = logging.getLogger(__name__)
+        self.socket_path = socket_path
+        self.query_server = query_server
+        self._remove_stale_socket()
+        previous_umask = os.umask(0o177)
+        try:
+            super().__init__(str(socket_path), _RequestHandler)
+        finally:
+            os.umask(previous_umask)
+
+    def _remove_stale_socket(self) -> None:
+        """Delete a socket file left by a server that is no longer running."""
+        if not self.socket_path.exists():
+            return
+        probe = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            probe.connect(str(self.socket_path))
+        except OSError:
+            self.socket_path.unlink()
+            return
+        finally:
+            probe.close()
+        raise RuntimeError(f"A server is already listening on {self.socket_path}")
+
+    def server_close(self) -> None:
+        """Close the socket and remove its file."""
+        super().server_close()
+        try:
+            self.socket_path.unlink()
+        except FileNotFoundError:
+            pass
+
+
+def query(socket_path: Path, method: str, params: Dict[str, Any], timeout: float = 60.0) -> Tuple[Any, Any]:
+    """Send one request to a running server; returns (result, error)."""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as client:
+        client.settimeout(timeout)
+        client.connect(str(socket_path))
+        request = {'jsonrpc': '2.0', 'id': 1, 'method': method, 'params': params}
+        client.sendall(json.dumps(request).encode('utf-8') + b'\n')
+        response = b''
+        while not response.endswith(b'\n'):
+            chunk = client.recv(1 << 16)
+            if not chunk:
+                break
+            response += chunk
+    data = json.loads(response)
+    return data.get('result'), data.get('error')
@@ -0,0 +1,135 @@
+"""
+Run metrics module.
+
+Collects wall-clock time per phase (discovery, parse, diagnostics,
+traversal, each analysis pass, serialization), per-file timings, cursor
+counts and peak memory, so a slow run can be attributed to libclang or to
+the Python side. Results go to `metadata.performance` and optionally a CSV.
+"""
+
+import csv
+import ctypes
+import logging
+import os
+import sys
+import time
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Dict, List, Any, Optional
+
+try:
+    import resource
+except ImportError:  # not available on Windows
+    resource = None
+
+
+class RunMetrics:
+    """Accumulates phase and per-file timings for one analysis run."""
+
+    # Per-file phases in CSV column order; pass timings follow as pass_<name>
+    FILE_PHASES = ('parse', 'diagnostics', 'traversal', 'llvm_backend')
+
+    def __init__(self, slowest: int = 10):
+        """Initialize the collector; slowest is how many files the summary lists."""
+        self.slowest = slowest
+        self.logger = logging.getLogger(__name__)
+        self.phases: Dict[str, float] = {}
+        self.passes: Dict[str, float] = {}
+        self.files: List[Dict[str, Any]] = []
+        self.cursors_visited = 0
+        self.started = time.perf_counter()
+
+    @contextmanager
+    def phase(self, name: str):
+        """Add the wall time of the enclosed block to a run-level phase."""
+        started = time.perf_counter()
+        try:
+            yield
+        finally:
+            self.add(name, time.perf_counter() - started)
+
+    def add(self, name: str, seconds: float) -> None:
+        """Add seconds to a run-level phase."""
+        self.phases[name] = self.phases.get(name, 0.0) + seconds
+
+    def record_file(self, file_path: str, total: float, timings: Dict[str, float],
+                    pass_timings: Dict[str, float], cursors: int, loops: int) -> None:
+        """Record one analyzed file; its phase and pass timings also count towards the run totals."""
+        for name in self.FILE_PHASES:
+            self.add(name, timings.get(name, 0.0))
+        for name, seconds in pass_timings.items():
+            self.passes[name] = self.passes.get(name, 0.0) + seconds
+        self.cursors_visited += cursors
+        self.files.append({
+            'file': file_path,
+            'total': total,
+            'timings': {name: timings.get(name, 0.0) for name in self.FILE_PHASES},
+            'passes': dict(pass_timings),
+            'cursors': cursors,
+            'loops': loops,
+        })
+
+    def peak_rss_mb(self) -> Optional[float]:
+        """Peak resident set size of this process or its largest finished worker, if the platform reports it."""
+        if resource is None:
+            return None
+        peak = max(resource.getrusage(resource.RUSAGE_SELF).ru_maxrss,
+                   resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss)
+        # Linux reports kilobytes, macOS bytes
+        return round(peak / (1024 * 1024 if sys.platform == 'darwin' else 1024), 1)
+
+    @staticmethod
+    def current_rss_mb() -> Optional[float]:
+        """Current resident set size of this process (Linux only; None elsewhere)."""
+        try:
+            with open('/proc/self/statm', 'r') as f:
+                resident_pages = int(f.read().split()[1])
+            return resident_pages * os.sysconf('SC_PAGE_SIZE') / (1024 * 1024)
+        except (OSError, ValueError, IndexError):
+            return None
+
+    @staticmethod
+    def release_free_memory() -> None:
+        """Ask glibc to return freed heap pages to the OS, so RSS follows what is in use."""
+        if not sys.platform.startswith('linux'):
+            return
+        try:
+            ctypes.CDLL('libc.so.6').malloc_trim(0)
+        except (OSError, AttributeError):
+            pass
+
+    def summary(self) -> Dict[str, Any]:
+        """The `metadata.performance` section."""
+        slowest = sorted(self.files, key=lambda entry: entry['total'], reverse=True)[:self.slowest]
+        return {
+            'wall_seconds': round(time.perf_counter() - self.started, 3),
+            'phases': {name: round(seconds, 3) for name, seconds in self.phases.items()},
+            'passes': {name: round(seconds, 3) for name, seconds in self.passes.items()},
+            'files_timed': len(self.files),
+            'cursors_visited': self.cursors_visited,
+            'peak_rss_mb': self.peak_rss_mb(),
+            'slowest_files': [
+                {
+                    'file': entry['file'],
+                    'total': round(entry['total'], 3),
+                    **{name: round(seconds, 3) for name, seconds in entry['timings'].items()},
+                    'cursors': entry['cursors'],
+                }
+                for entry in slowest
+            ],
+        }
+
+    def write_csv(self, output_path: Path) -> None:
+        """Write one row per analyzed file."""
+        pass_names = sorted({name for entry in self.files for name in entry['passes']})
+        output_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(output_path, 'w', newline='', encoding='utf-8') as f:
+            writer = csv.writer(f)
+            writer.writerow(['file', 'total_seconds'] + [f'{name}_seconds' for name in self.FILE_PHASES] +
+                            [f'pass_{name}_seconds' for name in pass_names] + ['cursors', 'loops'])
+            for entry in self.files:
+                writer.writerow([entry['file'], f"{entry['total']:.6f}"] +
+                                [f"{entry['timings'][name]:.6f}" for name in self.FILE_PHASES] +
+                                [f"{entry['passes'].get(name, 0.0):.6f}" for name in pass_names] +
+                                [entry['cursors'], entry['loops']])
+        self.logger.info(f"Per-file timings written to: {output_path}")
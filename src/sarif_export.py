@@ -0,0 +1,154 @@
+"""
+SARIF export module.
+
+Writes the performance findings attached to loop records as a SARIF 2.1.0
+log, so editors and code-review tools can show them inline. Each result
+points at the offending construct and lists the enclosing loop as a related
+location; both regions come from the analyzer's location fields.
+"""
+
+import hashlib
+import json
+import logging
+import os
+from pathlib import Path
+from typing import Dict, List, Any, Optional
+
+from . import __version__
+from .loop_index import LoopIndex
+from .perf_findings import LoopFindingDetector
+
+
+class SarifExporter:
+    """Converts `extensions.findings` of an analysis into a SARIF log."""
+
+    SCHEMA = 'https://json.schemastore.org/sarif-2.1.0.json'
+    TOOL_NAME = 'loop-extractor'
+
+    def __init__(self, base_dir: Optional[Path] = None):
+        """Initialize the exporter; artifact URIs are made relative to base_dir (default: cwd)."""
+        self.base_dir = (base_dir or Path.cwd()).resolve()
+        self.logger = logging.getLogger(__name__)
+
+    def export(self, analysis_results: Dict[str, Any], output_path: Path) -> Dict[str, Any]:
+        """Write the SARIF log for an annotated analysis; returns a run summary."""
+        log = self.build(analysis_results)
+        output_path.parent.mkdir(parents=True, exist_ok=True)
+        with open(output_path, 'w', encoding='utf-8') as f:
+            json.dump(log, f, indent=2)
+            f.write('\n')
+
+        results = log['runs'][0]['results']
+        counts = {rule_id: 0 for rule_id in sorted(LoopFindingDetector.RULES)}
+        for result in results:
+            counts[result['ruleId']] += 1
+        self.logger.info(f"Wrote {len(results)} SARIF results to {output_path}")
+        return {'output': str(output_path), 'results': len(results), 'by_rule': counts}
+
+    def build(self, analysis_results: Dict[str, Any]) -> Dict[str, Any]:
+        """Return the SARIF log as a dictionary."""
+        rule_ids = sorted(LoopFindingDetector.RULES)
+        results = []
+        seen = set()
+        for file_path, function_name, loop in LoopIndex(analysis_results).iter_loops():
+            location = loop.get('location', {})
+            key = (file_path, location.get('start_line', 0), location.get('start_column', 0))
+            if key in seen:
+                # Nested loops are also reported at function level
+                continue
+            seen.add(key)
+            for finding in loop.get('extensions', {}).get('findings', []):
+                results.append(self._result(finding, file_path, function_name, loop, rule_ids))
+
+        results.sort(key=lambda result: (
+            result['locations'][0]['physicalLocation']['artifactLocation']['uri'],
+            result['locations'][0]['physicalLocation']['region']['startLine'],
+            result['locations'][0]['physicalLocation']['region']['startColumn'],
+            result['ruleId'],
+        ))
+
+        return {
+            '$schema': self.SCHEMA,
+            'version': '2.1.0',
+            'runs': [{
+                'tool': {
+                    'driver': {
+                        'name': self.TOOL_NAME,
+                        'version': __version__,
+                        'rules': [self._rule(rule_id) for rule_id in rule_ids],
+                    },
+                },
+                'originalUriBaseIds': {
+                    'SRCROOT': {'uri': self.base_dir.as_uri() + '/'},
+                },
+                'results': results,
+            }],
+        }
+
+    def _rule(self, rule_id: str) -> Dict[str, Any]:
+        """reportingDescriptor of one rule."""
+        rule = LoopFindingDetector.RULES[rule_id]
+        return {
+            'id': rule_id,
+            'name': rule['name'],
+            'shortDescription': {'text': rule['short']},
+            'fullDescription': {'text': rule['full']},
+            'defaultConfiguration': {'level': rule['level']},
+            'properties': {'tags': ['performance']},
+        }
+
+    def _result(self, finding: Dict[str, Any], file_path: str, function_name: str,
+                loop: Dict[str, Any], rule_ids: List[str]) -> Dict[str, Any]:
+        """SARIF result of one finding, with the enclosing loop as related location."""
+        rule_id = finding['rule_id']
+        artifact = self._artifact(file_path)
+        loop_id = loop.get('loop_id', '')
+        physical = {'artifactLocation': artifact, 'region': self._region(finding['location'])}
+
+        result = {
+            'ruleId': rule_id,
+            'ruleIndex': rule_ids.index(rule_id),
+            'level': LoopFindingDetector.RULES[rule_id]['level'],
+            'message': {'text': f"{finding['message']} ({loop_id})"},
+            'locations': [{'physicalLocation': physical}],
+            'relatedLocations': [{
+                'id': 1,
+                'physicalLocation': {'artifactLocation': artifact, 'region': self._region(loop.get('location', {}))},
+                'message': {'text': f"enclosing {loop.get('type', 'loop').replace('_', ' ')} {loop_id}"},
+            }],
+            # Line-independent, so findings survive unrelated edits above them
+            'partialFingerprints': {
+                'loopFindingHash/v1': self._fingerprint(rule_id, artifact['uri'], function_name, finding['message']),
+            },
+            'properties': {
+                'loopId': loop_id,
+                'nestingLevel': loop.get('nesting_level', 0),
+            },
+        }
+        if function_name:
+            result['locations'][0]['logicalLocations'] = [{'fullyQualifiedName': function_name, 'kind': 'function'}]
+        return result
+
+    def _region(self, location: Dict[str, Any]) -> Dict[str, int]:
+        """SARIF region from the analyzer's 1-based line/column fields (end column is exclusive in both)."""
+        region = {
+            'startLine': max(1, location.get('start_line', 1)),
+            'startColumn': max(1, location.get('start_column', 1)),
+        }
+        if location.get('end_line'):
+            region['endLine'] = location['end_line']
+        if location.get('end_column'):
+            region['endColumn'] = location['end_column']
+        return region
+
+    def _artifact(self, file_path: str) -> Dict[str, str]:
+        """artifactLocation relative to SRCROOT when the file lies below it, else an absolute URI."""
+        resolved = Path(file_path).resolve()
+        relative = os.path.relpath(resolved, self.base_dir)
+        if not relative.startswith('..'):
+            return {'uri': Path(relative).as_posix(), 'uriBaseId': 'SRCROOT'}
+        return {'uri': resolved.as_uri()}
+
+    def _fingerprint(self, *parts: str) -> str:
+        """Stable hash of the identifying parts of a result."""
+        return hashlib.sha256('\0'.join(parts).encode('utf-8')).hexdigest()[:32]
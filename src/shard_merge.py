@@ -0,0 +1,105 @@
+"""
+Merging of sharded analysis runs.
+
+A large tree can be split over several machines with `--shard K/N`; every
+node writes the analysis of its own files. Merging unions the source file
+entries and regenerates everything derived from the whole tree (loop
+totals, the analysis summary and the call graph) so calls from a function
+in one shard to a function in another resolve as in a single-node run.
+"""
+
+import logging
+from datetime import datetime
+from pathlib import Path
+from typing import Dict, List, Any, Tuple
+
+from .config import Config
+from .json_output import JSONOutput
+from .loop_analyzer import LoopAnalyzer
+
+
+class ShardMerger:
+    """Combines the analysis files of a sharded run into one analysis."""
+
+    def __init__(self, config: Config):
+        """Initialize the merger; config comes from the first shard's metadata."""
+        self.config = config
+        self.logger = logging.getLogger(__name__)
+
+    def merge(self, shards: List[Tuple[str, Dict[str, Any]]]) -> Dict[str, Any]:
+        """Merge (input path, analysis data) pairs into a single analysis."""
+        if not shards:
+            raise ValueError("No analysis files to merge")
+        self.check_shards(shards)
+
+        source_files: Dict[str, Any] = {}
+        shard_records = []
+        for input_path, data in shards:
+            metadata = data.get('metadata', {})
+            files = data.get('source_files', {})
+            for file_path, file_data in files.items():
+                if file_path in source_files:
+                    self.logger.warning(f"{file_path} appears in more than one input; keeping the first")
+                    continue
+                source_files[file_path] = file_data
+            shard_records.append({
+                'input': input_path,
+                'shard': metadata.get('shard'),
+                'files': len(files),
+                'analysis_duration_seconds': metadata.get('analysis_duration_seconds', 0.0),
+                'interrupted': bool(metadata.get('interrupted', False)),
+            })
+
+        # Shards finish in any order; path order makes the merged file reproducible
+        source_files = dict(sorted(source_files.items()))
+        total_loops = sum(LoopAnalyzer.count_loops(file_data) for file_data in source_files.values())
+
+        json_output = JSONOutput(self.config)
+        output_data = json_output.generate_output(
+            analysis_results=source_files,
+            source_files=[Path(file_path) for file_path in source_files],
+            total_loops=total_loops,
+            start_time=datetime.now()
+        )
+
+        # Describe the run that produced the shards, not the machine doing the merge
+        first_metadata = shards[0][1].get('metadata', {})
+        metadata = output_data['metadata']
+        for key in ('scan_path', 'compiler_flags', 'passes'):
+            if key in first_metadata:
+                metadata[key] = first_metadata[key]
+        metadata['analysis_duration_seconds'] = max(
+            record['analysis_duration_seconds'] for record in shard_records)
+        metadata['shards'] = shard_records
+        if any(record['interrupted'] for record in shard_records):
+            metadata['interrupted'] = True
+
+        self.logger.info(f"Merged {len(shards)} analyses: {len(source_files)} files, {total_loops} loops")
+        return output_data
+
+    def check_shards(self, shards: List[Tuple[str, Dict[str, Any]]]) -> List[str]:
+        """Warn about inputs that do not form one complete sharded run; returns the warnings."""
+        warnings = []
+        scan_paths = {data.get('metadata', {}).get('scan_path') for _, data in shards}
+        if len(scan_paths) > 1:
+            warnings.append(f"Inputs analyzed different paths: {', '.join(sorted(map(str, scan_paths)))}")
+
+        shard_info = [data.get('metadata', {}).get('shard') for _, data in shards]
+        declared = [info for info in shard_info if info]
+        if declared:
+            counts = {info['count'] for info in declared}
+            if len(counts) > 1 or len(declared) != len(shards):
+                warnings.append("Inputs come from runs with different --shard counts")
+            else:
+                count = counts.pop()
+                indices = [info['index'] for info in declared]
+                missing = sorted(set(range(1, count + 1)) - set(indices))
+                duplicated = sorted({index for index in indices if indices.count(index) > 1})
+                if missing:
+                    warnings.append(f"Missing shards {', '.join(f'{index}/{count}' for index in missing)}")
+                if duplicated:
+                    warnings.append(f"Shards given more than once: {', '.join(map(str, duplicated))}")
+
+        for warning in warnings:
+            self.logger.warning(warning)
+        return warnings
@@ -0,0 +1,336 @@
+"""
+Watch mode: incremental re-analysis while the source tree is edited.
+
+After one full analysis the session keeps the clang index, the analysis
+of every file and the include dependencies of every translation unit in
+memory. File system events (inotify on Linux, periodic mtime rescans
+elsewhere) trigger re-analysis of the changed files and of every file
+that includes a changed header; the output is updated per file by
+IncrementalOutput and rewritten atomically after each batch.
+"""
+
+import ctypes
+import ctypes.util
+import errno
+import logging
+import os
+import select
+import struct
+import time
+from datetime import datetime
+from pathlib import Path
+from typing import Dict, Any, Optional, Set
+
+from .config import Config
+from .file_discovery import FileDiscovery
+from .ast_parser import ASTParser
+from .loop_analyzer import LoopAnalyzer
+from .incremental_output import IncrementalOutput
+from .json_output import JSONOutput
+
+
+class InotifyWatcher:
+    """Recursive watch of a directory tree through the Linux inotify API."""
+
+    IN_MODIFY = 0x2
+    IN_CLOSE_WRITE = 0x8
+    IN_MOVED_FROM = 0x40
+    IN_MOVED_TO = 0x80
+    IN_CREATE = 0x100
+    IN_DELETE = 0x200
+    IN_Q_OVERFLOW = 0x4000
+    IN_IGNORED = 0x8000
+    IN_ISDIR = 0x40000000
+    IN_NONBLOCK = 0o4000
+    IN_CLOEXEC = 0o2000000
+    WATCH_MASK = IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE
+    EVENT_HEADER = struct.Struct('iIII')
+
+    def __init__(self, file_discovery: FileDiscovery):
+        """Open an inotify instance; raises OSError where inotify is unavailable."""
+        self.file_discovery = file_discovery
+        self.logger = logging.getLogger(__name__)
+        self._libc = ctypes.CDLL(ctypes.util.find_library('c'), use_errno=True)
+        if not hasattr(self._libc, 'inotify_init1'):
+            raise OSError(errno.ENOSYS, "inotify is not available on this platform")
+        self._fd = self._libc.inotify_init1(self.IN_NONBLOCK | self.IN_CLOEXEC)
+        if self._fd < 0:
+            raise OSError(ctypes.get_errno(), os.strerror(ctypes.get_errno()))
+        self._directories: Dict[int, str] = {}
+
+    def add_tree(self, directory: str, relative: str = '') -> None:
+        """Watch a directory and its subdirectories, skipping those discovery skips."""
+        pending = [(directory, relative)]
+        while pending:
+            current, current_relative = pending.pop()
+            wd = self._libc.inotify_add_watch(self._fd, os.fsencode(current), self.WATCH_MASK)
+            if wd < 0:
+                error = ctypes.get_errno()
+                if error == errno.ENOSPC:
+                    raise OSError(error, "inotify watch limit reached (fs.inotify.max_user_watches)")
+                continue
+            self._directories[wd] = current
+            try:
+                with os.scandir(current) as entries:
+                    for entry in entries:
+                        entry_relative = f"{current_relative}/{entry.name}" if current_relative else entry.name
+                        if entry.is_dir(follow_symlinks=False) and \
+                                not self.file_discovery._should_skip_directory(entry.name, entry.path, entry_relative):
+                            pending.append((entry.path, entry_relative))
+            except OSError as e:
+                self.logger.debug(f"Cannot watch below {current}: {e}")
+        self.logger.debug(f"Watching {len(self._directories)} directories")
+
+    def read(self, timeout: float) -> Optional[Set[str]]:
+        """Changed file paths within timeout seconds; None when the tree must be rescanned."""
+        readable, _, _ = select.select([self._fd], [], [], timeout)
+        if not readable:
+            return set()
+        try:
+            buffer = os.read(self._fd, 1 << 16)
+        except BlockingIOError:
+            return set()
+
+        changed: Set[str] = set()
+        rescan = False
+        offset = 0
+        while offset < len(buffer):
+            wd, mask, _, name_length = self.EVENT_HEADER.unpack_from(buffer, offset)
+            offset += self.EVENT_HEADER.size
+            name = os.fsdecode(buffer[offset:offset + name_length].split(b'\0', 1)[0])
+            offset += name_length
+
+            if mask & self.IN_Q_OVERFLOW:
+                rescan = True
+            elif mask & self.IN_IGNORED:
+                self._directories.pop(wd, None)
+            elif wd in self._directories:
+                path = os.path.join(self._directories[wd], name)
+                if mask & self.IN_ISDIR:
+                    # Files created or moved with a directory produce no events of their own
+                    if mask & (self.IN_CREATE | self.IN_MOVED_TO):
+                        root = str(self.file_discovery.config.source_path.resolve())
+                        self.add_tree(path, os.path.relpath(path, root).replace(os.sep, '/'))
+                    rescan = True
+                else:
+                    changed.add(path)
+        return None if rescan else changed
+
+    def close(self) -> None:
+        """Release the inotify instance and its watches."""
+        if self._fd >= 0:
+            os.close(self._fd)
+            self._fd = -1
+
+
+class PollingWatcher:
+    """Fallback without inotify: asks for a rescan of the tree every interval."""
+
+    def __init__(self, interval: float):
+        """Initialize with the rescan interval in seconds."""
+        self.interval = interval
+
+    def read(self, timeout: float) -> Optional[Set[str]]:
+        """Wait for the next rescan; within a debounce window nothing new is reported."""
+        if timeout < self.interval:
+            time.sleep(timeout)
+            return set()
+        time.sleep(self.interval)
+        return None
+
+    def close(self) -> None:
+        """Nothing to release."""
+
+
+class WatchSession:
+    """Keeps a warm analysis of a tree and updates it as files change."""
+
+    def __init__(self, config: Config, output_path: Path, debounce: float = 0.3,
+                 poll_interval: float = 2.0, use_inotify: bool = True):
+        """Initialize the session; analysis starts with run()."""
+        self.config = config
+        self.output_path = output_path
+        self.debounce = debounce
+        self.poll_interval = poll_interval
+        self.use_inotify = use_inotify
+        self.logger = logging.getLogger(__name__)
+
+        self.root = str(config.source_path.resolve())
+        self.file_discovery = FileDiscovery(config)
+        # One parser and index for the whole session, recycled by ASTParser.dispose
+        self.ast_parser = ASTParser(config)
+        self.loop_analyzer = LoopAnalyzer(config, self.ast_parser)
+        self.json_output = JSONOutput(config)
+        self.output: Optional[IncrementalOutput] = None
+
+        # Keys are absolute normalized paths; output keys stay as discovery names them
+        self.output_keys: Dict[str, str] = {}
+        self.mtimes: Dict[str, int] = {}
+        self.includes: Dict[str, Set[str]] = {}
+        self.dependents: Dict[str, Set[str]] = {}
+        self.updates = 0
+
+    def run(self) -> None:
+        """Analyze the tree, then re-analyze changed files until interrupted."""
+        start_time = datetime.now()
+        watcher = self._create_watcher()
+        files = self.file_discovery.discover_files()
+        self.logger.info(f"Initial analysis of {len(files)} files...")
+
+        analysis_results = {}
+        for file_path in files:
+            path = self._normalize(str(file_path))
+            self.output_keys[path] = str(file_path)
+            file_data = self._analyze(path)
+            if file_data is not None:
+                analysis_results[str(file_path)] = file_data
+        self.output = IncrementalOutput(self.config, analysis_results, start_time,
+                                        order_key=self.file_discovery.order_key)
+        self._write({'updates': 0})
+        self.logger.info(f"Watching {self.root} ({self.output.total_loops} loops); press Ctrl+C to stop")
+
+        try:
+            while True:
+                changed = watcher.read(3600.0)
+                if changed is not None and not changed:
+                    continue
+                # Let a burst of saves (editor swap files, git checkout) settle into one batch
+                while True:
+                    more = watcher.read(self.debounce)
+                    if more is not None and not more:
+                        break
+                    changed = None if more is None or changed is None else changed | more
+                self._apply(self._rescan() if changed is None else changed)
+        finally:
+            watcher.close()
+
+    def _create_watcher(self):
+        """inotify on the tree when available, otherwise periodic rescans."""
+        if self.use_inotify:
+            try:
+                watcher = InotifyWatcher(self.file_discovery)
+                watcher.add_tree(self.root)
+                return watcher
+            except OSError as e:
+                self.logger.warning(f"inotify unavailable ({e.strerror or e}); rescanning every {self.poll_interval:g}s")
+        return PollingWatcher(self.poll_interval)
+
+    def _apply(self, changed: Set[str]) -> None:
+        """Re-analyze changed files and their dependents and rewrite the output."""
+        started = time.perf_counter()
+        loops_before = self.output.total_loops
+        to_analyze: Set[str] = set()
+        removed: Set[str] = set()
+        for path in map(self._normalize, changed):
+            exists = os.path.isfile(path)
+            if path in self.output_keys:
+                (to_analyze if exists else removed).add(path)
+            elif exists and self.file_discovery.is_source_file(Path(path)):
+                self.output_keys[path] = os.path.join(str(self.config.source_path), os.path.relpath(path, self.root))
+                to_analyze.add(path)
+            # A changed or deleted header invalidates every unit that included it
+            to_analyze |= {dependent for dependent in self.dependents.get(path, ())
+                           if dependent in self.output_keys and os.path.isfile(dependent)}
+        to_analyze -= removed
+        if not to_analyze and not removed:
+            return
+
+        removed_keys = []
+        for path in sorted(removed):
+            self._forget(path)
+            removed_keys.append(self.output_keys.pop(path))
+            self.output.update(removed_keys[-1], None)
+        for path in sorted(to_analyze):
+            file_data = self._analyze(path)
+            if file_data is not None:
+                self.output.update(self.output_keys[path], file_data)
+
+        self.updates += 1
+        seconds = time.perf_counter() - started
+        directly = len(to_analyze & set(map(self._normalize, changed)))
+        self._write({
+            'updates': self.updates,
+            'last_update': datetime.now().isoformat(),
+            'last_update_seconds': round(seconds, 3),
+            'last_analyzed_files': sorted(self.output_keys[path] for path in to_analyze),
+            'last_removed_files': removed_keys,
+        })
+        delta = self.output.total_loops - loops_before
+        self.logger.info(f"Re-analyzed {len(to_analyze)} files ({directly} changed, "
+                         f"{len(to_analyze) - directly} including a changed header), removed {len(removed)} "
+                         f"in {seconds:.2f}s; {self.output.total_loops} loops ({delta:+d})")
+
+    def _analyze(self, path: str) -> Optional[Dict[str, Any]]:
+        """Parse and analyze one file and record its includes; None keeps the previous result."""
+        key = self.output_keys[path]
+        try:
+            self.mtimes[path] = os.stat(path).st_mtime_ns
+        except OSError:
+            return None
+        translation_unit = self.ast_parser.parse_file(Path(key))
+        if translation_unit is None:
+            self.logger.warning(f"Failed to parse {key}; keeping its previous analysis")
+            return None
+        try:
+            file_data = self.loop_analyzer.analyze_file(translation_unit, Path(key))
+            self._record_includes(path, translation_unit)
+        finally:
+            self.ast_parser.dispose(translation_unit)
+        return file_data
+
+    def _record_includes(self, path: str, translation_unit) -> None:
+        """Replace the recorded headers (direct and transitive) a unit includes from the tree."""
+        headers = set()
+        prefix = self.root + os.sep
+        for inclusion in translation_unit.get_includes():
+            header = self._normalize(inclusion.include.name)
+            if header.startswith(prefix):
+                headers.add(header)
+                # The version of the header this analysis saw, for rescans
+                if header not in self.output_keys:
+                    try:
+                        self.mtimes[header] = os.stat(header).st_mtime_ns
+                    except OSError:
+                        pass
+        self._forget(path)
+        self.includes[path] = headers
+        for header in headers:
+            self.dependents.setdefault(header, set()).add(path)
+
+    def _forget(self, path: str) -> None:
+        """Drop the include edges of a unit."""
+        for header in self.includes.pop(path, ()):
+            self.dependents[header].discard(path)
+
+    def _rescan(self) -> Set[str]:
+        """Changed, new and deleted files found by comparing discovery with recorded mtimes."""
+        changed = set()
+        current = set()
+        for file_path in self.file_discovery.discover_files():
+            path = self._normalize(str(file_path))
+            current.add(path)
+            try:
+                if os.stat(path).st_mtime_ns != self.mtimes.get(path):
+                    changed.add(path)
+            except OSError:
+                continue
+        # Headers outside the discovered set are still tracked through their dependents
+        for header, dependents in self.dependents.items():
+            if dependents and header not in current:
+                try:
+                    if os.stat(header).st_mtime_ns != self.mtimes.get(header):
+                        changed.add(header)
+                except OSError:
+                    changed.add(header)
+        return changed | (set(self.output_keys) - current)
+
+    def _write(self, watch_info: Dict[str, Any]) -> None:
+        """Write the output through a temporary file, so readers never see a partial file."""
+        self.output.output_data['metadata']['watch'] = watch_info
+        temporary = self.output_path.with_name(self.output_path.name + '.tmp')
+        self.json_output.write_output(self.output.output_data, str(temporary))
+        os.replace(temporary, self.output_path)
+
+    def _normalize(self, path: str) -> str:
+        """Absolute normalized path used to match events, includes and files."""
+        return os.path.normpath(os.path.abspath(path))
@@ -0,0 +1,106 @@
+"""
+Work scheduling for parallel and sharded runs.
+
+Orders files by estimated analysis cost, largest first, so the longest
+files start early and a parallel run does not end with one worker grinding
+through a big file while the others are idle. The same estimates split a
+file list into cost-balanced shards for runs spread over several machines.
+Costs come from the timings of a previous run when available, otherwise
+from file size scaled by the seconds-per-byte observed in that history.
+"""
+
+import csv
+import json
+import logging
+import statistics
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from .config import Config
+from .file_discovery import FileDiscovery
+
+
+class WorkScheduler:
+    """Estimates per-file cost, orders files largest-first and splits them into shards."""
+
+    def __init__(self, config: Config, history_path: Optional[Path] = None):
+        """Initialize the scheduler; history_path is a --timings-csv file or a previous analysis JSON."""
+        self.config = config
+        self.logger = logging.getLogger(__name__)
+        self.file_discovery = FileDiscovery(config)
+        self.history: Dict[str, float] = self.load_history(history_path) if history_path else {}
+
+    def load_history(self, history_path: Path) -> Dict[str, float]:
+        """Per-file seconds keyed by resolved path."""
+        history: Dict[str, float] = {}
+        if history_path.suffix == '.csv':
+            with open(history_path, 'r', encoding='utf-8', newline='') as f:
+                for row in csv.DictReader(f):
+                    history[self._key(row['file'])] = float(row['total_seconds'])
+        else:
+            with open(history_path, 'r', encoding='utf-8') as f:
+                data = json.load(f)
+            # Only the slowest files are kept in metadata.performance; the rest fall back to size
+            for entry in data.get('metadata', {}).get('performance', {}).get('slowest_files', []):
+                history[self._key(entry['file'])] = float(entry['total'])
+            # Files killed for exceeding their budget are as expensive as the budget
+            for file_path, file_data in data.get('source_files', {}).items():
+                seconds = file_data.get('file_info', {}).get('seconds')
+                if seconds is not None:
+                    history[self._key(file_path)] = float(seconds)
+        self.logger.info(f"Loaded timings of {len(history)} files from {history_path}")
+        return history
+
+    def estimate(self, files: List[Path]) -> Dict[Path, float]:
+        """Estimated seconds (or relative cost without history) per file."""
+        sizes = {file_path: self.file_discovery.get_file_info(file_path)['size_bytes'] for file_path in files}
+        known = {file_path: self.history[self._key(file_path)] for file_path in files
+                 if self._key(file_path) in self.history}
+
+        rates = [seconds / sizes[file_path] for file_path, seconds in known.items() if sizes[file_path]]
+        seconds_per_byte = statistics.median(rates) if rates else 1.0
+        return {file_path: known.get(file_path, sizes[file_path] * seconds_per_byte) for file_path in files}
+
+    def order(self, files: List[Path]) -> List[Path]:
+        """Files sorted by estimated cost, most expensive first; ties keep discovery order."""
+        costs = self.estimate(files)
+        ordered = sorted(files, key=lambda file_path: -costs[file_path])
+        if ordered:
+            head = ', '.join(f"{file_path.name} ({costs[file_path]:.3g})" for file_path in ordered[:3])
+            self.logger.info(f"Scheduling {len(ordered)} files largest-first: {head}, ...")
+        return ordered
+
+    def shard(self, files: List[Path], index: int, count: int) -> List[Path]:
+        """Files of shard index (1-based) of count, balanced by estimated cost.
+
+        Files are assigned largest-first to the least loaded shard, with ties
+        broken by path relative to the scan root, so every node computes the
+        same partition from the same checkout and history.
+        """
+        if not 1 <= index <= count:
+            raise ValueError(f"Shard {index}/{count} is out of range")
+        costs = self.estimate(files)
+        relative = {file_path: self._relative(file_path) for file_path in files}
+        loads = [0.0] * count
+        selected = []
+        for file_path in sorted(files, key=lambda file_path: (-costs[file_path], relative[file_path])):
+            target = min(range(count), key=lambda shard: (loads[shard], shard))
+            loads[target] += costs[file_path]
+            if target == index - 1:
+                selected.append(file_path)
+        self.logger.info(f"Shard {index}/{count}: {len(selected)} of {len(files)} files "
+                         f"({loads[index - 1]:.3g} of {sum(loads):.3g} estimated cost)")
+        # Keep discovery order within the shard
+        chosen = set(selected)
+        return [file_path for file_path in files if file_path in chosen]
+
+    def _relative(self, file_path: Path) -> str:
+        """Path relative to the scan root, the same on every node."""
+        try:
+            return file_path.resolve().relative_to(self.config.source_path.resolve()).as_posix()
+        except ValueError:
+            return file_path.as_posix()
+
+    def _key(self, file_path) -> str:
+        """History key of a path, independent of how the run was invoked."""
+        return str(Path(file_path).resolve())
@@ -0,0 +1,49 @@
+// Calls and overlapping arrays in loops checked by the OpenMP rewriter (openmp_rewriter.py)
+
+// A user function named like a libm one is not pure: it updates a counter
+double log(const char *message) {
+    static int calls = 0;
+    calls++;
+    return calls + message[0];
+}
+
+void logged_copy(double *a, const double *b, int n) {
+    for (int i = 0; i < n; i++) {
+        a[i] = b[i] + log("copy");
+    }
+}
+
+double buffer[100];
+double *shifted = buffer + 1;
+
+// shifted points into buffer: each iteration reads what the previous one wrote
+void array_to_pointer() {
+    for (int i = 0; i < 99; i++) {
+        shifted[i] = buffer[i];
+    }
+}
+
+// p may point into buffer: proposed, with the overlap left for the reviewer to confirm
+void copy_from_buffer(double *p) {
+    for (int i = 0; i < 100; i++) {
+        p[i] = buffer[i];
+    }
+}
+
+// b is a + 1, visibly aliasing within the function
+void local_pointer_offset(double *a, int n) {
+    double *b = a + 1;
+    for (int i = 0; i < n - 1; i++) {
+        b[i] = a[i];
+    }
+}
+
+// Distinct arrays: no overlap to assume
+double left[2000];
+double right[2000];
+
+void distinct_arrays() {
+    for (int i = 0; i < 2000; i++) {
+        left[i] = right[i] * 2.0;
+    }
+}
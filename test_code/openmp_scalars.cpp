@@ -0,0 +1,71 @@
+// Shared scalars in loops checked by the OpenMP rewriter (openmp_rewriter.py)
+
+double g;
+
+// s is read before it is written in the same statement: a recurrence, not parallel
+double recurrence(const double *a, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) {
+        s = s * 0.5 + a[i];
+    }
+    return s;
+}
+
+// A global written before it is read outlives the loop: lastprivate, not private
+void global_temporary(double *a, int n) {
+    for (int i = 0; i < n; i++) {
+        g = i;
+        a[i] = g;
+    }
+}
+
+// Written through a reference parameter: the caller sees the last value
+void reference_temporary(double *a, double &last, int n) {
+    for (int i = 0; i < n; i++) {
+        last = a[i];
+        a[i] = last * 2.0;
+    }
+}
+
+// A local temporary not read after the loop is private
+void local_temporary(double *a, const double *b, int n) {
+    double t;
+    for (int i = 0; i < n; i++) {
+        t = b[i] * 2.0;
+        a[i] = t;
+    }
+}
+
+// A sum is a reduction
+double sum(const double *a, int n) {
+    double s = 0.0;
+    for (int i = 0; i < n; i++) {
+        s += a[i];
+    }
+    return s;
+}
+
+void use(double value);
+
+// t is read by the enclosing loop before the inner loop runs again: lastprivate, not private
+void enclosing_read(const double *x, double *y, int m, int n) {
+    double t = 0.0;
+    for (int k = 0; k < m; k++) {
+        use(t);
+        for (int i = 0; i < n; i++) {
+            t = x[i];
+            y[i] = t * 2.0;
+        }
+    }
+}
+
+// Iterations that continue skip the assignment, so the last iteration need not set t
+double continue_before_assignment(const int *c, const double *x, double *y, int n) {
+    double t = 0.0;
+    for (int i = 0; i < n; i++) {
+        if (c[i]) continue;
+        t = x[i];
+        y[i] = t;
+    }
+    return t;
+}